@@ -0,0 +1,11 @@
+#include "bench.hpp"
+
+#include <cstdio>
+
+bool Bench::Check(bool ok, const char *what) {
+    if (!ok) {
+        printf("FAILED: %s\n", what);
+        ++failures;
+    }
+    return ok;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// benchmarks of the code that doesn't need a window, together with checks of what it computes
+// every benchmark is also a test: ctest runs it with small sizes and it fails when a check fails
+struct Bench {
+    bool quick = false; // small sizes and a single repetition
+    size_t failures = 0;
+
+    // n, or the smaller quick_n in quick mode
+    size_t Size(size_t n, size_t quick_n) const {
+        return quick ? quick_n : n;
+    }
+
+    // failed check is printed and counted, returns ok
+    bool Check(bool ok, const char *what);
+
+    // seconds of the fastest of repeats runs of func, func runs once in quick mode
+    template <typename Func>
+    double Time(Func &&func, int repeats=3) {
+        double best = 0;
+        for (int i = 0; i < (quick ? 1 : repeats); ++i) {
+            double start = Now();
+            func();
+            double elapsed = Now() - start;
+            best = i == 0 ? elapsed : (elapsed < best ? elapsed : best);
+        }
+        return best;
+    }
+
+    // seconds of steady clock, GetTime() of raylib only works with a window
+    static double Now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+void BenchBezier(Bench &bench);
+void BenchTessellation(Bench &bench);
+void BenchConvexHull(Bench &bench);
+void BenchPolygonBoolean(Bench &bench);
+void BenchStroker(Bench &bench);
+void BenchPointLocation(Bench &bench);
+void BenchDelaunay(Bench &bench);
+void BenchMemory(Bench &bench);
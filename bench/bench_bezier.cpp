@@ -0,0 +1,96 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <memory_resource>
+
+#include "geometry/bezier.hpp"
+#include "memory/allocation_counter.hpp"
+
+namespace {
+
+// de Casteljau in doubles
+Point Reference(const std::pmr::deque<Point> &control_points, double t) {
+    std::vector<double> x, y;
+    for (Point p : control_points) {
+        x.push_back(p.x);
+        y.push_back(p.y);
+    }
+    for (size_t n = x.size(); n > 1; --n) {
+        for (size_t i = 0; i + 1 < n; ++i) {
+            x[i] += (x[i + 1] - x[i]) * t;
+            y[i] += (y[i + 1] - y[i]) * t;
+        }
+    }
+    return Point { (float) x[0], (float) y[0] };
+}
+
+float MaxError(const std::pmr::deque<Point> &control_points, const std::pmr::vector<Point> &points) {
+    float error = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        Point expected = Reference(control_points, (double) i / (double) (points.size() - 1));
+        error = std::max(error, Vector2Distance(points[i], expected));
+    }
+    return error;
+}
+
+} // namespace
+
+// tessellation of one curve of every order with Bezier<Order> against the std::function of BezierFunc
+void BenchBezier(Bench &bench) {
+    const int segments = 1000;
+    const size_t rounds = bench.Size(2000, 20);
+    // control points are within 1000 px, single precision loses about this much at high orders
+    const float tolerance = 0.05f;
+
+    std::mt19937 rng(27);
+    std::uniform_real_distribution<float> coordinate(0, 1000);
+
+    for (size_t order = 1; order <= MAX_STATIC_BEZIER_ORDER; ++order) {
+        std::pmr::deque<Point> control_points;
+        for (size_t i = 0; i <= order; ++i) {
+            control_points.push_back({ coordinate(rng), coordinate(rng) });
+        }
+
+        // the std::function is made for every update of a curve, like BezierCurve::Update() did
+        std::pmr::vector<Point> function_points;
+        AllocationCounters function_start = GetAllocationCounters();
+        double function_time = bench.Time([&] {
+            for (size_t round = 0; round < rounds; ++round) {
+                auto func = BezierFunc(control_points);
+                function_points.clear();
+                for (int i = 0; i <= segments; ++i) {
+                    function_points.push_back(func((float) i / segments));
+                }
+            }
+        });
+        AllocationCounters function_allocations = GetAllocationCounters() - function_start;
+
+        std::pmr::vector<Point> static_points;
+        VisitBezier(control_points, [&](const auto &bezier) { bezier.EvaluateUniform(segments, static_points); });
+
+        AllocationCounters static_start = GetAllocationCounters();
+        double static_time = bench.Time([&] {
+            for (size_t round = 0; round < rounds; ++round) {
+                VisitBezier(control_points, [&](const auto &bezier) { bezier.EvaluateUniform(segments, static_points); });
+            }
+        });
+        AllocationCounters static_allocations = GetAllocationCounters() - static_start;
+
+        float function_error = MaxError(control_points, function_points);
+        float static_error   = MaxError(control_points, static_points);
+
+        double points = (double) rounds * (segments + 1);
+        printf("order %2zu: std::function %6.2f ns/point (%zu allocations), Bezier<%zu> %5.2f ns/point (%zu allocations); "
+               "max error %.4f px and %.4f px\n",
+               order, function_time / points * 1e9, function_allocations.allocations,
+               order, static_time / points * 1e9, static_allocations.allocations,
+               function_error, static_error);
+
+        bench.Check(static_allocations.allocations == 0, "Bezier<Order> evaluation doesn't allocate");
+        bench.Check(static_error < tolerance, "Bezier<Order> is on the curve");
+        bench.Check(function_error < tolerance, "BezierFunc is on the curve");
+    }
+}
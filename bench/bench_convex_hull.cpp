@@ -0,0 +1,224 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "geometry/convex_hull.hpp"
+#include "geometry/polygon_animation.hpp"
+
+namespace {
+
+double Cross(Point o, Point a, Point b) {
+    return ((double) a.x - o.x) * ((double) b.y - o.y) - ((double) a.y - o.y) * ((double) b.x - o.x);
+}
+
+bool LessXY(Point a, Point b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+// == of raymath compares with a relative epsilon, vertexes of dense hulls are closer than it
+bool SameXY(Point a, Point b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+// sequential monotone chain in doubles, without the octagon filter and the parallel merge
+std::vector<Point> ReferenceHull(std::vector<Point> points) {
+    std::sort(points.begin(), points.end(), LessXY);
+    points.erase(std::unique(points.begin(), points.end(), SameXY), points.end());
+    if (points.size() < 3) {
+        return points;
+    }
+
+    std::vector<Point> hull;
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t start = hull.size();
+        for (Point p : points) {
+            while (hull.size() >= start + 2 && Cross(hull[hull.size() - 2], hull.back(), p) <= 0) {
+                hull.pop_back();
+            }
+            hull.push_back(p);
+        }
+        hull.pop_back(); // last point of a chain is the first one of the other
+        std::reverse(points.begin(), points.end());
+    }
+    return hull;
+}
+
+// distance of p to the right of the line ab, positive when p is outside of a counter-clockwise polygon with edge ab
+double Outside(Point a, Point b, Point p) {
+    return -Cross(a, b, p) / Vector2Distance(a, b);
+}
+
+// strictly convex and counter-clockwise in math coordinates, without repeated vertexes
+bool IsConvex(const std::vector<Point> &hull) {
+    std::vector<Point> sorted = hull;
+    std::sort(sorted.begin(), sorted.end(), LessXY);
+    if (std::adjacent_find(sorted.begin(), sorted.end(), SameXY) != sorted.end()) {
+        return false;
+    }
+
+    size_t m = hull.size();
+    for (size_t i = 0; m >= 3 && i < m; ++i) {
+        if (Cross(hull[i], hull[(i + 1) % m], hull[(i + 2) % m]) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// how far the farthest of points is outside of a convex polygon, 0 if none is, O(log m) per point
+double MaxOutside(const std::vector<Point> &polygon, std::span<const Point> points) {
+    size_t m = polygon.size();
+    if (m < 3) {
+        return 0;
+    }
+
+    Point center = Vector2Zeros;
+    for (Point p : polygon) {
+        center += p;
+    }
+    center = center / (float) m;
+
+    // center is inside, so vertexes sorted by the angle around it go counter-clockwise
+    auto angle_of = [center](Point p) { return std::atan2((double) p.y - center.y, (double) p.x - center.x); };
+    std::vector<std::pair<double, size_t>> angles;
+    for (size_t i = 0; i < m; ++i) {
+        angles.push_back({ angle_of(polygon[i]), i });
+    }
+    std::sort(angles.begin(), angles.end());
+
+    double outside = 0;
+    for (Point p : points) {
+        // edge of the wedge the point is in
+        auto next = std::upper_bound(angles.begin(), angles.end(), std::pair(angle_of(p), m));
+        auto prev = next == angles.begin() ? angles.end() - 1 : next - 1;
+        if (next == angles.end()) {
+            next = angles.begin();
+        }
+        outside = std::max(outside, Outside(polygon[prev->second], polygon[next->second], p));
+    }
+    return outside;
+}
+
+bool SameVertexes(std::vector<Point> a, std::vector<Point> b) {
+    std::sort(a.begin(), a.end(), LessXY);
+    std::sort(b.begin(), b.end(), LessXY);
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), SameXY);
+}
+
+} // namespace
+
+// ConvexHullIndexes() on degenerate sets, on 10^3..10^7 points of three distributions against a reference chain,
+// and the hull of an animated polygon against the hull recomputed every frame
+void BenchConvexHull(Bench &bench) {
+    std::mt19937 rng(45);
+    std::uniform_real_distribution<float> uniform(0, 1);
+
+    // small sets: integer grids with repeats, collinear points, one repeated point and random ones
+    bool small_ok = true;
+    for (size_t test = 0; test < bench.Size(3000, 300); ++test) {
+        std::vector<Point> points(1 + rng() % 60);
+        for (Point &p : points) {
+            switch (test % 4) {
+                case 0: p = { (float) (rng() % 5), (float) (rng() % 5) }; break;
+                case 1: { float x = (float) (rng() % 10); p = { x, 2 * x + 1 }; break; }
+                case 2: p = { 3, 3 }; break;
+                default: p = { (float) (rng() % 100000) / 7.f, (float) (rng() % 100000) / 3.f }; break;
+            }
+        }
+        std::vector<uint32_t> hull = ConvexHullIndexes(points);
+        std::vector<Point> hull_points;
+        for (uint32_t i : hull) {
+            hull_points.push_back(points[i]);
+        }
+        small_ok = small_ok && IsConvex(hull_points) && MaxOutside(hull_points, points) <= 0 &&
+                   SameVertexes(hull_points, ReferenceHull(points));
+    }
+    bench.Check(small_ok, "hulls of small degenerate sets");
+
+    const char *kinds[] = { "square", "gauss", "circle" };
+    for (size_t n = 1000; n <= bench.Size(10'000'000, 100'000); n *= 10) {
+        for (int kind = 0; kind < 3; ++kind) {
+            std::vector<Point> points(n);
+            for (Point &p : points) {
+                float angle = uniform(rng) * 2 * PI;
+                if (kind == 0) {
+                    p = { uniform(rng) * 1000, uniform(rng) * 1000 };
+                } else if (kind == 1) {
+                    float r = std::sqrt(-2 * std::log(uniform(rng) + 1e-9f));
+                    p = { r * std::cos(angle) * 100, r * std::sin(angle) * 100 };
+                } else {
+                    p = { 1000 * std::cos(angle), 1000 * std::sin(angle) };
+                }
+            }
+
+            std::vector<uint32_t> hull;
+            double hull_time = bench.Time([&] { hull = ConvexHullIndexes(points); });
+
+            std::vector<Point> sorted = points;
+            double sort_time = bench.Time([&] {
+                sorted = points;
+                std::sort(sorted.begin(), sorted.end(), LessXY);
+            });
+
+            std::vector<Point> hull_points;
+            for (uint32_t i : hull) {
+                hull_points.push_back(points[i]);
+            }
+            std::vector<Point> reference = ReferenceHull(points);
+
+            printf("%8zu points (%s): hull of %6zu points in %8.2f ms, std::sort alone %8.2f ms\n",
+                   n, kinds[kind], hull.size(), hull_time * 1000, sort_time * 1000);
+
+            bench.Check(IsConvex(hull_points), "hull is convex");
+            bench.Check(MaxOutside(hull_points, points) <= 0, "hull contains every point");
+            bench.Check(SameVertexes(hull_points, reference), "hull is the same as the one of the reference chain");
+        }
+    }
+
+    // hull of the animation is transformed with the polygon instead of computed again every frame
+    Polygon polygon;
+    for (int i = 0; i < 20000; ++i) {
+        float angle = 2 * PI * (float) i / 20000;
+        float r = 200 + 50 * uniform(rng);
+        polygon.AddPoint({ 800 + r * std::cos(angle), 450 + r * std::sin(angle) });
+    }
+    PolygonAnimation animation(polygon);
+    animation.rotation_speed = 1.3f;
+
+    const int frames = (int) bench.Size(200, 20);
+    double transformed_time = 0;
+    double recomputed_time  = 0;
+    bool same_size = true;
+    double max_outside = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        animation.Update(1 / 60.f);
+        animation.Shift({ 0.5f, 0.2f });
+
+        double start = Bench::Now();
+        const Polygon &hull = animation.AnimatedHull();
+        transformed_time += Bench::Now() - start;
+
+        Polygon &animated = animation.AnimatedPolygon();
+        std::vector<Point> vertexes(animated.vertexes.begin(), animated.vertexes.end());
+        start = Bench::Now();
+        std::vector<Point> recomputed = ConvexHull(vertexes);
+        recomputed_time += Bench::Now() - start;
+
+        same_size = same_size && recomputed.size() == hull.NumPoints();
+
+        std::vector<Point> hull_vertexes(hull.vertexes.begin(), hull.vertexes.end());
+        max_outside = std::max(max_outside, MaxOutside(hull_vertexes, vertexes));
+    }
+    printf("animated hull of 20000 vertexes: transformed %.3f ms/frame, recomputed %.3f ms/frame, "
+           "vertexes outside by %.5f px at most\n",
+           transformed_time / frames * 1000, recomputed_time / frames * 1000, max_outside);
+
+    bench.Check(same_size, "transformed hull has as many vertexes as the recomputed one");
+    // hull is rotated in floats together with the polygon, so the vertexes may be off a little
+    bench.Check(max_outside < 1e-3, "transformed hull contains the animated polygon");
+}
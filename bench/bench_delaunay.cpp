@@ -0,0 +1,190 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "geometry/convex_hull.hpp"
+#include "geometry/delaunay.hpp"
+
+namespace {
+
+double Cross(Point o, Point a, Point b) {
+    return ((double) a.x - o.x) * ((double) b.y - o.y) - ((double) a.y - o.y) * ((double) b.x - o.x);
+}
+
+// > 0 when d is inside of the circumcircle of counter-clockwise a, b, c
+double InCircle(Point a, Point b, Point c, Point d) {
+    double adx = (double) a.x - d.x, ady = (double) a.y - d.y;
+    double bdx = (double) b.x - d.x, bdy = (double) b.y - d.y;
+    double cdx = (double) c.x - d.x, cdy = (double) c.y - d.y;
+    return (adx * adx + ady * ady) * (bdx * cdy - bdy * cdx)
+         + (bdx * bdx + bdy * bdy) * (cdx * ady - cdy * adx)
+         + (cdx * cdx + cdy * cdy) * (adx * bdy - ady * bdx);
+}
+
+bool LessXY(Point a, Point b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+bool SameXY(Point a, Point b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+size_t CountDistinct(std::span<const Point> points) {
+    std::vector<Point> sorted(points.begin(), points.end());
+    std::sort(sorted.begin(), sorted.end(), LessXY);
+    return (size_t) (std::unique(sorted.begin(), sorted.end(), SameXY) - sorted.begin());
+}
+
+struct Report {
+    size_t not_delaunay = 0; // edges with the opposite vertex of the other triangle inside of the circumcircle
+    bool hull  = true;       // every vertex of ConvexHull() is on the boundary and triangles cover its area
+    bool euler = true;       // 2n - h - 2 triangles for n points with h of them on the boundary
+};
+
+// checks the triangulation of points, which must have 3 points that are not on one line
+Report Verify(const DelaunayTriangulation &delaunay, std::span<const Point> points) {
+    TriangleMesh mesh;
+    delaunay.ExportMesh(mesh);
+
+    Point min = points[0];
+    Point max = points[0];
+    for (Point p : points) {
+        min = Vector2Min(min, p);
+        max = Vector2Max(max, p);
+    }
+    // in-circle tests are in doubles, a few ulps of the largest terms are rounding
+    double size = std::max(max.x - min.x, max.y - min.y);
+    double tolerance = 1e-12 * size * size * size * size;
+
+    Report report;
+    std::vector<uint8_t> on_boundary(mesh.vertexes.size());
+    double area2 = 0;
+    for (size_t t = 0; t < mesh.triangles.size(); ++t) {
+        const auto &v = mesh.triangles[t];
+        area2 += Cross(mesh.vertexes[v[0]], mesh.vertexes[v[1]], mesh.vertexes[v[2]]);
+        for (size_t i = 0; i < 3; ++i) {
+            uint32_t neighbour = mesh.neighbours[t][i];
+            if (neighbour == TriangleMesh::NONE) {
+                on_boundary[v[i]] = on_boundary[v[(i + 1) % 3]] = 1;
+                continue;
+            }
+            // vertex of the neighbour that is not on the common edge
+            const auto &w = mesh.triangles[neighbour];
+            uint32_t opposite = w[0] != v[i] && w[0] != v[(i + 1) % 3] ? w[0] : w[1] != v[i] && w[1] != v[(i + 1) % 3] ? w[1] : w[2];
+            report.not_delaunay += InCircle(mesh.vertexes[v[0]], mesh.vertexes[v[1]], mesh.vertexes[v[2]], mesh.vertexes[opposite]) > tolerance;
+        }
+    }
+    // every inner edge is counted from both of its triangles
+    report.not_delaunay /= 2;
+
+    std::vector<Point> hull = ConvexHull(points);
+    double hull_area2 = 0;
+    for (size_t i = 0; i < hull.size(); ++i) {
+        hull_area2 += Cross(hull[0], hull[i], hull[(i + 1) % hull.size()]);
+    }
+    std::vector<Point> boundary;
+    for (size_t vertex = 0; vertex < mesh.vertexes.size(); ++vertex) {
+        if (on_boundary[vertex]) {
+            boundary.push_back(mesh.vertexes[vertex]);
+        }
+    }
+    std::sort(boundary.begin(), boundary.end(), LessXY);
+    for (Point p : hull) {
+        report.hull = report.hull && std::binary_search(boundary.begin(), boundary.end(), p, LessXY);
+    }
+    report.hull = report.hull && std::abs(area2 - hull_area2) <= 1e-9 * hull_area2;
+
+    report.euler = mesh.triangles.size() == 2 * CountDistinct(points) - boundary.size() - 2;
+    return report;
+}
+
+void CheckReport(Bench &bench, const Report &report) {
+    bench.Check(report.not_delaunay == 0, "no point is inside of the circumcircle of a triangle across any of its edges");
+    bench.Check(report.hull, "triangulation covers the convex hull");
+    bench.Check(report.euler, "triangulation has 2n - h - 2 triangles");
+}
+
+std::vector<Point> RandomPoints(size_t n, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> coordinate(0, 1000);
+    std::vector<Point> points(n);
+    for (Point &p : points) {
+        p = { coordinate(rng), coordinate(rng) };
+    }
+    return points;
+}
+
+} // namespace
+
+// DelaunayTriangulation on small degenerate sets, on 10^3..10^6 random points built at once and synced after moves,
+// insertions and removals, checked for empty circumcircles, the convex hull and the number of triangles
+void BenchDelaunay(Bench &bench) {
+    std::mt19937 rng(50);
+
+    // integer grids have repeated, collinear and cocircular points, synced with a few of them moved every time
+    Report small;
+    for (size_t test = 0; test < bench.Size(1000, 100); ++test) {
+        std::vector<Point> points(4 + rng() % 60);
+        for (Point &p : points) {
+            p = { (float) (rng() % 8), (float) (rng() % 8) };
+        }
+        points.push_back({ 0, 0 });
+        points.push_back({ 1, 0 });
+        points.push_back({ 0, 1 });
+
+        DelaunayTriangulation delaunay;
+        delaunay.Build(points);
+        for (int step = 0; step < 4; ++step) {
+            Report report = Verify(delaunay, points);
+            small.not_delaunay += report.not_delaunay;
+            small.hull  = small.hull && report.hull;
+            small.euler = small.euler && report.euler;
+
+            points[rng() % (points.size() - 3)] = { (float) (rng() % 8), (float) (rng() % 8) };
+            delaunay.Sync(points);
+        }
+    }
+    CheckReport(bench, small);
+
+    for (size_t n = 1000; n <= bench.Size(1'000'000, 100'000); n *= 10) {
+        std::vector<Point> points = RandomPoints(n, rng);
+
+        DelaunayTriangulation delaunay;
+        double build_time = bench.Time([&] { delaunay.Build(points); });
+        CheckReport(bench, Verify(delaunay, points));
+
+        // a drag moves one point a little every frame, a selection moves many
+        std::uniform_real_distribution<float> shift(-5, 5);
+        printf("%8zu points: Build %8.2f ms", n, build_time * 1000);
+        for (size_t moved : { (size_t) 1, (size_t) 100, n / 100 }) {
+            const int frames = 10;
+            double sync_time = 0;
+            size_t rebuilds = delaunay.rebuilds;
+            for (int frame = 0; frame < frames; ++frame) {
+                size_t first = rng() % (n - moved + 1);
+                for (size_t i = first; i < first + moved; ++i) {
+                    points[i] += { shift(rng), shift(rng) };
+                }
+                double start = Bench::Now();
+                delaunay.Sync(points);
+                sync_time += Bench::Now() - start;
+            }
+            printf(", Sync of %zu moved %7.3f ms%s", moved, sync_time / frames * 1000, delaunay.rebuilds != rebuilds ? " (rebuilt)" : "");
+        }
+        printf("\n");
+        CheckReport(bench, Verify(delaunay, points));
+
+        // points are added at the end and taken from the end, ids of the others stay
+        std::vector<Point> more = RandomPoints(n / 100, rng);
+        points.insert(points.end(), more.begin(), more.end());
+        delaunay.Sync(points);
+        CheckReport(bench, Verify(delaunay, points));
+        points.resize(n - n / 100);
+        delaunay.Sync(points);
+        CheckReport(bench, Verify(delaunay, points));
+    }
+}
@@ -0,0 +1,116 @@
+#include "bench.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+#include "geometry/geometry.hpp"
+#include "memory/allocation_counter.hpp"
+#include "memory/counting_resource.hpp"
+#include "scenes/scene_registry.hpp"
+
+namespace {
+
+size_t TagBytes(MemoryTag tag) {
+    return GetMemoryTagStats(tag).bytes_current;
+}
+
+// holds its points in pmr containers, like the scenes with curves and polygons
+struct HeavyScene : Scene {
+    CountingResource memory { "heavy scene" };
+    std::pmr::deque<Point> points { &memory };
+
+    explicit HeavyScene(size_t n) {
+        points.resize(n);
+    }
+
+    void Draw() override {}
+    void Update(float) override {}
+    void ReleaseHeavyState() override {
+        points.clear();
+        points.shrink_to_fit();
+    }
+};
+
+} // namespace
+
+// tags and heap totals count pmr containers, which allocate with the aligned operator new,
+// the memory budget of SceneRegistry sees scenes made of them, and the cost of a counted new and delete
+void BenchMemory(Bench &bench) {
+    const size_t n = 100'000;
+
+    size_t geometry_start = TagBytes(MemoryTag::Geometry);
+    size_t heap_start = GetHeapBytesCurrent();
+    {
+        ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+        std::pmr::vector<Point> points(n);
+        bench.Check(TagBytes(MemoryTag::Geometry) >= geometry_start + n * sizeof(Point), "pmr vector is counted under its tag");
+        bench.Check(GetHeapBytesCurrent() >= heap_start + n * sizeof(Point), "pmr vector is counted in the heap total");
+    }
+    bench.Check(TagBytes(MemoryTag::Geometry) == geometry_start, "freed pmr vector is credited back to its tag");
+
+    {
+        ScopedMemoryTag memory_tag(MemoryTag::Scene);
+        size_t scene_start = TagBytes(MemoryTag::Scene);
+        CountingResource resource("bench");
+        Polygon polygon(&resource);
+        for (size_t i = 0; i < n; ++i) {
+            polygon.AddPoint({ (float) i, 0 });
+        }
+        bench.Check(resource.BytesCurrent() >= n * sizeof(Point), "counting resource counts the polygon");
+        bench.Check(TagBytes(MemoryTag::Scene) >= scene_start + resource.BytesCurrent(),
+                    "polygon in a counting resource is counted under its tag");
+    }
+
+    bool aligned = true;
+    size_t untagged_start = TagBytes(MemoryTag::Untagged);
+    for (size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+        void *ptr = ::operator new(100, std::align_val_t(alignment));
+        aligned = aligned && (uintptr_t) ptr % alignment == 0 && TagBytes(MemoryTag::Untagged) == untagged_start + 100;
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+    bench.Check(aligned && TagBytes(MemoryTag::Untagged) == untagged_start, "aligned blocks are aligned and counted");
+
+    // scenes are preloaded without a window, every Maintain() has a whole second to spare
+    const size_t scene_points = bench.Size(4'000'000, 400'000);
+    SceneRegistry registry;
+    registry.Register(1, "heavy", [&] { return std::make_unique<HeavyScene>(scene_points); });
+    registry.Register(2, "light", [&] { return std::make_unique<HeavyScene>(0); });
+    registry.memory_budget = GetHeapBytesCurrent() + scene_points * sizeof(Point) / 2;
+    registry.Maintain(1);
+    registry.Maintain(1);
+    const SceneRegistry::Entry &heavy = registry.Entries()[0];
+    bench.Check(heavy.scene && heavy.construction_bytes >= scene_points * sizeof(Point), "scene with pmr containers is counted while constructed");
+    registry.Maintain(1);
+    bench.Check(heavy.heavy_state_released && GetHeapBytesCurrent() <= registry.memory_budget,
+                "scene with pmr containers over the budget releases its heavy state");
+
+    std::vector<void *> blocks(256);
+    const size_t rounds = bench.Size(20'000, 1000);
+    double time = bench.Time([&] {
+        for (size_t round = 0; round < rounds; ++round) {
+            for (void *&block : blocks) {
+                block = ::operator new(48);
+            }
+            for (void *block : blocks) {
+                ::operator delete(block);
+            }
+        }
+    });
+    double aligned_time = bench.Time([&] {
+        for (size_t round = 0; round < rounds; ++round) {
+            for (void *&block : blocks) {
+                block = ::operator new(48, std::align_val_t(64));
+            }
+            for (void *block : blocks) {
+                ::operator delete(block, std::align_val_t(64));
+            }
+        }
+    });
+    double pairs = (double) (rounds * blocks.size());
+    printf("counted new + delete: %.2f ns, aligned to 64 bytes: %.2f ns\n", time / pairs * 1e9, aligned_time / pairs * 1e9);
+}
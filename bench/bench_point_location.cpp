@@ -0,0 +1,142 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "geometry/delaunay.hpp"
+#include "geometry/point_location.hpp"
+#include "parallel/thread_pool.hpp"
+
+namespace {
+
+double Side(Point a, Point b, Point p) {
+    return ((double) b.x - a.x) * ((double) p.y - a.y) - ((double) b.y - a.y) * ((double) p.x - a.x);
+}
+
+// with the boundary, so a point on an edge is in both of its triangles
+bool Contains(const TriangleMesh &mesh, uint32_t triangle, Point p) {
+    if (triangle >= mesh.triangles.size()) {
+        return false;
+    }
+    const auto &t = mesh.triangles[triangle];
+    Point a = mesh.vertexes[t[0]];
+    Point b = mesh.vertexes[t[1]];
+    Point c = mesh.vertexes[t[2]];
+    return Side(a, b, p) >= 0 && Side(b, c, p) >= 0 && Side(c, a, p) >= 0;
+}
+
+// results are triangles that contain their points, brute force may miss points on the edges
+bool AllContained(const TriangleMesh &mesh, std::span<const Point> points, std::span<const uint32_t> results, bool allow_none) {
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (!(Contains(mesh, results[i], points[i]) || (allow_none && results[i] == TriangleMesh::NONE))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t BoundaryEdges(const TriangleMesh &mesh) {
+    size_t boundary = 0;
+    for (const auto &n : mesh.neighbours) {
+        for (uint32_t neighbour : n) {
+            boundary += neighbour == TriangleMesh::NONE;
+        }
+    }
+    return boundary;
+}
+
+// walk and grid on pixels in rows (coherent) and on random points, brute force on a part of them
+void BenchMesh(Bench &bench, const char *name, const TriangleMesh &mesh, Rectangle area) {
+    MeshGridIndex grid_index;
+    double build_time = bench.Time([&] { grid_index.Build(mesh); });
+    printf("%s: %zu triangles, grid index built in %.2f ms (%.2f MB)\n",
+           name, mesh.triangles.size(), build_time * 1000, (double) grid_index.MemoryUsage() / (1 << 20));
+
+    const int step = (int) bench.Size(1, 4);
+    std::vector<Point> coherent;
+    for (int y = step / 2; y < (int) area.height; y += step) {
+        for (int x = step / 2; x < (int) area.width; x += step) {
+            coherent.push_back({ area.x + (float) x + 0.5f, area.y + (float) y + 0.5f });
+        }
+    }
+    std::mt19937 rng(49);
+    std::uniform_real_distribution<float> x(area.x, area.x + area.width);
+    std::uniform_real_distribution<float> y(area.y, area.y + area.height);
+    // random walks are long, fewer points are enough
+    std::vector<Point> random(std::min(coherent.size(), bench.Size(200'000, 20'000)));
+    for (Point &p : random) {
+        p = { x(rng), y(rng) };
+    }
+
+    std::vector<uint32_t> walk_results(coherent.size());
+    std::vector<uint32_t> grid_results(coherent.size());
+    std::vector<Point> brute_force_points(bench.Size(500, 200));
+    std::vector<uint32_t> brute_force_results(brute_force_points.size());
+
+    for (const auto &[order, points] : { std::pair { "coherent", &coherent }, std::pair { "random", &random } }) {
+        std::span<uint32_t> walk(walk_results.data(), points->size());
+        std::span<uint32_t> grid(grid_results.data(), points->size());
+        size_t steps = 0;
+        double walk_time = bench.Time([&] { steps = LocatePointsByWalk(mesh, *points, walk); });
+        double grid_time = bench.Time([&] { LocatePointsByGrid(grid_index, *points, grid); });
+
+        // evenly over the points, brute force is too slow for all of them
+        for (size_t i = 0; i < brute_force_points.size(); ++i) {
+            brute_force_points[i] = (*points)[i * points->size() / brute_force_points.size()];
+        }
+        double brute_force_time = bench.Time([&] { LocatePointsBruteForce(mesh, brute_force_points, brute_force_results); }, 1);
+
+        double n = (double) points->size();
+        printf("  %zu %-8s points: walk %6.2f M points/s (%.2f steps per point), grid %6.2f M points/s, "
+               "brute force %.4f M points/s\n",
+               points->size(), order, n / walk_time / 1e6, (double) steps / n, n / grid_time / 1e6,
+               (double) brute_force_points.size() / brute_force_time / 1e6);
+
+        bench.Check(AllContained(mesh, *points, walk, false), "walk finds a triangle with the point");
+        bench.Check(AllContained(mesh, *points, grid, false), "grid index finds a triangle with the point");
+        bench.Check(AllContained(mesh, brute_force_points, brute_force_results, true), "brute force finds a triangle with the point");
+    }
+
+    Point outside[] = { { area.x - 1, area.y - 1 }, { area.x + area.width + 100, area.y + 10 }, { area.x + 10, area.y + area.height + 50 } };
+    MeshWalker walker(mesh);
+    bool none = true;
+    for (Point p : outside) {
+        none = none && walker.Locate(p) == TriangleMesh::NONE && grid_index.Locate(p) == TriangleMesh::NONE &&
+               LocatePointBruteForce(mesh, p) == TriangleMesh::NONE;
+    }
+    bench.Check(none, "points outside of the mesh are in no triangle");
+}
+
+} // namespace
+
+// MeshWalker, MeshGridIndex and brute force on a jittered grid mesh and on the Delaunay triangulation of random points,
+// both over a 1600x900 screen
+void BenchPointLocation(Bench &bench) {
+    Rectangle area = { 0, 0, 1600, 900 };
+    printf("%zu threads\n", GetThreadPool().NumThreads());
+
+    int cells = (int) bench.Size(224, 64);
+    TriangleMesh grid_mesh = GenerateGridMesh(area, cells, cells);
+    bench.Check(BoundaryEdges(grid_mesh) == (size_t) (2 * (cells + cells)), "grid mesh has the edges of the border on its boundary");
+    BenchMesh(bench, "grid mesh", grid_mesh, area);
+
+    // corners make the hull the whole area, so walks don't leave the mesh
+    std::mt19937 rng(50);
+    std::uniform_real_distribution<float> x(area.x, area.x + area.width);
+    std::uniform_real_distribution<float> y(area.y, area.y + area.height);
+    std::vector<Point> points = { { area.x, area.y }, { area.x + area.width, area.y },
+                                  { area.x + area.width, area.y + area.height }, { area.x, area.y + area.height } };
+    for (size_t i = 0; i < bench.Size(100'000, 4000); ++i) {
+        points.push_back({ x(rng), y(rng) });
+    }
+    DelaunayTriangulation delaunay;
+    delaunay.Build(points);
+    TriangleMesh delaunay_mesh;
+    double export_time = bench.Time([&] { delaunay.ExportMesh(delaunay_mesh); });
+    printf("Delaunay triangulation of %zu points exported in %.2f ms\n", points.size(), export_time * 1000);
+    bench.Check(delaunay_mesh.triangles.size() == delaunay.NumTriangles(), "exported mesh has every triangle of the triangulation");
+    BenchMesh(bench, "Delaunay mesh", delaunay_mesh, area);
+}
@@ -0,0 +1,249 @@
+#include "bench.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "geometry/polygon_boolean.hpp"
+#include "parallel/thread_pool.hpp"
+
+namespace {
+
+const char *NAMES[] = { "union", "intersection", "difference", "xor" };
+
+double SignedArea(std::span<const Polygon> rings) {
+    double area2 = 0;
+    for (const Polygon &ring : rings) {
+        for (size_t i = 0, n = ring.NumPoints(); i < n; ++i) {
+            Point a = ring.vertexes[i];
+            Point b = ring.vertexes[(i + 1) % n];
+            area2 += (double) a.x * b.y - (double) b.x * a.y;
+        }
+    }
+    return area2 / 2;
+}
+
+// winding number of the rings around p, in doubles
+int Winding(std::span<const Polygon> rings, Point p) {
+    int winding = 0;
+    for (const Polygon &ring : rings) {
+        for (size_t i = 0, n = ring.NumPoints(); i < n; ++i) {
+            Point a = ring.vertexes[i];
+            Point b = ring.vertexes[(i + 1) % n];
+            double side = ((double) b.x - a.x) * ((double) p.y - a.y) - ((double) p.x - a.x) * ((double) b.y - a.y);
+            if (a.y <= p.y && b.y > p.y && side > 0) {
+                ++winding;
+            } else if (a.y > p.y && b.y <= p.y && side < 0) {
+                --winding;
+            }
+        }
+    }
+    return winding;
+}
+
+bool IsInside(std::span<const Polygon> rings, Point p, FillRule fill_rule) {
+    int winding = Winding(rings, p);
+    return fill_rule == FillRule::EvenOdd ? (winding & 1) != 0 : winding != 0;
+}
+
+bool Combine(bool subject, bool clip, BooleanOperation operation) {
+    switch (operation) {
+        case BooleanOperation::Union:        return subject || clip;
+        case BooleanOperation::Intersection: return subject && clip;
+        case BooleanOperation::Difference:   return subject && !clip;
+        case BooleanOperation::Xor:          return subject != clip;
+    }
+    return false;
+}
+
+// points of the bounding box of the operands where the result and the operands disagree,
+// result rings are oriented, so a point is inside of them when they wind around it
+size_t CountMisplaced(std::span<const Polygon> subject, std::span<const Polygon> clip, std::span<const Polygon> result,
+                      BooleanOperation operation, FillRule fill_rule, size_t samples, std::mt19937 &rng) {
+    Point min = subject[0].vertexes[0];
+    Point max = min;
+    for (auto operand : { subject, clip }) {
+        for (const Polygon &ring : operand) {
+            for (Point p : ring.vertexes) {
+                min = Vector2Min(min, p);
+                max = Vector2Max(max, p);
+            }
+        }
+    }
+
+    std::uniform_real_distribution<float> x(min.x - 1, max.x + 1);
+    std::uniform_real_distribution<float> y(min.y - 1, max.y + 1);
+    size_t misplaced = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        Point p = { x(rng), y(rng) };
+        bool expected = Combine(IsInside(subject, p, fill_rule), IsInside(clip, p, fill_rule), operation);
+        misplaced += expected != (Winding(result, p) != 0);
+    }
+    return misplaced;
+}
+
+Polygon Box(float x0, float y0, float x1, float y1) {
+    return Polygon { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 } };
+}
+
+// n vertexes around center with the radius changed randomly by up to noise of it, clockwise ones make holes
+Polygon Blob(Point center, float radius, size_t n, float noise, std::mt19937 &rng, bool clockwise=false) {
+    std::uniform_real_distribution<float> change(-noise, noise);
+    Polygon blob;
+    for (size_t i = 0; i < n; ++i) {
+        float angle = 2 * PI * (float) i / (float) n * (clockwise ? -1.f : 1.f);
+        float r = radius * (1 + change(rng));
+        blob.AddPoint({ center.x + r * std::cos(angle), center.y + r * std::sin(angle) });
+    }
+    return blob;
+}
+
+// random vertexes in a square, the ring crosses itself a lot
+Polygon RandomRing(size_t n, float size, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> coordinate(0, size);
+    Polygon ring;
+    for (size_t i = 0; i < n; ++i) {
+        ring.AddPoint({ coordinate(rng), coordinate(rng) });
+    }
+    return ring;
+}
+
+} // namespace
+
+// PolygonBoolean() on cases with known areas, on random rings against sampled points, on blobs of up to 10^5 edges
+// each and PolygonBooleanMany() on shapes clipped by the viewport
+void BenchPolygonBoolean(Bench &bench) {
+    std::mt19937 rng(46);
+
+    Polygon a = Box(0, 0, 2, 2);
+    Polygon b = Box(1, 1, 3, 3);
+    const double square_areas[] = { 7, 1, 3, 6 };
+    for (int operation = 0; operation < 4; ++operation) {
+        std::vector<Polygon> result = PolygonBoolean({ &a, 1 }, { &b, 1 }, (BooleanOperation) operation);
+        bench.Check(std::abs(SignedArea(result) - square_areas[operation]) < 1e-4, "area of two overlapping squares");
+    }
+
+    Polygon touching = Box(2, 0, 4, 2);
+    std::vector<Polygon> result = PolygonBoolean({ &a, 1 }, { &touching, 1 }, BooleanOperation::Union);
+    bench.Check(result.size() == 1 && result[0].NumPoints() == 4, "union of squares with a common edge is one rectangle");
+
+    result = PolygonBoolean({ &a, 1 }, { &a, 1 }, BooleanOperation::Union);
+    bench.Check(result.size() == 1 && std::abs(SignedArea(result) - 4) < 1e-6, "union of a square with itself");
+    result = PolygonBoolean({ &a, 1 }, { &a, 1 }, BooleanOperation::Xor);
+    bench.Check(result.empty(), "xor of a square with itself is empty");
+
+    std::vector<Polygon> holed = { Box(0, 0, 10, 10), Box(3, 3, 7, 7) };
+    Polygon right = Box(5, -1, 12, 11);
+    result = PolygonBoolean(holed, { &right, 1 }, BooleanOperation::Difference);
+    bench.Check(std::abs(SignedArea(result) - 42) < 1e-3, "difference of a square with a hole");
+    Polygon inside = Box(4, 4, 6, 6);
+    result = PolygonBoolean(holed, { &inside, 1 }, BooleanOperation::Union);
+    bench.Check(result.size() == 3 && std::abs(SignedArea(result) - 88) < 1e-3, "union with a square inside of the hole");
+
+    // a few samples may land on the boundary, where rounding decides
+    size_t random_failures = 0;
+    for (size_t test = 0; test < bench.Size(300, 40); ++test) {
+        std::vector<Polygon> subject, clip;
+        FillRule fill_rule = test % 2 == 0 ? FillRule::EvenOdd : FillRule::NonZero;
+        switch (test % 3) {
+            case 0:
+                subject = { RandomRing(3 + test % 12, 100, rng) };
+                clip    = { RandomRing(3 + test % 9, 100, rng) };
+                break;
+            case 1:
+                subject = { Blob({ 50, 50 }, 40, 30, 0.2f, rng), Blob({ 50, 50 }, 15, 20, 0.2f, rng, true) };
+                clip    = { Blob({ 30.f + (float) (rng() % 40), 30.f + (float) (rng() % 40) }, 30, 25, 0.3f, rng) };
+                fill_rule = FillRule::NonZero;
+                break;
+            default: {
+                // integer vertexes make collinear and touching edges
+                std::uniform_int_distribution<int> coordinate(0, 6);
+                for (auto *operand : { &subject, &clip }) {
+                    Polygon ring;
+                    for (int i = 0; i < 8; ++i) {
+                        ring.AddPoint({ (float) coordinate(rng), (float) coordinate(rng) });
+                    }
+                    operand->push_back(std::move(ring));
+                }
+                break;
+            }
+        }
+
+        const size_t samples = 1000;
+        for (int operation = 0; operation < 4; ++operation) {
+            result = PolygonBoolean(subject, clip, (BooleanOperation) operation, fill_rule);
+            random_failures += CountMisplaced(subject, clip, result, (BooleanOperation) operation, fill_rule, samples, rng) > samples / 1000 + 1;
+        }
+    }
+    bench.Check(random_failures == 0, "results of random rings have the right points inside");
+
+    // blobs of smooth edges, and noisy ones whose edges cross each other all the time
+    for (float noise : { 0.0001f, 0.01f }) {
+        for (size_t n = 5000; n <= bench.Size(100'000, 5000); n *= 20) {
+            Polygon subject = Blob({ 0, 0 }, 1000, n, noise, rng);
+            Polygon clip    = Blob({ 300, 200 }, 1000, n, noise, rng);
+
+            double times[4];
+            std::vector<Polygon> results[4];
+            for (int operation = 0; operation < 4; ++operation) {
+                times[operation] = bench.Time([&] {
+                    results[operation] = PolygonBoolean({ &subject, 1 }, { &clip, 1 }, (BooleanOperation) operation);
+                }, 1);
+            }
+
+            printf("%s blobs of %6zu + %6zu edges:", noise < 0.001f ? "smooth" : "noisy ", n, n);
+            for (int operation = 0; operation < 4; ++operation) {
+                printf(" %s %7.1f ms (%zu rings)%s", NAMES[operation], times[operation] * 1000, results[operation].size(), operation < 3 ? "," : "\n");
+            }
+
+            if (noise < 0.001f) {
+                double subject_area = SignedArea({ &subject, 1 });
+                double clip_area    = SignedArea({ &clip, 1 });
+                double union_area        = SignedArea(results[(int) BooleanOperation::Union]);
+                double intersection_area = SignedArea(results[(int) BooleanOperation::Intersection]);
+                bench.Check(std::abs(union_area + intersection_area - subject_area - clip_area) < 1e-4 * subject_area,
+                            "areas of union and intersection of smooth blobs add up to the areas of the blobs");
+            }
+
+            bool placed = true;
+            for (int operation = 0; operation < 4; ++operation) {
+                const size_t samples = 200;
+                placed = placed && CountMisplaced({ &subject, 1 }, { &clip, 1 }, results[operation], (BooleanOperation) operation,
+                                                  FillRule::EvenOdd, samples, rng) <= 1;
+            }
+            bench.Check(placed, "results of large blobs have the right points inside");
+        }
+    }
+
+    // many small shapes against the viewport, every job is sequential
+    std::vector<Polygon> shapes;
+    for (size_t i = 0; i < bench.Size(4000, 400); ++i) {
+        Point center = { -200.f + (float) (rng() % 2000), -200.f + (float) (rng() % 1300) };
+        shapes.push_back(Blob(center, 20.f + (float) (rng() % 130), 32, 0.3f, rng));
+    }
+    Polygon viewport = Box(0, 0, 1600, 900);
+    std::vector<BooleanJob> jobs;
+    for (const Polygon &shape : shapes) {
+        jobs.push_back({ { &shape, 1 }, { &viewport, 1 }, BooleanOperation::Intersection });
+    }
+
+    std::vector<std::vector<Polygon>> many;
+    double many_time = bench.Time([&] { many = PolygonBooleanMany(jobs); });
+    std::vector<std::vector<Polygon>> sequential(jobs.size());
+    double sequential_time = bench.Time([&] {
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            sequential[i] = PolygonBoolean(jobs[i].subject, jobs[i].clip, jobs[i].operation, jobs[i].fill_rule);
+        }
+    });
+
+    bool same = many.size() == sequential.size();
+    for (size_t i = 0; same && i < many.size(); ++i) {
+        same = many[i].size() == sequential[i].size() && SignedArea(many[i]) == SignedArea(sequential[i]);
+    }
+
+    printf("%zu shapes of 32 edges clipped by the viewport: PolygonBooleanMany %.2f ms, one by one %.2f ms (%zu threads)\n",
+           jobs.size(), many_time * 1000, sequential_time * 1000, GetThreadPool().NumThreads());
+    bench.Check(same, "PolygonBooleanMany gives the results of PolygonBoolean");
+}
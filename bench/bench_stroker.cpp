@@ -0,0 +1,314 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "render/stroker.hpp"
+#include "memory/allocation_counter.hpp"
+
+namespace {
+
+struct Triangle {
+    Vector2 a, b, c;
+};
+
+float Cross(Vector2 a, Vector2 b, Vector2 c) {
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// triangles of the strip without the degenerate ones, flipped counts the ones that aren't counter-clockwise on the screen
+std::vector<Triangle> Triangles(std::span<const Vector2> strip, size_t &flipped) {
+    std::vector<Triangle> triangles;
+    flipped = 0;
+    for (size_t i = 2; i < strip.size(); ++i) {
+        // every second triangle of a strip goes the other way
+        Triangle t = i % 2 == 0 ? Triangle { strip[i], strip[i - 2], strip[i - 1] } : Triangle { strip[i], strip[i - 1], strip[i - 2] };
+        float cross = Cross(t.a, t.b, t.c);
+        flipped += cross > 1e-3f;
+        if (std::abs(cross) > 1e-6f) {
+            triangles.push_back(t);
+        }
+    }
+    return triangles;
+}
+
+bool IsInside(const Triangle &t, Vector2 p) {
+    float sign = Cross(t.a, t.b, t.c) < 0 ? -1.f : 1.f;
+    return sign * Cross(t.a, t.b, p) > 0 && sign * Cross(t.b, t.c, p) > 0 && sign * Cross(t.c, t.a, p) > 0;
+}
+
+float SegmentDistance(Vector2 p, Vector2 a, Vector2 b) {
+    Vector2 ab = b - a;
+    float t = std::clamp(Vector2DotProduct(p - a, ab) / Vector2DotProduct(ab, ab), 0.f, 1.f);
+    return Vector2Distance(p, a + ab * t);
+}
+
+float PolylineDistance(std::span<const Vector2> points, Vector2 p) {
+    float distance = INFINITY;
+    for (size_t i = 1; i < points.size(); ++i) {
+        distance = std::min(distance, SegmentDistance(p, points[i - 1], points[i]));
+    }
+    return distance;
+}
+
+// what a grid of samples with step h over [x0, x1] x [y0, y1] finds under the triangles
+struct Coverage {
+    double area = 0;      // of the samples under any triangle
+    size_t overdrawn = 0; // under more than one
+    size_t missed = 0;    // expected inside, but not under any
+    size_t extra = 0;     // expected outside, but under one
+    size_t flipped = 0;   // triangles that aren't counter-clockwise
+};
+
+// expected(p) is 1 inside, 0 outside and -1 where it doesn't matter (near the boundary)
+Coverage Sample(std::span<const Vector2> strip, Rectangle box, float h, const std::function<int(Vector2)> &expected=nullptr) {
+    Coverage coverage;
+    std::vector<Triangle> triangles = Triangles(strip, coverage.flipped);
+    // odd offsets, so the samples don't fall on edges at round coordinates
+    for (float y = box.y + h * 0.5137f; y < box.y + box.height; y += h) {
+        for (float x = box.x + h * 0.4871f; x < box.x + box.width; x += h) {
+            Vector2 p = { x, y };
+            size_t n = 0;
+            for (const Triangle &t : triangles) {
+                n += IsInside(t, p);
+            }
+            coverage.area += n > 0 ? (double) h * h : 0;
+            coverage.overdrawn += n > 1;
+
+            int inside = expected ? expected(p) : -1;
+            coverage.missed += inside == 1 && n == 0;
+            coverage.extra += inside == 0 && n > 0;
+        }
+    }
+    return coverage;
+}
+
+// round joins and caps of width 2r cover the points within r of the polyline, up to ROUND_TOLERANCE
+std::function<int(Vector2)> WithinRadius(std::span<const Vector2> points, float r) {
+    return [points, r](Vector2 p) {
+        float distance = PolylineDistance(points, p);
+        return distance < r - 0.3f ? 1 : (distance > r + 0.05f ? 0 : -1);
+    };
+}
+
+// polylines that cross themselves are covered twice there, so overdraw isn't counted
+bool CoversRadius(const Coverage &coverage) {
+    return coverage.flipped == 0 && coverage.missed == 0 && coverage.extra == 0;
+}
+
+} // namespace
+
+// strips of the Stroker against areas known analytically and against the points within the radius of polylines:
+// every triangle goes counter-clockwise and no point is covered twice; then strokes of 10^6 points
+void BenchStroker(Bench &bench) {
+    Stroker stroker;
+
+    {
+        Vector2 points[] = { { 10, 10 }, { 60, 40 }, { 20, 70 }, { 90, 80 }, { 85, 20 }, { 70, 25 } };
+        StrokeStyle style;
+        style.width = 8;
+        style.join = LineJoin::Round;
+        style.cap = LineCap::Round;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        Coverage coverage = Sample(stroker.strip, { 0, 0, 100, 100 }, 0.25f, WithinRadius(points, 4));
+        bench.Check(CoversRadius(coverage) && coverage.overdrawn == 0, "round joins and caps cover the points within the radius");
+    }
+
+    // an L turning both ways, the miter is the corner of the square and the bevel cuts its half
+    for (float turn : { -100.f, 100.f }) {
+        for (LineJoin join : { LineJoin::Miter, LineJoin::Bevel }) {
+            Vector2 points[] = { { 0, 0 }, { 100, 0 }, { 100, turn } };
+            StrokeStyle style;
+            style.width = 10;
+            style.join = join;
+            stroker.Clear();
+            stroker.Stroke(points, style);
+            Coverage coverage = Sample(stroker.strip, { -10, -110, 120, 220 }, 0.25f);
+            double area = join == LineJoin::Miter ? 2000 : 1987.5;
+            bench.Check(coverage.flipped == 0 && coverage.overdrawn == 0 && std::abs(coverage.area - area) < 3, "area of an L");
+        }
+    }
+
+    {
+        Vector2 points[] = { { 0, 0 }, { 100, 0 }, { 0, 10 } };
+        StrokeStyle style;
+        style.width = 4;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        float max_x = 0;
+        for (Vector2 v : stroker.strip) {
+            max_x = std::max(max_x, v.x);
+        }
+        Coverage coverage = Sample(stroker.strip, { -5, -5, 115, 20 }, 0.1f);
+        bench.Check(max_x < 103, "acute miter over the limit is a bevel");
+        bench.Check(coverage.flipped == 0 && coverage.overdrawn == 0, "acute join has no overdraw");
+    }
+
+    {
+        Vector2 points[] = { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 } };
+        StrokeStyle style;
+        style.width = 10;
+        style.closed = true;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        Coverage closed = Sample(stroker.strip, { -10, -10, 120, 120 }, 0.25f);
+        style.closed = false;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        Coverage open = Sample(stroker.strip, { -10, -10, 120, 120 }, 0.25f);
+        bench.Check(closed.flipped == 0 && closed.overdrawn == 0 && std::abs(closed.area - 4000) < 3, "area of a closed square");
+        bench.Check(std::abs(open.area - 3000) < 3, "area of an open square");
+    }
+
+    {
+        Vector2 points[] = { { 0, 0 }, { 100, 0 } };
+        float even[] = { 10, 10 };
+        float odd[] = { 10 }; // is repeated, so dashes and gaps swap every time
+        for (std::span<const float> dashes : { std::span<const float>(even), std::span<const float>(odd) }) {
+            StrokeStyle style;
+            style.width = 4;
+            style.dashes = dashes;
+            stroker.Clear();
+            stroker.Stroke(points, style);
+            Coverage coverage = Sample(stroker.strip, { -5, -5, 110, 10 }, 0.1f);
+            bench.Check(coverage.flipped == 0 && coverage.overdrawn == 0 && std::abs(coverage.area - 200) < 1, "area of dashes");
+        }
+
+        // with the offset a dash of 5, a gap of 10 and a dash of 10 going around the corner
+        Vector2 corner[] = { { 0, 0 }, { 15, 0 }, { 15, 15 } };
+        StrokeStyle style;
+        style.width = 2;
+        style.dashes = even;
+        style.dash_offset = 5;
+        stroker.Clear();
+        stroker.Stroke(corner, style);
+        Coverage coverage = Sample(stroker.strip, { -3, -3, 21, 21 }, 0.05f);
+        bench.Check(coverage.flipped == 0 && coverage.overdrawn == 0 && std::abs(coverage.area - 30) < 0.5, "dash goes on over a corner");
+
+        // dashes of zero length with round caps are dots, octagons at this radius
+        float dots[] = { 0, 10 };
+        style = StrokeStyle();
+        style.width = 4;
+        style.cap = LineCap::Round;
+        style.dashes = dots;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        coverage = Sample(stroker.strip, { -5, -5, 110, 10 }, 0.05f);
+        double octagon = 2 * std::sqrt(2.0) * 4;
+        bench.Check(coverage.flipped == 0 && coverage.overdrawn == 0 && std::abs(coverage.area - 11 * octagon) < 1, "area of dots");
+    }
+
+    {
+        Vector2 points[] = { { 0, 0 }, { 50, 0 }, { 100, 0 } };
+        float widths[] = { 2, 11, 20 };
+        StrokeStyle style;
+        style.widths = widths;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        Coverage coverage = Sample(stroker.strip, { -5, -15, 110, 30 }, 0.1f);
+        bench.Check(coverage.flipped == 0 && coverage.overdrawn == 0 && std::abs(coverage.area - 1100) < 2, "area of a varying width");
+
+        Vector2 line[] = { { 0, 0 }, { 100, 0 } };
+        style = StrokeStyle();
+        style.width = 10;
+        style.cap = LineCap::Square;
+        stroker.Clear();
+        stroker.Stroke(line, style);
+        coverage = Sample(stroker.strip, { -10, -10, 120, 20 }, 0.25f);
+        bench.Check(std::abs(coverage.area - 1100) < 2, "area of square caps");
+    }
+
+    {
+        // segments shorter than the width, their inner sides don't cross
+        Vector2 points[] = { { 0, 0 }, { 50, 0 }, { 52, 3 }, { 50, 6 }, { 0, 6 } };
+        StrokeStyle style;
+        style.width = 10;
+        style.join = LineJoin::Round;
+        style.cap = LineCap::Round;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        Coverage coverage = Sample(stroker.strip, { -10, -10, 75, 30 }, 0.1f, WithinRadius(points, 5));
+        bench.Check(CoversRadius(coverage), "hairpin has no gaps and no flipped triangles");
+    }
+
+    // random polylines of long and short segments
+    std::mt19937 rng(47);
+    std::uniform_real_distribution<float> coordinate(0, 40);
+    std::uniform_real_distribution<float> step(-3, 3);
+    std::uniform_real_distribution<float> radius(0.5f, 6.5f);
+    bool random_covered = true;
+    size_t random_flipped = 0;
+    for (size_t test = 0; test < bench.Size(300, 30); ++test) {
+        std::vector<Vector2> points(2 + rng() % 8);
+        for (size_t i = 0; i < points.size(); ++i) {
+            points[i] = test % 2 == 0 || i == 0 ? Vector2 { coordinate(rng), coordinate(rng) } : points[i - 1] + Vector2 { step(rng), step(rng) };
+        }
+        float r = radius(rng);
+
+        StrokeStyle style;
+        style.width = 2 * r;
+        style.join = LineJoin::Round;
+        style.cap = LineCap::Round;
+        stroker.Clear();
+        stroker.Stroke(points, style);
+        random_covered = random_covered && CoversRadius(Sample(stroker.strip, { -10, -10, 60, 60 }, 0.2f, WithinRadius(points, r)));
+
+        for (LineJoin join : { LineJoin::Miter, LineJoin::Bevel }) {
+            style.join = join;
+            style.cap = LineCap::Square;
+            style.closed = test % 3 == 0;
+            stroker.Clear();
+            stroker.Stroke(points, style);
+            size_t flipped;
+            Triangles(stroker.strip, flipped);
+            random_flipped += flipped;
+        }
+    }
+    bench.Check(random_covered, "random polylines with round joins cover the points within the radius");
+    bench.Check(random_flipped == 0, "random polylines with miters and bevels have no flipped triangles");
+
+    // a sine of 10^6 points and a dashed zigzag, strokes after the first one reuse the buffers
+    std::vector<Vector2> sine(bench.Size(1'000'000, 10'000));
+    for (size_t i = 0; i < sine.size(); ++i) {
+        float t = (float) i * 0.001f;
+        sine[i] = { t * 10, 100 * std::sin(t) };
+    }
+    std::vector<Vector2> zigzag(sine.size());
+    for (size_t i = 0; i < zigzag.size(); ++i) {
+        zigzag[i] = { (float) i, (float) (i % 2) * 30 };
+    }
+
+    float dashes[] = { 20, 10 };
+    const char *join_names[] = { "miter", "round", "bevel" };
+    for (LineJoin join : { LineJoin::Miter, LineJoin::Round }) {
+        for (bool dashed : { false, true }) {
+            const std::vector<Vector2> &points = dashed ? zigzag : sine;
+            StrokeStyle style;
+            style.width = 3;
+            style.join = join;
+            if (dashed) {
+                style.dashes = dashes;
+            }
+
+            stroker.Clear();
+            stroker.Stroke(points, style);
+            AllocationCounters start = GetAllocationCounters();
+            double time = bench.Time([&] {
+                stroker.Clear();
+                stroker.Stroke(points, style);
+            });
+            AllocationCounters allocations = GetAllocationCounters() - start;
+
+            printf("%zu points of a %s, %s joins: %6.2f ms (%5.2f ns/point), %zu vertexes, %zu allocations\n",
+                   points.size(), dashed ? "dashed zigzag" : "sine", join_names[(int) join],
+                   time * 1000, time / (double) points.size() * 1e9, stroker.strip.size(), allocations.allocations);
+            bench.Check(allocations.allocations == 0, "stroke into the buffers of the previous one doesn't allocate");
+        }
+    }
+}
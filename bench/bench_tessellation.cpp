@@ -0,0 +1,76 @@
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "geometry/bezier.hpp"
+#include "parallel/thread_pool.hpp"
+
+// bulk tessellation of quadratic curves like in SceneBezier on pools of 1..N threads
+void BenchTessellation(Bench &bench) {
+    const size_t ncurves = bench.Size(100'000, 2'000);
+    // curves per task, same as SceneBezier
+    const size_t grain = 64;
+
+    std::mt19937 rng(30);
+    std::uniform_real_distribution<float> coordinate(0, 1000);
+
+    std::vector<BezierCurve> curves;
+    curves.reserve(ncurves);
+    for (size_t i = 0; i < ncurves; ++i) {
+        curves.emplace_back(std::pmr::deque<Point> { { coordinate(rng), coordinate(rng) },
+                                                     { coordinate(rng), coordinate(rng) },
+                                                     { coordinate(rng), coordinate(rng) } });
+    }
+    // every pool must produce exactly the points of the sequential run
+    std::vector<std::pmr::vector<Point>> expected;
+    for (const BezierCurve &curve : curves) {
+        expected.push_back(curve.curve_points);
+    }
+
+    // speedup is only meaningful up to the number of hardware threads
+    size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 4);
+    printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    double single_time = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        ThreadPool pool(threads);
+
+        for (BezierCurve &curve : curves) {
+            curve.curve_points.clear();
+        }
+        std::vector<int> visits(ncurves, 0);
+        pool.ParallelFor(ncurves, grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                ++visits[i];
+                curves[i].Update();
+            }
+        });
+        bench.Check(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }),
+                    "ParallelFor visits every curve once");
+
+        bool same = true;
+        for (size_t i = 0; i < ncurves; ++i) {
+            const auto &points = curves[i].curve_points;
+            same = same && points.size() == expected[i].size() &&
+                   memcmp(points.data(), expected[i].data(), points.size() * sizeof(Point)) == 0;
+        }
+        bench.Check(same, "parallel tessellation is the same as sequential");
+
+        double time = bench.Time([&] {
+            pool.ParallelFor(ncurves, grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    curves[i].Update();
+                }
+            });
+        });
+        if (threads == 1) {
+            single_time = time;
+        }
+
+        printf("%zu curves on %zu threads: %.2f ms, speedup %.2f\n", ncurves, threads, time * 1000, single_time / time);
+    }
+}
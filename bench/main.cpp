@@ -0,0 +1,68 @@
+#include <raylib.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "bench.hpp"
+
+struct Benchmark {
+    const char *name;
+    void (*run)(Bench &bench);
+};
+
+const Benchmark BENCHMARKS[] = {
+    { "bezier",          BenchBezier },
+    { "tessellation",    BenchTessellation },
+    { "convex_hull",     BenchConvexHull },
+    { "polygon_boolean", BenchPolygonBoolean },
+    { "stroker",         BenchStroker },
+    { "point_location",  BenchPointLocation },
+    { "delaunay",        BenchDelaunay },
+    { "memory",          BenchMemory },
+};
+
+// bench [--quick] [name...], without names every benchmark is run
+int main(int argc, char **argv) {
+    SetTraceLogLevel(LOG_WARNING);
+
+    Bench bench;
+    std::vector<const char *> names;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            bench.quick = true;
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+
+    for (const char *name : names) {
+        bool known = false;
+        for (const Benchmark &benchmark : BENCHMARKS) {
+            known = known || strcmp(benchmark.name, name) == 0;
+        }
+        if (!known) {
+            printf("unknown benchmark '%s'\n", name);
+            return 1;
+        }
+    }
+
+    for (const Benchmark &benchmark : BENCHMARKS) {
+        bool selected = names.empty();
+        for (const char *name : names) {
+            selected = selected || strcmp(benchmark.name, name) == 0;
+        }
+        if (!selected) {
+            continue;
+        }
+
+        printf("== %s\n", benchmark.name);
+        benchmark.run(bench);
+    }
+
+    if (bench.failures > 0) {
+        printf("%zu checks failed\n", bench.failures);
+        return 1;
+    }
+    return 0;
+}
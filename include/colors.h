@@ -8,6 +8,8 @@
 #define COLOR_POINT_PRIMARY   RED
 #define COLOR_POINT_SECONDARY PURPLE
 
+#define COLOR_SELECTION SKYBLUE
+
 #define COLOR_BACKGROUND (GetColor(0x181818ff))
 
 #define COLOR_GRAY_FADED (Fade(GRAY, 0.3f))
\ No newline at end of file
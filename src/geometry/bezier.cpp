@@ -3,27 +3,52 @@
 
 #include "bezier.hpp"
 
-BezierCurve::BezierCurve(int bezier_segments) : bezier_segments(bezier_segments) {
+#include "render/render.hpp"
+#include "memory/allocation_counter.hpp"
+
+BezierCurve::BezierCurve(int bezier_segments, const allocator_type &alloc) :
+    control_points(alloc), curve_points(alloc), bezier_segments(bezier_segments)
+{
     curve_points.reserve(bezier_segments + 1);
 }
 
+BezierCurve::BezierCurve(const BezierCurve &other, const allocator_type &alloc) :
+    control_points(other.control_points, alloc),
+    curve_points(other.curve_points, alloc),
+    bezier_segments(other.bezier_segments)
+{}
+
+BezierCurve::BezierCurve(BezierCurve &&other, const allocator_type &alloc) :
+    control_points(std::move(other.control_points), alloc),
+    curve_points(std::move(other.curve_points), alloc),
+    bezier_segments(other.bezier_segments)
+{}
+
 void BezierCurve::DrawControlPoints(Color color_points, Color color_lines) const {
-    for (int i = 1; (size_t) i < control_points.size(); ++i) {
-        DrawLineDotted(control_points[i - 1], control_points[i], 20, 3, color_lines);
-    }
+    Render::DrawPolylineDotted(control_points, 20, 3, color_lines);
     for (int i = 0; (size_t) i < control_points.size(); ++i) {
-        DrawCircleV(control_points[i], 7, color_points);
+        Render::DrawCircle(control_points[i], 7, color_points);
     }
 }
 
 void BezierCurve::DrawCurve(Color color) const {
     for (int i = 1; (size_t) i < curve_points.size(); ++i) {
-        DrawLineV(curve_points[i - 1], curve_points[i], color);
+        Render::DrawLine(curve_points[i - 1], curve_points[i], color);
     }
 }
 
 void BezierCurve::Update() {
-    // calculate bezier curve
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    // dispatch once to the evaluator of the fixed order
+    bool evaluated = VisitBezier(control_points, [this](const auto &bezier) {
+        bezier.EvaluateUniform(bezier_segments, curve_points);
+    });
+    if (evaluated) {
+        return;
+    }
+
+    // calculate bezier curve of arbitrary order
     auto bezier_func = BezierFunc(control_points);
     if (!bezier_func) {
         TraceLog(LOG_WARNING, "%s: Failed to compure bezier_func", std::source_location::current().function_name());
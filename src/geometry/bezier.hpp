@@ -3,6 +3,13 @@
 #include "geometry.hpp"
 
 #include <functional>
+#include <vector>
+#include <array>
+#include <span>
+#include <utility>
+#include <cassert>
+#include <iterator>
+#include <memory_resource>
 
 inline std::function<Point(float)> BezierFuncLinear(Point p1, Point p2) {
     return [p1, p2](float t) -> Point {
@@ -24,6 +31,189 @@ inline std::function<Point(float)> BezierFuncCubic(Point p1, Point p2, Point p3,
     };
 }
 
+// binomial coefs ```(order choose i) = order! / (i! * (order - i)!)``` calculated at compile time
+template <size_t Order>
+constexpr std::array<float, Order + 1> BinomialCoefs() {
+    std::array<float, Order + 1> coefs {};
+
+    unsigned long long coef = 1;
+    for (size_t i = 0; i <= Order; ++i) {
+        coefs[i] = (float) coef;
+        coef = coef * (Order - i) / (i + 1);
+    }
+    return coefs;
+}
+
+// bezier curve of order known at compile time
+// evaluation does not allocate and all the loops over control points are unrolled
+template <size_t Order> requires (Order > 0)
+struct Bezier {
+    static constexpr size_t NPOINTS = Order + 1;
+    static constexpr std::array<float, NPOINTS> BINOMIAL_COEFS = BinomialCoefs<Order>();
+
+    // control points multiplied by binomial coefs
+    std::array<Point, NPOINTS> coefs {};
+
+    Bezier() = default;
+
+    explicit Bezier(const RangeOf<Point> auto &control_points) {
+        assert(std::ranges::size(control_points) == NPOINTS);
+
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            ((coefs[I] = control_points[I] * BINOMIAL_COEFS[I]), ...);
+        }(std::make_index_sequence<NPOINTS>{});
+    }
+
+    /*
+        Horner's scheme for ```f(t) = (1 - t)^order * sum i=[0..order] { coefs[i] * s^i }``` where ```s = t / (1 - t)```.
+        s grows unbounded near t = 1, so for t > 0.5 the same is done in reverse with ```s = (1 - t) / t```
+    */
+    Point operator()(float t) const {
+        float u = 1 - t;
+
+        Point res = Vector2Zeros;
+        float scale = 1.f;
+
+        if (t <= 0.5f) {
+            float s = t / u;
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((res = res * s + coefs[Order - I], scale *= (I < Order ? u : 1.f)), ...);
+            }(std::make_index_sequence<NPOINTS>{});
+        } else {
+            float s = u / t;
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((res = res * s + coefs[I], scale *= (I < Order ? t : 1.f)), ...);
+            }(std::make_index_sequence<NPOINTS>{});
+        }
+
+        return res * scale;
+    }
+
+    // evaluate the curve at every t from ts, out must be at least of the same size
+    void Evaluate(std::span<const float> ts, std::span<Point> out) const {
+        assert(out.size() >= ts.size());
+
+        size_t i = 0;
+        for (; i + BATCH_LANES <= ts.size(); i += BATCH_LANES) {
+            EvaluateLanes(&ts[i], &out[i]);
+        }
+        for (; i < ts.size(); ++i) {
+            out[i] = (*this)(ts[i]);
+        }
+    }
+
+    // evaluate the curve at segments + 1 uniformly distributed t
+    // out keeps its capacity, so nothing is allocated when it is reused
+    void EvaluateUniform(int segments, std::pmr::vector<Point> &out) const {
+        out.resize(segments + 1);
+
+        float step = 1.f / (float) segments;
+
+        std::array<float, BATCH_LANES> ts;
+        int i = 0;
+        for (; i + (int) BATCH_LANES <= segments; i += BATCH_LANES) {
+            for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                ts[lane] = (float) (i + lane) * step;
+            }
+            EvaluateLanes(ts.data(), &out[i]);
+        }
+        for (; i < segments; ++i) {
+            out[i] = (*this)((float) i * step);
+        }
+        // make the end point exact
+        out[segments] = coefs[Order];
+    }
+
+private:
+    // a single horner chain is bound by latency of multiply-add,
+    // so several independent points are evaluated side by side
+    static constexpr size_t BATCH_LANES = 8;
+
+    Point Bernstein(float t) const {
+        float u = 1 - t;
+
+        std::array<float, NPOINTS> u_pow;
+        u_pow[Order] = 1.f;
+        for (size_t i = Order; i-- > 0;) {
+            u_pow[i] = u_pow[i + 1] * u;
+        }
+
+        Point res = Vector2Zeros;
+        float t_pow = 1.f;
+        for (size_t i = 0; i < NPOINTS; ++i) {
+            res += coefs[i] * (t_pow * u_pow[i]);
+            t_pow *= t;
+        }
+        return res;
+    }
+
+    // same as operator() for BATCH_LANES values of t at once
+    void EvaluateLanes(const float *ts, Point *out) const {
+        if constexpr (Order <= 4) {
+            // bernstein form with explicit powers: no division, cheapest for low orders
+            // it is short enough for the compiler to vectorize the loop over lanes by itself
+            for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                out[lane] = Bernstein(ts[lane]);
+            }
+        } else {
+            // horner's scheme has the shortest chain for high orders
+            bool forward = ts[0] <= 0.5f;
+            for (size_t lane = 1; lane < BATCH_LANES; ++lane) {
+                // lanes must agree on direction of the horner's scheme
+                if ((ts[lane] <= 0.5f) != forward) {
+                    for (size_t i = 0; i < BATCH_LANES; ++i) {
+                        out[i] = (*this)(ts[i]);
+                    }
+                    return;
+                }
+            }
+
+            std::array<float, BATCH_LANES> s, scale, x {}, y {};
+            for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                float t = ts[lane];
+                float u = 1 - t;
+                float base = forward ? u : t;
+
+                s[lane]     = forward ? t / u : u / t;
+                scale[lane] = 1.f;
+                for (size_t i = 0; i < Order; ++i) {
+                    scale[lane] *= base;
+                }
+            }
+
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                ((
+                    [&] {
+                        Point c = forward ? coefs[Order - I] : coefs[I];
+                        for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                            x[lane] = x[lane] * s[lane] + c.x;
+                            y[lane] = y[lane] * s[lane] + c.y;
+                        }
+                    }()
+                ), ...);
+            }(std::make_index_sequence<NPOINTS>{});
+
+            for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+                out[lane] = Point { x[lane] * scale[lane], y[lane] * scale[lane] };
+            }
+        }
+    }
+};
+
+// orders up to this one are dispatched to Bezier<Order>
+static constexpr size_t MAX_STATIC_BEZIER_ORDER = 16;
+
+// call func(Bezier<order>) with order matching control_points.size() - 1
+// returns false if the order is not in [1..MAX_STATIC_BEZIER_ORDER]
+template <typename Func>
+bool VisitBezier(const RangeOf<Point> auto &control_points, Func &&func) {
+    size_t order = std::ranges::size(control_points) - 1;
+
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+        return ((order == I + 1 ? (func(Bezier<I + 1>(control_points)), true) : false) || ...);
+    }(std::make_index_sequence<MAX_STATIC_BEZIER_ORDER>{});
+}
+
 // get function of bezier curve of order control_points.size() - 1
 std::function<Point(float)> BezierFunc(const RangeOf<Point> auto &control_points) {
     switch (auto size = std::ranges::size(control_points)) {
@@ -37,6 +227,11 @@ std::function<Point(float)> BezierFunc(const RangeOf<Point> auto &control_points
         case 4:
             return BezierFuncCubic(control_points[0], control_points[1], control_points[2], control_points[3]);
         default: {
+            std::function<Point(float)> func;
+            if (VisitBezier(control_points, [&func](auto bezier) { func = bezier; })) {
+                return func;
+            }
+
             std::vector<Point> coefs(size);
             size_t order = size - 1;
 
@@ -75,26 +270,77 @@ std::function<Point(float)> BezierFunc(const RangeOf<Point> auto &control_points
     }
 }
 
+// split bezier curve at t into two curves of the same order (de Casteljau's algorithm)
+// last point of the first curve is the first point of the second one
+std::pair<std::pmr::deque<Point>, std::pmr::deque<Point>>
+SplitBezier(const RangeOf<Point> auto &control_points, float t, std::pmr::polymorphic_allocator<> alloc={}) {
+    std::pmr::vector<Point> points(std::ranges::begin(control_points), std::ranges::end(control_points), alloc);
+
+    std::pmr::deque<Point> left(alloc);
+    std::pmr::deque<Point> right(alloc);
+    if (points.empty()) {
+        return { left, right };
+    }
+
+    // each pass lerps neighbours in place, first and last lerped points are the new inner points
+    left.push_back(points.front());
+    right.push_front(points.back());
+    for (size_t size = points.size(); size > 1; --size) {
+        for (size_t i = 0; i + 1 < size; ++i) {
+            points[i] = Lerp(points[i], points[i + 1], t);
+        }
+        left.push_back(points.front());
+        right.push_front(points[size - 2]);
+    }
+
+    return { std::move(left), std::move(right) };
+}
+
 struct BezierCurve {
-    std::deque<Point> control_points;
-    std::vector<Point> curve_points;
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    std::pmr::deque<Point> control_points;
+    std::pmr::vector<Point> curve_points;
     int bezier_segments;
-    
-    BezierCurve(int bezier_segments=100);
-    
-    BezierCurve(std::deque<Point> points, int bezier_segments=100) :
-        control_points(std::move(points)), bezier_segments(bezier_segments)
+
+    static const int DEFAULT_SEGMENTS = 100;
+
+    BezierCurve() : BezierCurve(DEFAULT_SEGMENTS) {}
+    explicit BezierCurve(int bezier_segments, const allocator_type &alloc={});
+    explicit BezierCurve(const allocator_type &alloc) : BezierCurve(DEFAULT_SEGMENTS, alloc) {}
+
+    BezierCurve(std::pmr::deque<Point> points, int bezier_segments=DEFAULT_SEGMENTS, const allocator_type &alloc={}) :
+        control_points(std::move(points), alloc), curve_points(alloc), bezier_segments(bezier_segments)
     {
+        curve_points.reserve(bezier_segments + 1);
         Update();
         TraceLog(LOG_DEBUG, "Created curve! %i control points, %i curve points", control_points.size(), curve_points.size());
     }
+    BezierCurve(std::pmr::deque<Point> points, const allocator_type &alloc) :
+        BezierCurve(std::move(points), DEFAULT_SEGMENTS, alloc)
+    {}
+
+    BezierCurve(const BezierCurve &) = default;
+    BezierCurve(BezierCurve &&) = default;
+    BezierCurve(const BezierCurve &other, const allocator_type &alloc);
+    BezierCurve(BezierCurve &&other, const allocator_type &alloc);
 
-    void SetControlPoints(std::deque<Point> points) {
+    BezierCurve &operator=(const BezierCurve &) = default;
+    BezierCurve &operator=(BezierCurve &&) = default;
+
+    void SetControlPoints(std::pmr::deque<Point> points) {
         control_points = std::move(points);
         Update();
     }
 
+    // copies points in place, so nothing is allocated when the number of points does not change
+    template <std::forward_iterator Iterator>
+    void SetControlPoints(Iterator first, Iterator last) {
+        control_points.assign(first, last);
+        Update();
+    }
+
     void DrawControlPoints(Color color_points, Color color_lines=BLANK) const;
     void DrawCurve(Color color) const;
     void Update();
-};
\ No newline at end of file
+};
@@ -0,0 +1,340 @@
+#include "bezier_bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// bezier point and its derivatives at t
+struct BezierDerivatives {
+    Point point = Vector2Zeros;
+    Point d1    = Vector2Zeros;
+    Point d2    = Vector2Zeros;
+};
+
+// control points are copied to the stack so evaluation never allocates
+constexpr size_t MAX_NEWTON_CONTROL_POINTS = 32;
+
+BezierDerivatives EvaluateWithDerivatives(const std::pmr::deque<Point> &control_points, float t) {
+    std::array<Point, MAX_NEWTON_CONTROL_POINTS> points;
+
+    size_t size = control_points.size();
+    assert(size >= 2 && size <= MAX_NEWTON_CONTROL_POINTS);
+
+    std::copy(control_points.begin(), control_points.end(), points.begin());
+
+    float order = (float) (size - 1);
+
+    // de Casteljau: stop when 3 points are left, they give us the second derivative
+    BezierDerivatives res;
+    for (; size > 3; --size) {
+        for (size_t i = 0; i + 1 < size; ++i) {
+            points[i] = Lerp(points[i], points[i + 1], t);
+        }
+    }
+
+    if (size == 3) {
+        res.d2 = (points[2] - points[1] * 2 + points[0]) * (order * (order - 1));
+
+        points[0] = Lerp(points[0], points[1], t);
+        points[1] = Lerp(points[1], points[2], t);
+    }
+
+    res.d1    = (points[1] - points[0]) * order;
+    res.point = Lerp(points[0], points[1], t);
+
+    return res;
+}
+
+float DistanceSqr(Point a, Point b) {
+    Point d = a - b;
+    return d.x * d.x + d.y * d.y;
+}
+
+// squared distance from p to axis aligned box, 0 if p is inside
+float BoxDistanceSqr(Point p, Point min, Point max) {
+    float dx = std::max({ min.x - p.x, 0.f, p.x - max.x });
+    float dy = std::max({ min.y - p.y, 0.f, p.y - max.y });
+    return dx * dx + dy * dy;
+}
+
+} // namespace
+
+std::pair<float, Point> ClosestPointOnCurve(const BezierCurve &curve, Point p, int newton_iterations) {
+    const auto &control_points = curve.control_points;
+    const auto &curve_points   = curve.curve_points;
+
+    if (control_points.empty()) {
+        return { 0.f, Vector2Zeros };
+    }
+    if (control_points.size() == 1 || curve_points.size() < 2) {
+        return { 0.f, control_points.front() };
+    }
+
+    // curve points are uniform in t so the closest segment gives a good initial guess
+    float best_t = 0.f;
+    Point best_point = curve_points.front();
+    float best_dist = DistanceSqr(p, best_point);
+
+    size_t nsegments = curve_points.size() - 1;
+    for (size_t i = 0; i < nsegments; ++i) {
+        Point a = curve_points[i];
+        Point ab = curve_points[i + 1] - a;
+
+        float len_sqr = ab.x * ab.x + ab.y * ab.y;
+        float s = len_sqr > 0 ? Clamp(Vector2DotProduct(p - a, ab) / len_sqr, 0.f, 1.f) : 0.f;
+
+        Point q = a + ab * s;
+        if (float d = DistanceSqr(p, q); d < best_dist) {
+            best_dist  = d;
+            best_point = q;
+            best_t     = ((float) i + s) / (float) nsegments;
+        }
+    }
+
+    if (control_points.size() > MAX_NEWTON_CONTROL_POINTS) {
+        return { best_t, best_point };
+    }
+
+    // minimize |B(t) - p|^2, i.e. find root of f(t) = (B(t) - p) * B'(t)
+    // f'(t) = B'(t) * B'(t) + (B(t) - p) * B''(t)
+    float t = best_t;
+    for (int i = 0; i < newton_iterations; ++i) {
+        auto [point, d1, d2] = EvaluateWithDerivatives(control_points, t);
+
+        Point diff = point - p;
+        float f  = Vector2DotProduct(diff, d1);
+        float df = Vector2DotProduct(d1, d1) + Vector2DotProduct(diff, d2);
+
+        if (FloatEquals(df, 0)) {
+            break;
+        }
+
+        float next_t = Clamp(t - f / df, 0.f, 1.f);
+        if (FloatEquals(next_t, t)) {
+            t = next_t;
+            break;
+        }
+        t = next_t;
+    }
+
+    // newton may diverge near cusps, so keep the polyline result if it is better
+    Point point = EvaluateWithDerivatives(control_points, t).point;
+    if (DistanceSqr(p, point) <= best_dist) {
+        return { t, point };
+    }
+    return { best_t, best_point };
+}
+
+void BezierBVH::Clear() {
+    nodes.clear();
+    items.clear();
+    leaves.clear();
+    root = -1;
+}
+
+void BezierBVH::Build(std::span<const BezierCurveRef> curves) {
+    Clear();
+
+    items.assign(curves.begin(), curves.end());
+    if (items.empty()) {
+        return;
+    }
+
+    for (auto &item : items) {
+        assert(item.curve && "BezierBVH: curve is null");
+
+        if (leaves.size() <= item.set_idx) {
+            leaves.resize(item.set_idx + 1);
+        }
+        auto &set_leaves = leaves[item.set_idx];
+        if (set_leaves.size() <= item.curve_idx) {
+            set_leaves.resize(item.curve_idx + 1, -1);
+        }
+    }
+
+    // binary tree with one item per leaf has exactly 2n - 1 nodes
+    nodes.reserve(2 * items.size() - 1);
+
+    std::vector<int> order(items.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // curves are split by centroids of their end points
+    std::vector<Point> centroids(items.size(), Vector2Zeros);
+    for (size_t i = 0; i < items.size(); ++i) {
+        const auto &control_points = items[i].curve->control_points;
+        if (!control_points.empty()) {
+            centroids[i] = (control_points.front() + control_points.back()) / 2;
+        }
+    }
+
+    root = BuildRange(order, centroids, 0, order.size(), -1);
+}
+
+int BezierBVH::BuildRange(std::vector<int> &order, const std::vector<Point> &centroids,
+                          size_t begin, size_t end, int parent) {
+    assert(begin < end);
+
+    int node_idx = (int) nodes.size();
+    nodes.emplace_back();
+    nodes[node_idx].parent = parent;
+
+    if (end - begin == 1) {
+        int item_idx = order[begin];
+        nodes[node_idx].item = item_idx;
+        FitLeaf(nodes[node_idx]);
+
+        const auto &item = items[item_idx];
+        leaves[item.set_idx][item.curve_idx] = node_idx;
+
+        return node_idx;
+    }
+
+    // median split along the longest axis of centroids' bounds
+    Point min = centroids[order[begin]];
+    Point max = min;
+    for (size_t i = begin + 1; i < end; ++i) {
+        min = Vector2Min(min, centroids[order[i]]);
+        max = Vector2Max(max, centroids[order[i]]);
+    }
+
+    bool split_x = max.x - min.x >= max.y - min.y;
+    size_t middle = begin + (end - begin) / 2;
+
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     [&](int a, int b) {
+                         return split_x ? centroids[a].x < centroids[b].x : centroids[a].y < centroids[b].y;
+                     });
+
+    // nodes may reallocate during recursion so don't hold references across it
+    int left  = BuildRange(order, centroids, begin, middle, node_idx);
+    int right = BuildRange(order, centroids, middle, end, node_idx);
+
+    nodes[node_idx].left  = left;
+    nodes[node_idx].right = right;
+    FitInner(nodes[node_idx]);
+
+    return node_idx;
+}
+
+void BezierBVH::FitLeaf(Node &node) const {
+    const auto &control_points = items[node.item].curve->control_points;
+    if (control_points.empty()) {
+        node.min = node.max = Vector2Zeros;
+        return;
+    }
+
+    node.min = node.max = control_points.front();
+    for (Point p : control_points) {
+        node.min = Vector2Min(node.min, p);
+        node.max = Vector2Max(node.max, p);
+    }
+}
+
+void BezierBVH::FitInner(Node &node) const {
+    const Node &left  = nodes[node.left];
+    const Node &right = nodes[node.right];
+    node.min = Vector2Min(left.min, right.min);
+    node.max = Vector2Max(left.max, right.max);
+}
+
+void BezierBVH::Refit(size_t set_idx, size_t curve_idx) {
+    if (set_idx >= leaves.size() || curve_idx >= leaves[set_idx].size()) {
+        return;
+    }
+
+    int node_idx = leaves[set_idx][curve_idx];
+    if (node_idx == -1) {
+        return;
+    }
+
+    FitLeaf(nodes[node_idx]);
+
+    // stop as soon as parent's bounds did not change
+    for (int parent = nodes[node_idx].parent; parent != -1; parent = nodes[parent].parent) {
+        Node &node = nodes[parent];
+        Point old_min = node.min;
+        Point old_max = node.max;
+
+        FitInner(node);
+        if (node.min == old_min && node.max == old_max) {
+            break;
+        }
+    }
+}
+
+void BezierBVH::RefitAll() {
+    // children are always created after their parents, so reverse order is bottom-up
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+        if (it->IsLeaf()) {
+            FitLeaf(*it);
+        } else {
+            FitInner(*it);
+        }
+    }
+}
+
+size_t BezierBVH::MemoryUsage() const {
+    size_t bytes = nodes.capacity() * sizeof(Node) + items.capacity() * sizeof(BezierCurveRef) +
+                   leaves.capacity() * sizeof(std::vector<int>);
+    for (const auto &set_leaves : leaves) {
+        bytes += set_leaves.capacity() * sizeof(int);
+    }
+    return bytes;
+}
+
+std::optional<BezierHit> BezierBVH::Closest(Point p, float max_distance) const {
+    if (root == -1) {
+        return std::nullopt;
+    }
+
+    float best_dist_sqr = max_distance * max_distance;
+    std::optional<BezierHit> best;
+
+    // median split keeps the tree balanced, so its depth is ~log2(n) and the stack never overflows
+    struct Entry {
+        int node;
+        float dist_sqr;
+    };
+    std::array<Entry, 128> stack;
+    size_t stack_size = 0;
+
+    stack[stack_size++] = { root, BoxDistanceSqr(p, nodes[root].min, nodes[root].max) };
+
+    while (stack_size > 0) {
+        auto [node_idx, dist_sqr] = stack[--stack_size];
+        if (dist_sqr > best_dist_sqr) {
+            continue;
+        }
+
+        const Node &node = nodes[node_idx];
+
+        if (node.IsLeaf()) {
+            const auto &item = items[node.item];
+
+            auto [t, point] = ClosestPointOnCurve(*item.curve, p);
+            if (float d = DistanceSqr(p, point); d <= best_dist_sqr) {
+                best_dist_sqr = d;
+                best = BezierHit { item.set_idx, item.curve_idx, t, std::sqrt(d), point };
+            }
+            continue;
+        }
+
+        Entry left  = { node.left,  BoxDistanceSqr(p, nodes[node.left].min,  nodes[node.left].max)  };
+        Entry right = { node.right, BoxDistanceSqr(p, nodes[node.right].min, nodes[node.right].max) };
+
+        // visit nearer child first
+        if (left.dist_sqr < right.dist_sqr) {
+            std::swap(left, right);
+        }
+
+        assert(stack_size + 2 <= stack.size() && "BezierBVH: tree is too deep");
+        stack[stack_size++] = left;
+        stack[stack_size++] = right;
+    }
+
+    return best;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <optional>
+#include <limits>
+
+#include "geometry.hpp"
+#include "bezier.hpp"
+
+// curve that is stored in BezierBVH
+// (set_idx, curve_idx) is what is reported back by queries
+struct BezierCurveRef {
+    size_t set_idx   = 0;
+    size_t curve_idx = 0;
+    const BezierCurve *curve = nullptr;
+};
+
+// result of the closest point query
+struct BezierHit {
+    size_t set_idx   = 0;
+    size_t curve_idx = 0;
+    float t          = 0.f;   // curve parameter of the closest point
+    float distance   = 0.f;
+    Point point      = Vector2Zeros;
+};
+
+// bounding volume hierarchy over bezier curves
+// curves are bound by boxes of their control points (curve always lies inside the hull of them)
+struct BezierBVH {
+    struct Node {
+        Point min = Vector2Zeros;
+        Point max = Vector2Zeros;
+
+        int parent = -1;
+        int left   = -1;
+        int right  = -1;
+        int item   = -1; // index in items if node is a leaf, otherwise -1
+
+        bool IsLeaf() const {
+            return item != -1;
+        }
+    };
+
+    std::vector<Node> nodes;
+    std::vector<BezierCurveRef> items;
+    int root = -1;
+
+    // [set_idx][curve_idx] -> leaf node, so edited curve can be found in O(1)
+    std::vector<std::vector<int>> leaves;
+
+    static constexpr int NEWTON_ITERATIONS = 6;
+
+    void Clear();
+    void Build(std::span<const BezierCurveRef> curves);
+
+    // recompute bounds of a single edited curve and propagate them up to the root
+    void Refit(size_t set_idx, size_t curve_idx);
+    // recompute bounds of every node (e.g. after all the curves were edited at once)
+    void RefitAll();
+
+    std::optional<BezierHit> Closest(Point p, float max_distance=std::numeric_limits<float>::infinity()) const;
+
+    size_t Size() const {
+        return items.size();
+    }
+    // bytes held by nodes, items and leaves
+    size_t MemoryUsage() const;
+
+private:
+    int BuildRange(std::vector<int> &order, const std::vector<Point> &centroids,
+                   size_t begin, size_t end, int parent);
+    void FitLeaf(Node &node) const;
+    void FitInner(Node &node) const;
+};
+
+// closest point on a single curve
+// initial guess is taken from the curve's polyline and then refined with newton iterations
+// returns pair (t, point)
+std::pair<float, Point> ClosestPointOnCurve(const BezierCurve &curve, Point p, int newton_iterations=BezierBVH::NEWTON_ITERATIONS);
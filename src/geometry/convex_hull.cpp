@@ -0,0 +1,228 @@
+#include "convex_hull.hpp"
+
+#include "parallel/thread_pool.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <array>
+#include <limits>
+#include <cassert>
+
+namespace {
+
+struct HullPoint {
+    Point point;
+    uint32_t idx;
+};
+
+bool Less(const HullPoint &a, const HullPoint &b) {
+    return a.point.x < b.point.x || (a.point.x == b.point.x && a.point.y < b.point.y);
+}
+
+// both chains go from the leftmost point to the rightmost one
+struct Chains {
+    std::vector<HullPoint> lower;
+    std::vector<HullPoint> upper;
+};
+
+// points must be sorted by Less
+Chains MonotoneChain(std::span<const HullPoint> sorted) {
+    Chains chains;
+    auto &lower = chains.lower;
+    auto &upper = chains.upper;
+
+    for (const HullPoint &p : sorted) {
+        while (lower.size() >= 2 && Orientation(lower[lower.size() - 2].point, lower.back().point, p.point) <= 0) {
+            lower.pop_back();
+        }
+        lower.push_back(p);
+
+        while (upper.size() >= 2 && Orientation(upper[upper.size() - 2].point, upper.back().point, p.point) >= 0) {
+            upper.pop_back();
+        }
+        upper.push_back(p);
+    }
+
+    return chains;
+}
+
+// vertexes of the hull sorted by Less, so hulls can be merged without sorting again
+std::vector<HullPoint> SortedVertexes(const Chains &chains) {
+    const auto &lower = chains.lower;
+    const auto &upper = chains.upper;
+
+    std::vector<HullPoint> vertexes;
+    if (lower.empty()) {
+        return vertexes;
+    }
+    vertexes.reserve(lower.size() + upper.size());
+
+    // ends of the upper chain are the ends of the lower one
+    auto upper_begin = upper.begin() + 1;
+    auto upper_end   = std::max(upper_begin, upper.end() - 1);
+    std::merge(lower.begin(), lower.end(), upper_begin, upper_end, std::back_inserter(vertexes), Less);
+    return vertexes;
+}
+
+// counter-clockwise: lower chain, then upper chain backwards
+std::vector<uint32_t> HullOrder(const Chains &chains) {
+    const auto &lower = chains.lower;
+    const auto &upper = chains.upper;
+
+    std::vector<uint32_t> hull;
+    if (lower.empty()) {
+        return hull;
+    }
+
+    Point first = lower.front().point;
+    Point last  = lower.back().point;
+    if (first.x == last.x && first.y == last.y) {
+        hull.push_back(lower.front().idx);
+        return hull;
+    }
+
+    hull.reserve(lower.size() + upper.size());
+    for (const HullPoint &p : lower) {
+        hull.push_back(p.idx);
+    }
+    for (size_t i = upper.size() - 1; i-- > 1;) {
+        hull.push_back(upper[i].idx);
+    }
+    return hull;
+}
+
+// extreme points in 8 directions, counter-clockwise from the left one
+// they are vertexes of the hull, so points strictly inside of their octagon (Akl-Toussaint) can't be
+struct Octagon {
+    static constexpr std::array<Vector2, 8> DIRECTIONS = {{
+        {-1, 0}, {-1, -1}, {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1},
+    }};
+
+    std::array<Point, 8> points;
+    std::array<float, 8> values;
+
+    Octagon() {
+        values.fill(-std::numeric_limits<float>::infinity());
+    }
+
+    void Add(Point p) {
+        for (size_t k = 0; k < DIRECTIONS.size(); ++k) {
+            float value = DIRECTIONS[k].x * p.x + DIRECTIONS[k].y * p.y;
+            if (value > values[k]) {
+                values[k] = value;
+                points[k] = p;
+            }
+        }
+    }
+
+    void Merge(const Octagon &other) {
+        for (size_t k = 0; k < DIRECTIONS.size(); ++k) {
+            if (other.values[k] > values[k]) {
+                values[k] = other.values[k];
+                points[k] = other.points[k];
+            }
+        }
+    }
+
+    // if the extremes are collinear or the same point, no point is strictly inside and nothing is discarded
+    bool IsStrictlyInside(Point p) const {
+        size_t nedges = 0;
+        for (size_t k = 0; k < points.size(); ++k) {
+            Point a = points[k];
+            Point b = points[(k + 1) % points.size()];
+            if (a.x == b.x && a.y == b.y) {
+                continue;
+            }
+            if (Orientation(a, b, p) <= 0) {
+                return false;
+            }
+            ++nedges;
+        }
+        return nedges > 0;
+    }
+};
+
+} // namespace
+
+std::vector<uint32_t> ConvexHullIndexes(std::span<const Point> points) {
+    size_t n = points.size();
+    assert(n <= std::numeric_limits<uint32_t>::max());
+    if (n == 0) {
+        return {};
+    }
+
+    ThreadPool &pool = GetThreadPool();
+    size_t nchunks = n < CONVEX_HULL_PARALLEL_THRESHOLD ? 1 : std::max<size_t>(pool.NumThreads() * 4, 1);
+    size_t chunk = (n + nchunks - 1) / nchunks;
+
+    auto ForEachChunk = [&](auto func) {
+        if (nchunks == 1) {
+            func(0, 0, n);
+            return;
+        }
+        pool.ParallelFor(nchunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                func(c, std::min(c * chunk, n), std::min(c * chunk + chunk, n));
+            }
+        });
+    };
+
+    std::vector<Octagon> octagons(nchunks);
+    ForEachChunk([&](size_t c, size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            octagons[c].Add(points[i]);
+        }
+    });
+    Octagon octagon;
+    for (const Octagon &other : octagons) {
+        octagon.Merge(other);
+    }
+
+    // hull of every chunk, as its vertexes sorted by Less
+    std::vector<std::vector<HullPoint>> hulls(nchunks);
+    ForEachChunk([&](size_t c, size_t first, size_t last) {
+        auto &candidates = hulls[c];
+        for (size_t i = first; i < last; ++i) {
+            if (!octagon.IsStrictlyInside(points[i])) {
+                candidates.push_back({ points[i], (uint32_t) i });
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), Less);
+        candidates = SortedVertexes(MonotoneChain(candidates));
+    });
+
+    // hull of two hulls is the monotone chain over their merged vertexes, it takes linear time
+    for (size_t step = 1; step < nchunks; step *= 2) {
+        size_t npairs = (nchunks + 2 * step - 1) / (2 * step);
+        pool.ParallelFor(npairs, 1, [&](size_t begin, size_t end) {
+            for (size_t pair = begin; pair < end; ++pair) {
+                size_t a = pair * 2 * step;
+                size_t b = a + step;
+                if (b >= nchunks) {
+                    continue;
+                }
+
+                std::vector<HullPoint> merged;
+                merged.reserve(hulls[a].size() + hulls[b].size());
+                std::merge(hulls[a].begin(), hulls[a].end(), hulls[b].begin(), hulls[b].end(),
+                           std::back_inserter(merged), Less);
+
+                hulls[a] = SortedVertexes(MonotoneChain(merged));
+                hulls[b] = {};
+            }
+        });
+    }
+
+    return HullOrder(MonotoneChain(hulls[0]));
+}
+
+std::vector<Point> ConvexHull(std::span<const Point> points) {
+    std::vector<uint32_t> indexes = ConvexHullIndexes(points);
+
+    std::vector<Point> hull;
+    hull.reserve(indexes.size());
+    for (uint32_t idx : indexes) {
+        hull.push_back(points[idx]);
+    }
+    return hull;
+}
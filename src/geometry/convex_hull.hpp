@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+#include "geometry.hpp"
+
+// point sets larger than this are split into chunks, hulls of the chunks are computed in parallel and merged pairwise
+static constexpr size_t CONVEX_HULL_PARALLEL_THRESHOLD = 1 << 16;
+
+// indexes of the hull vertexes by Andrew's monotone chain, O(n log n)
+// the hull goes counter-clockwise in math coordinates (clockwise on the screen, where y goes down),
+// it starts at the leftmost point, collinear and repeated points are dropped
+// points inside of the octagon of the extreme points are discarded first, for most sets it leaves a small fraction of them
+std::vector<uint32_t> ConvexHullIndexes(std::span<const Point> points);
+std::vector<Point> ConvexHull(std::span<const Point> points);
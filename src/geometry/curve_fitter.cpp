@@ -0,0 +1,161 @@
+#include "curve_fitter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+Point Quadratic(Point p0, Point p1, Point p2, float t) {
+    float u = 1 - t;
+    return p0 * (u * u) + p1 * (2 * u * t) + p2 * (t * t);
+}
+
+} // namespace
+
+void StreamingCurveFitter::Begin(Point point, float tolerance) {
+    this->tolerance = tolerance;
+
+    control_points.clear();
+    control_points.push_back(point);
+    stable_points = 1;
+
+    tail.clear();
+    tail.push_back(point);
+    parameters.clear();
+    start_tangent.reset();
+    tail_fit.reset();
+    nsamples = 1;
+}
+
+void StreamingCurveFitter::Add(Point point) {
+    assert(!tail.empty() && "Begin() must be called first");
+
+    if (Vector2DistanceSqr(point, tail.back()) < tolerance * tolerance / 16) {
+        return;
+    }
+    ++nsamples;
+
+    // sharp turn right after a stable curve is a corner, the next curve doesn't continue its tangent
+    if (tail.size() == 1 && start_tangent.has_value()) {
+        Vector2 direction = Vector2Normalize(point - tail[0]);
+        if (std::acos(Clamp(Vector2DotProduct(direction, start_tangent.value()), -1.f, 1.f)) > CORNER_ANGLE) {
+            start_tangent.reset();
+        }
+    }
+
+    tail.push_back(point);
+
+    Fit fit = FitTail();
+    if (fit.error <= tolerance && tail.size() <= MAX_TAIL_SAMPLES) {
+        tail_fit = fit;
+        SetTailCurve(fit);
+        return;
+    }
+
+    // the tail without the new sample did fit, it becomes stable and the new sample starts the next tail
+    assert(tail_fit.has_value());
+    Fit last = tail_fit.value();
+    SetTailCurve(last);
+    stable_points = control_points.size();
+
+    start_tangent = Vector2Normalize(last.end - last.control);
+    tail.assign({ last.end, point });
+    tail_fit.reset();
+
+    fit = FitTail();
+    tail_fit = fit;
+    SetTailCurve(fit);
+}
+
+void StreamingCurveFitter::End() {
+    stable_points = control_points.size();
+
+    tail.clear();
+    parameters.clear();
+    start_tangent.reset();
+    tail_fit.reset();
+}
+
+StreamingCurveFitter::Fit StreamingCurveFitter::FitTail() {
+    size_t n = tail.size();
+    assert(n >= 2);
+
+    Point p0 = tail.front();
+    Point p2 = tail.back();
+
+    // chord length parameters, Newton steps start from them every time the tail grows
+    parameters.resize(n);
+    parameters[0] = 0;
+    for (size_t i = 1; i < n; ++i) {
+        parameters[i] = parameters[i - 1] + Vector2Distance(tail[i - 1], tail[i]);
+    }
+    float length = parameters.back();
+    for (float &t : parameters) {
+        t = length > 0 ? t / length : 0.f;
+    }
+
+    Fit fit;
+    fit.end = p2;
+
+    for (int iteration = 0; ; ++iteration) {
+        // B(t) = (1-t)^2 p0 + w(t) c + t^2 p2 with w(t) = 2t(1-t), so c is the only unknown:
+        // least squares over samples r_i = p_i - (1-t)^2 p0 - t^2 p2 gives c = sum w_i r_i / sum w_i^2,
+        // with the tangent c = p0 + alpha * tangent and alpha = sum w_i tangent . (r_i - w_i p0) / sum w_i^2
+        Vector2 wr = Vector2Zeros;
+        float ww = 0;
+        for (size_t i = 0; i < n; ++i) {
+            float t = parameters[i];
+            float u = 1 - t;
+            float w = 2 * u * t;
+            Point r = tail[i] - p0 * (u * u) - p2 * (t * t);
+
+            wr += r * w;
+            ww += w * w;
+        }
+
+        float chord = Vector2Distance(p0, p2);
+        if (start_tangent.has_value()) {
+            Vector2 tangent = start_tangent.value();
+            float alpha = ww > 0 ? Vector2DotProduct(tangent, wr - p0 * ww) / ww : 0.f;
+            // control point behind the start would make a cusp, Schneider falls back to a fraction of the chord too
+            if (alpha <= 1e-3f * chord) {
+                alpha = chord / 2;
+            }
+            fit.control = p0 + tangent * alpha;
+        } else {
+            fit.control = ww > 0 ? wr / ww : (p0 + p2) / 2;
+        }
+
+        fit.error = 0;
+        for (size_t i = 0; i < n; ++i) {
+            fit.error = std::max(fit.error, Vector2Distance(Quadratic(p0, fit.control, p2, parameters[i]), tail[i]));
+        }
+
+        if (fit.error <= tolerance || iteration == NEWTON_ITERATIONS) {
+            return fit;
+        }
+
+        // reparametrize: one Newton step for the root of (B(t) - p) . B'(t)
+        Vector2 d0 = (fit.control - p0) * 2;
+        Vector2 d1 = (p2 - fit.control) * 2;
+        Vector2 dd = d1 - d0;
+        for (size_t i = 1; i + 1 < n; ++i) {
+            float t = parameters[i];
+            Point diff = Quadratic(p0, fit.control, p2, t) - tail[i];
+            Vector2 derivative = Vector2Lerp(d0, d1, t);
+
+            float numerator   = Vector2DotProduct(diff, derivative);
+            float denominator = Vector2DotProduct(derivative, derivative) + Vector2DotProduct(diff, dd);
+            if (denominator != 0) {
+                parameters[i] = Clamp(t - numerator / denominator, 0.f, 1.f);
+            }
+        }
+    }
+}
+
+void StreamingCurveFitter::SetTailCurve(const Fit &fit) {
+    control_points.resize(stable_points);
+    control_points.push_back(fit.control);
+    control_points.push_back(fit.end);
+}
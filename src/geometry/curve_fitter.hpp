@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <cstddef>
+
+#include "geometry.hpp"
+
+// fits a stroke into quadratic bezier curves while it is being drawn (Schneider's algorithm, fitted incrementally)
+// samples since the last finished curve are the tail, every new sample refits only the tail:
+// least squares for the control point with chord length parameters improved by Newton steps
+// when the tail can't be fitted within the tolerance, the last good fit is finished and a new tail starts at its end,
+// so a long stroke is never refitted from the start and every sample costs at most MAX_TAIL_SAMPLES
+// curves meet with the same tangent (G1), except at sharp corners of the stroke
+struct StreamingCurveFitter {
+    // tail is finished when it gets this long even if it still fits, it bounds the work and the latency
+    static constexpr size_t MAX_TAIL_SAMPLES = 64;
+    static constexpr int NEWTON_ITERATIONS = 3;
+    // tangent is not kept when the stroke turns sharper than this (radians) right at the start of the tail
+    static constexpr float CORNER_ANGLE = 1.2f;
+
+    // max distance from a sample to the curve, in the units of samples
+    float tolerance = 1.f;
+
+    // points of the curves like in SceneBezier::BezierSet: curve i uses [2 * i, 2 * i + 2]
+    // the last curve fits the tail and changes with every sample, the first `stable_points` never change again
+    std::vector<Point> control_points;
+    size_t stable_points = 0;
+
+    void Begin(Point point, float tolerance);
+    // samples closer than tolerance / 4 to the previous one add nothing but work and are skipped
+    void Add(Point point);
+    // the tail becomes stable
+    void End();
+
+    size_t NumSamples() const {
+        return nsamples;
+    }
+
+private:
+    // fitted curve with its error over the samples it was fitted to
+    struct Fit {
+        Point control;
+        Point end;
+        float error = 0.f;
+    };
+
+    std::vector<Point> tail;       // samples of the tail, tail[0] is the end of the last stable curve
+    std::vector<float> parameters; // of the tail samples on the curve
+    std::optional<Vector2> start_tangent;
+    std::optional<Fit> tail_fit;   // fit of the whole tail
+    size_t nsamples = 0;
+
+    Fit FitTail();
+    // append the fit of the tail, or replace it
+    void SetTailCurve(const Fit &fit);
+};
@@ -0,0 +1,693 @@
+#include "delaunay.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <bit>
+#include <cassert>
+
+#include "memory/allocation_counter.hpp"
+
+namespace {
+
+// the first round of insertion has about 2^-BRIO_ROUNDS of the points
+constexpr int BRIO_ROUNDS = 20;
+// points in one cell of the grid are in no particular order
+constexpr int HILBERT_BITS = 13;
+
+bool SamePoint(Point a, Point b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+// > 0 when d is inside of the circumcircle of counter-clockwise a, b, c
+double InCircle(Point a, Point b, Point c, Point d) {
+    double adx = (double) a.x - d.x;
+    double ady = (double) a.y - d.y;
+    double bdx = (double) b.x - d.x;
+    double bdy = (double) b.y - d.y;
+    double cdx = (double) c.x - d.x;
+    double cdy = (double) c.y - d.y;
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+    return alift * (bdx * cdy - bdy * cdx) + blift * (cdx * ady - cdy * adx) + clift * (adx * bdy - ady * bdx);
+}
+
+// p is on the line through a and b, true when it's strictly between them
+bool InsideSegment(Point a, Point b, Point p) {
+    return ((double) p.x - a.x) * ((double) b.x - a.x) + ((double) p.y - a.y) * ((double) b.y - a.y) > 0
+        && ((double) p.x - b.x) * ((double) a.x - b.x) + ((double) p.y - b.y) * ((double) a.y - b.y) > 0;
+}
+
+// position along the Hilbert curve over a 2^HILBERT_BITS x 2^HILBERT_BITS grid
+uint32_t HilbertIndex(uint32_t x, uint32_t y) {
+    // quadrants of every level are turned by the ones above them: x and y are swapped and/or both flipped
+    uint32_t swap = 0;
+    uint32_t flip = 0;
+    uint32_t d = 0;
+    for (int level = HILBERT_BITS - 1; level >= 0; --level) {
+        uint32_t bx = (x >> level) & 1;
+        uint32_t by = (y >> level) & 1;
+        uint32_t swapped = (bx ^ by) & swap;
+        uint32_t rx = bx ^ swapped ^ flip;
+        uint32_t ry = by ^ swapped ^ flip;
+        d = d << 2 | ((3 * rx) ^ ry);
+        // without branches, they are mispredicted half of the time
+        uint32_t turn = ry ^ 1;
+        swap ^= turn;
+        flip ^= rx & turn;
+    }
+    return d;
+}
+
+// sorts by the upper 32 bits, the lower ones are kept in the order they were
+// 4 passes over the keys are a few times faster than std::sort of a million of them
+void RadixSortUpperHalf(std::span<uint64_t> keys) {
+    std::vector<uint64_t> buffer(keys.size());
+    std::span<uint64_t> from = keys;
+    std::span<uint64_t> to = buffer;
+    for (int shift = 32; shift < 64; shift += 8) {
+        std::array<size_t, 257> offsets {};
+        for (uint64_t key : from) {
+            ++offsets[((key >> shift) & 0xff) + 1];
+        }
+        for (size_t i = 1; i < offsets.size(); ++i) {
+            offsets[i] += offsets[i - 1];
+        }
+        for (uint64_t key : from) {
+            to[offsets[(key >> shift) & 0xff]++] = key;
+        }
+        std::swap(from, to);
+    }
+    // the number of passes is even, the result is in keys
+}
+
+// random bits of the id, so rounds of insertion don't depend on the order of points
+uint32_t Hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+} // namespace
+
+void DelaunayTriangulation::Build(std::span<const Point> new_points) {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    points.assign(new_points.begin(), new_points.end());
+    vertexes.assign(new_points.begin(), new_points.end());
+    vertex_ids.resize(points.size());
+    id_vertexes.resize(points.size());
+    for (uint32_t id = 0; id < (uint32_t) points.size(); ++id) {
+        vertex_ids[id] = id;
+        id_vertexes[id] = id;
+    }
+    states.assign(points.size(), VertexState::Pending);
+    Rebuild();
+}
+
+void DelaunayTriangulation::Clear() {
+    points.clear();
+    vertexes.clear();
+    vertex_ids.clear();
+    id_vertexes.clear();
+    states.clear();
+    triangles.clear();
+    vertex_triangles.clear();
+    free_triangles.clear();
+    pending.clear();
+    hidden.clear();
+    marks.clear();
+    pending_second = NONE;
+    last_triangle = NONE;
+    finite_triangles = 0;
+    inserted = 0;
+}
+
+uint32_t DelaunayTriangulation::Insert(Point p) {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    uint32_t id = (uint32_t) points.size();
+    points.push_back(p);
+    id_vertexes.push_back(NONE);
+    AddVertex(id);
+    return id;
+}
+
+void DelaunayTriangulation::Remove(uint32_t id) {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+    assert(id < points.size() && id_vertexes[id] != NONE);
+
+    // the vertex stays in the arrays until the next rebuild
+    uint32_t vertex = id_vertexes[id];
+    id_vertexes[id] = NONE;
+    vertex_ids[vertex] = NONE;
+    RemoveVertex(vertex);
+}
+
+void DelaunayTriangulation::Move(uint32_t id, Point p) {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+    assert(id < points.size() && id_vertexes[id] != NONE);
+
+    if (SamePoint(points[id], p)) {
+        return;
+    }
+    points[id] = p;
+    RemoveVertex(id_vertexes[id]);
+    // a rebuild in the removal changes the vertex of the point
+    uint32_t vertex = id_vertexes[id];
+    vertexes[vertex] = p;
+    InsertVertex(vertex);
+}
+
+void DelaunayTriangulation::Sync(std::span<const Point> new_points) {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    size_t common = std::min(points.size(), new_points.size());
+    size_t changes = std::max(points.size(), new_points.size()) - common;
+    for (size_t i = 0; i < common; ++i) {
+        changes += !SamePoint(points[i], new_points[i]) || id_vertexes[i] == NONE;
+    }
+    if (changes == 0) {
+        return;
+    }
+    // an update is a removal and an insertion, which are a few times slower than an insertion of a rebuild
+    if (changes * 8 > new_points.size() + 64) {
+        Build(new_points);
+        return;
+    }
+
+    // removed points are at the end, so ids of the others stay the same
+    for (size_t id = points.size(); id-- > new_points.size();) {
+        if (id_vertexes[id] != NONE) {
+            Remove((uint32_t) id);
+        }
+    }
+    points.resize(new_points.size());
+    id_vertexes.resize(new_points.size(), NONE);
+
+    for (uint32_t id = 0; id < (uint32_t) new_points.size(); ++id) {
+        if (id_vertexes[id] == NONE) {
+            points[id] = new_points[id];
+            AddVertex(id);
+        } else if (!SamePoint(points[id], new_points[id])) {
+            Move(id, new_points[id]);
+        }
+    }
+}
+
+void DelaunayTriangulation::ExportMesh(TriangleMesh &mesh) const {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    mesh.vertexes = vertexes;
+    mesh.triangles.clear();
+    mesh.triangles.reserve(finite_triangles);
+    for (const Triangle &t : triangles) {
+        if (t.v[0] != NONE && t.v[0] != INFINITE && t.v[1] != INFINITE && t.v[2] != INFINITE) {
+            mesh.triangles.push_back(t.v);
+        }
+    }
+    mesh.Build();
+}
+
+size_t DelaunayTriangulation::MemoryUsage() const {
+    return (points.capacity() + vertexes.capacity()) * sizeof(Point)
+         + triangles.capacity() * sizeof(Triangle)
+         + states.capacity() * sizeof(VertexState)
+         + (vertex_ids.capacity() + id_vertexes.capacity() + vertex_triangles.capacity()) * sizeof(uint32_t)
+         + (free_triangles.capacity() + pending.capacity() + hidden.capacity()) * sizeof(uint32_t)
+         + (cavity.capacity() + stack.capacity() + marks.capacity() + fan.capacity()) * sizeof(uint32_t)
+         + (link.capacity() + outer.capacity()) * sizeof(uint32_t)
+         + boundary.capacity() * sizeof(BoundaryEdge)
+         + order.capacity() * sizeof(uint64_t);
+}
+
+void DelaunayTriangulation::AddVertex(uint32_t id) {
+    uint32_t vertex = (uint32_t) vertexes.size();
+    vertexes.push_back(points[id]);
+    vertex_ids.push_back(id);
+    states.push_back(VertexState::Removed);
+    vertex_triangles.push_back(NONE);
+    id_vertexes[id] = vertex;
+    InsertVertex(vertex);
+}
+
+void DelaunayTriangulation::Rebuild() {
+    ++rebuilds;
+
+    triangles.clear();
+    free_triangles.clear();
+    pending.clear();
+    hidden.clear();
+    marks.clear();
+    pending_second = NONE;
+    last_triangle = NONE;
+    finite_triangles = 0;
+    inserted = 0;
+
+    Point min = { INFINITY, INFINITY };
+    Point max = { -INFINITY, -INFINITY };
+    order.clear();
+    for (uint32_t vertex = 0; vertex < (uint32_t) vertexes.size(); ++vertex) {
+        if (vertex_ids[vertex] != NONE && states[vertex] != VertexState::Removed) {
+            min = Vector2Min(min, vertexes[vertex]);
+            max = Vector2Max(max, vertexes[vertex]);
+            order.push_back(vertex);
+        }
+    }
+    size_t count = order.size();
+    // the point that is being moved is not in the triangulation, it keeps a vertex for Move()
+    for (uint32_t vertex = 0; vertex < (uint32_t) vertexes.size(); ++vertex) {
+        if (vertex_ids[vertex] != NONE && states[vertex] == VertexState::Removed) {
+            order.push_back(vertex);
+        }
+    }
+
+    // biased randomized insertion order (Amenta, Choi, Rote): points go in rounds of random subsets, each round
+    // is about twice as large as the one before, so points are mostly inserted inside of the hull of the ones before,
+    // where cavities are small; in a round points go along a Hilbert curve, so every walk is a few steps
+    float size = std::max(max.x - min.x, max.y - min.y);
+    double scale = size > 0 ? ((1 << HILBERT_BITS) - 1) / (double) size : 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t vertex = (uint32_t) order[i];
+        uint32_t x = (uint32_t) (((double) vertexes[vertex].x - min.x) * scale);
+        uint32_t y = (uint32_t) (((double) vertexes[vertex].y - min.y) * scale);
+        uint64_t round = BRIO_ROUNDS - std::min(std::countr_zero(Hash(vertex_ids[vertex])), BRIO_ROUNDS);
+        order[i] = round << 58 | (uint64_t) HilbertIndex(x, y) << 32 | vertex;
+    }
+    RadixSortUpperHalf(std::span(order).first(count));
+
+    // vertexes are renumbered in the order of insertion, so triangles next to each other
+    // use vertexes next to each other in memory
+    std::vector<Point> sorted_vertexes(order.size());
+    std::vector<uint32_t> sorted_ids(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        uint32_t vertex = (uint32_t) order[i];
+        sorted_vertexes[i] = vertexes[vertex];
+        sorted_ids[i] = vertex_ids[vertex];
+        id_vertexes[vertex_ids[vertex]] = (uint32_t) i;
+    }
+    vertexes.swap(sorted_vertexes);
+    vertex_ids.swap(sorted_ids);
+    states.assign(order.size(), VertexState::Removed);
+    vertex_triangles.assign(order.size(), NONE);
+
+    for (uint32_t vertex = 0; vertex < (uint32_t) count; ++vertex) {
+        InsertVertex(vertex);
+    }
+}
+
+void DelaunayTriangulation::InsertVertex(uint32_t vertex) {
+    Point p = vertexes[vertex];
+
+    if (finite_triangles == 0) {
+        // until there are 3 points not on one line there is nothing to triangulate
+        states[vertex] = VertexState::Pending;
+        if (!pending.empty()) {
+            if (pending_second == NONE) {
+                if (!SamePoint(vertexes[pending[0]], p)) {
+                    pending_second = vertex;
+                }
+            } else if (Orientation(vertexes[pending[0]], vertexes[pending_second], p) != 0) {
+                StartTriangulation(pending[0], pending_second, vertex);
+                return;
+            }
+        }
+        pending.push_back(vertex);
+        return;
+    }
+
+    uint32_t start = Locate(p);
+    for (uint32_t v : triangles[start].v) {
+        if (v != INFINITE && SamePoint(vertexes[v], p)) {
+            states[vertex] = VertexState::Hidden;
+            hidden.push_back(vertex);
+            return;
+        }
+    }
+
+    // triangles with the point in their circumcircle are connected, they are found from the one with the point
+    uint32_t current_stamp = NextStamp();
+    cavity.clear();
+    stack.clear();
+    stack.push_back(start);
+    marks[start] = current_stamp;
+    while (!stack.empty()) {
+        uint32_t t = stack.back();
+        stack.pop_back();
+        cavity.push_back(t);
+        for (size_t i = 0; i < 3; ++i) {
+            uint32_t neighbour = triangles[t].n[i];
+            if (marks[neighbour] == current_stamp) {
+                continue;
+            }
+            uint32_t a = triangles[t].v[i];
+            uint32_t b = triangles[t].v[(i + 1) % 3];
+            // an edge with the point on its other side would make a turned over triangle,
+            // it only happens with rounding errors, the cavity takes the triangle behind it instead
+            if (Conflicts(neighbour, p) || (a != INFINITE && b != INFINITE && Orientation(vertexes[a], vertexes[b], p) <= 0)) {
+                marks[neighbour] = current_stamp;
+                stack.push_back(neighbour);
+            }
+        }
+    }
+
+    boundary.clear();
+    for (uint32_t t : cavity) {
+        for (size_t i = 0; i < 3; ++i) {
+            uint32_t neighbour = triangles[t].n[i];
+            if (marks[neighbour] != current_stamp) {
+                boundary.push_back(BoundaryEdge { triangles[t].v[i], triangles[t].v[(i + 1) % 3], neighbour });
+            }
+        }
+    }
+    for (uint32_t t : cavity) {
+        FreeTriangle(t);
+    }
+
+    // the cavity is replaced by a fan of triangles around the point, one per edge of its boundary
+    fan.clear();
+    uint32_t infinite_fan = NONE;
+    for (const BoundaryEdge &edge : boundary) {
+        uint32_t t = NewTriangle(edge.a, edge.b, vertex);
+        Link(t, 0, edge.outside);
+        fan.push_back(t);
+        if (edge.a == INFINITE) {
+            infinite_fan = t;
+        } else {
+            vertex_triangles[edge.a] = t;
+        }
+    }
+    // the fan triangle after (a, b, vertex) is the one that starts at b
+    for (uint32_t t : fan) {
+        uint32_t b = triangles[t].v[1];
+        uint32_t next = b == INFINITE ? infinite_fan : vertex_triangles[b];
+        triangles[t].n[1] = next;
+        triangles[next].n[2] = t;
+    }
+
+    states[vertex] = VertexState::Inserted;
+    vertex_triangles[vertex] = fan[0];
+    last_triangle = fan[0];
+    ++inserted;
+}
+
+void DelaunayTriangulation::RemoveVertex(uint32_t vertex) {
+    switch (states[vertex]) {
+    case VertexState::Removed:
+        return;
+
+    case VertexState::Pending:
+        states[vertex] = VertexState::Removed;
+        std::erase(pending, vertex);
+        pending_second = NONE;
+        for (uint32_t other : pending) {
+            if (!SamePoint(vertexes[other], vertexes[pending[0]])) {
+                pending_second = other;
+                break;
+            }
+        }
+        return;
+
+    case VertexState::Hidden:
+        states[vertex] = VertexState::Removed;
+        std::erase(hidden, vertex);
+        return;
+
+    case VertexState::Inserted:
+        break;
+    }
+
+    states[vertex] = VertexState::Removed;
+    --inserted;
+    if (inserted < 3) {
+        Rebuild();
+        return;
+    }
+
+    // link is the polygon around the point, outer[i] is the triangle behind its edge from link[i] to link[i + 1]
+    link.clear();
+    outer.clear();
+    cavity.clear();
+    uint32_t start = vertex_triangles[vertex];
+    uint32_t t = start;
+    do {
+        const Triangle &triangle = triangles[t];
+        size_t i = triangle.v[0] == vertex ? 0 : triangle.v[1] == vertex ? 1 : 2;
+        assert(triangle.v[i] == vertex);
+        link.push_back(triangle.v[(i + 1) % 3]);
+        outer.push_back(triangle.n[(i + 1) % 3]);
+        cavity.push_back(t);
+        t = triangle.n[(i + 2) % 3];
+    } while (t != start);
+    for (uint32_t c : cavity) {
+        FreeTriangle(c);
+    }
+
+    // an ear is a Delaunay triangle when no other point of the hole is in its circumcircle,
+    // for a ghost ear (with the infinite vertex) it's the half-plane outside its edge
+    auto IsEar = [this](size_t prev, size_t i, size_t next) {
+        uint32_t a = link[prev];
+        uint32_t b = link[i];
+        uint32_t c = link[next];
+        if (a != INFINITE && b != INFINITE && c != INFINITE) {
+            if (Orientation(vertexes[a], vertexes[b], vertexes[c]) <= 0) {
+                return false;
+            }
+            for (size_t j = 0; j < link.size(); ++j) {
+                if (j != prev && j != i && j != next && link[j] != INFINITE
+                    && InCircle(vertexes[a], vertexes[b], vertexes[c], vertexes[link[j]]) > 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // the edge from u to w is on the convex hull, nothing can be outside of it
+        uint32_t u = a == INFINITE ? b : b == INFINITE ? c : a;
+        uint32_t w = a == INFINITE ? c : b == INFINITE ? a : b;
+        for (size_t j = 0; j < link.size(); ++j) {
+            if (j == prev || j == i || j == next) {
+                continue;
+            }
+            Point q = vertexes[link[j]];
+            double orient = Orientation(vertexes[u], vertexes[w], q);
+            if (orient > 0 || (orient == 0 && InsideSegment(vertexes[u], vertexes[w], q))) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    auto AddTriangle = [this](uint32_t a, uint32_t b, uint32_t c) {
+        uint32_t t = NewTriangle(a, b, c);
+        for (uint32_t v : { a, b, c }) {
+            if (v != INFINITE) {
+                vertex_triangles[v] = t;
+            }
+        }
+        return t;
+    };
+
+    while (link.size() > 3) {
+        size_t count = link.size();
+        size_t ear = count;
+        for (size_t i = 0; i < count; ++i) {
+            if (IsEar((i + count - 1) % count, i, (i + 1) % count)) {
+                ear = i;
+                break;
+            }
+        }
+        if (ear == count) {
+            // only with rounding errors
+            TraceLog(LOG_WARNING, "DELAUNAY: No ear in the hole of a removed point, rebuilding");
+            Rebuild();
+            return;
+        }
+
+        size_t prev = (ear + count - 1) % count;
+        size_t next = (ear + 1) % count;
+        uint32_t t = AddTriangle(link[prev], link[ear], link[next]);
+        Link(t, 0, outer[prev]);
+        Link(t, 1, outer[ear]);
+        outer[prev] = t;
+        link.erase(link.begin() + (ptrdiff_t) ear);
+        outer.erase(outer.begin() + (ptrdiff_t) ear);
+    }
+
+    bool turned = link[0] != INFINITE && link[1] != INFINITE && link[2] != INFINITE
+                  && Orientation(vertexes[link[0]], vertexes[link[1]], vertexes[link[2]]) <= 0;
+    uint32_t last = AddTriangle(link[0], link[1], link[2]);
+    Link(last, 0, outer[0]);
+    Link(last, 1, outer[1]);
+    Link(last, 2, outer[2]);
+    last_triangle = last;
+
+    // the rest of the points are on one line
+    if (turned || finite_triangles == 0) {
+        Rebuild();
+        return;
+    }
+
+    // a point that was hidden by this one takes its place
+    Point p = vertexes[vertex];
+    for (size_t i = 0; i < hidden.size(); ++i) {
+        uint32_t other = hidden[i];
+        if (SamePoint(vertexes[other], p)) {
+            hidden.erase(hidden.begin() + (ptrdiff_t) i);
+            InsertVertex(other);
+            break;
+        }
+    }
+}
+
+void DelaunayTriangulation::StartTriangulation(uint32_t a, uint32_t b, uint32_t c) {
+    if (Orientation(vertexes[a], vertexes[b], vertexes[c]) < 0) {
+        std::swap(b, c);
+    }
+    uint32_t t = NewTriangle(a, b, c);
+    uint32_t ghost_ab = NewTriangle(b, a, INFINITE);
+    uint32_t ghost_bc = NewTriangle(c, b, INFINITE);
+    uint32_t ghost_ca = NewTriangle(a, c, INFINITE);
+    Link(t, 0, ghost_ab);
+    Link(t, 1, ghost_bc);
+    Link(t, 2, ghost_ca);
+    Link(ghost_ab, 1, ghost_ca);
+    Link(ghost_bc, 1, ghost_ab);
+    Link(ghost_ca, 1, ghost_bc);
+
+    for (uint32_t v : { a, b, c }) {
+        states[v] = VertexState::Inserted;
+        vertex_triangles[v] = t;
+    }
+    inserted = 3;
+    last_triangle = t;
+
+    // the rest of the points on the line of the first ones
+    std::vector<uint32_t> rest;
+    rest.swap(pending);
+    pending_second = NONE;
+    for (uint32_t vertex : rest) {
+        if (vertex != a && vertex != b && vertex != c) {
+            InsertVertex(vertex);
+        }
+    }
+    rest.clear();
+    pending.swap(rest);
+}
+
+uint32_t DelaunayTriangulation::Locate(Point p) {
+    uint32_t t = last_triangle;
+    if (t >= triangles.size() || triangles[t].v[0] == NONE) {
+        t = 0;
+        while (triangles[t].v[0] == NONE) {
+            ++t;
+        }
+    }
+
+    auto InfiniteIndex = [this](uint32_t t) {
+        const Triangle &triangle = triangles[t];
+        return triangle.v[0] == INFINITE ? 0 : triangle.v[1] == INFINITE ? 1 : triangle.v[2] == INFINITE ? 2 : 3;
+    };
+    if (size_t k = InfiniteIndex(t); k < 3) {
+        t = triangles[t].n[(k + 1) % 3];
+    }
+
+    // visibility walk: it crosses edges with the point on their other side until there are none
+    // or it gets out of the convex hull; in a Delaunay triangulation it can't cycle even when edges are tried
+    // in the same order every time (Edelsbrunner), which is a lot faster than the random order of a walk in any mesh
+    uint32_t previous = NONE;
+    size_t max_steps = triangles.size() + 16;
+    for (size_t step = 0; step < max_steps; ++step) {
+        if (InfiniteIndex(t) < 3) {
+            return t;
+        }
+        const Triangle &triangle = triangles[t];
+        uint32_t next = NONE;
+        for (size_t i = 0; i < 3; ++i) {
+            if (triangle.n[i] != previous
+                && Orientation(vertexes[triangle.v[i]], vertexes[triangle.v[(i + 1) % 3]], p) < 0)
+            {
+                next = triangle.n[i];
+                break;
+            }
+        }
+        if (next == NONE) {
+            return t;
+        }
+        previous = t;
+        t = next;
+    }
+
+    // rounding errors made the walk go in circles
+    for (uint32_t i = 0; i < (uint32_t) triangles.size(); ++i) {
+        if (triangles[i].v[0] != NONE && Conflicts(i, p)) {
+            return i;
+        }
+    }
+    return t;
+}
+
+bool DelaunayTriangulation::Conflicts(uint32_t t, Point p) const {
+    const Triangle &triangle = triangles[t];
+    for (size_t k = 0; k < 3; ++k) {
+        if (triangle.v[k] == INFINITE) {
+            Point u = vertexes[triangle.v[(k + 1) % 3]];
+            Point w = vertexes[triangle.v[(k + 2) % 3]];
+            double orient = Orientation(u, w, p);
+            return orient > 0 || (orient == 0 && InsideSegment(u, w, p));
+        }
+    }
+    return InCircle(vertexes[triangle.v[0]], vertexes[triangle.v[1]], vertexes[triangle.v[2]], p) > 0;
+}
+
+uint32_t DelaunayTriangulation::NewTriangle(uint32_t a, uint32_t b, uint32_t c) {
+    uint32_t t;
+    if (free_triangles.empty()) {
+        t = (uint32_t) triangles.size();
+        triangles.emplace_back();
+        marks.push_back(0);
+    } else {
+        t = free_triangles.back();
+        free_triangles.pop_back();
+    }
+    triangles[t] = Triangle { { a, b, c }, { NONE, NONE, NONE } };
+    if (a != INFINITE && b != INFINITE && c != INFINITE) {
+        ++finite_triangles;
+    }
+    return t;
+}
+
+void DelaunayTriangulation::FreeTriangle(uint32_t t) {
+    Triangle &triangle = triangles[t];
+    if (triangle.v[0] != INFINITE && triangle.v[1] != INFINITE && triangle.v[2] != INFINITE) {
+        --finite_triangles;
+    }
+    triangle.v[0] = NONE;
+    free_triangles.push_back(t);
+}
+
+void DelaunayTriangulation::Link(uint32_t t, uint32_t side, uint32_t other) {
+    triangles[t].n[side] = other;
+    uint32_t a = triangles[t].v[side];
+    uint32_t b = triangles[t].v[(side + 1) % 3];
+    Triangle &triangle = triangles[other];
+    for (size_t i = 0; i < 3; ++i) {
+        if (triangle.v[i] == b && triangle.v[(i + 1) % 3] == a) {
+            triangle.n[i] = t;
+            return;
+        }
+    }
+    assert(false && "triangles don't share the edge");
+}
+
+uint32_t DelaunayTriangulation::NextStamp() {
+    if (++stamp == 0) {
+        std::fill(marks.begin(), marks.end(), 0);
+        stamp = 1;
+    }
+    return stamp;
+}
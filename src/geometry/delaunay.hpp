@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include "geometry.hpp"
+#include "triangle_mesh.hpp"
+
+// Delaunay triangulation that is kept up to date while points are added, moved and removed
+// points are inserted one by one with Bowyer-Watson: a walk finds the triangle of the point, the triangles with the point
+// in their circumcircle are replaced by a fan around it, so an insertion costs about the number of replaced triangles
+// a removed point leaves a hole around it, the hole is filled by clipping ears that have no other point of the hole
+// in their circumcircle (Devillers), so one moved point is one removal and one insertion instead of a rebuild
+// the outside of the convex hull is covered by ghost triangles with the vertex INFINITE, so points outside the hull
+// are inserted and removed the same way as the inner ones
+// a rebuild inserts all points in a biased randomized order, sorted along a Hilbert curve in every round,
+// so walks are short and cavities are small, vertexes are renumbered in that order to be close in memory
+// predicates are in doubles without exact arithmetic, a removal that can't find an ear falls back to a rebuild
+struct DelaunayTriangulation {
+    static constexpr uint32_t NONE = UINT32_MAX;
+    static constexpr uint32_t INFINITE = UINT32_MAX - 1;
+
+    std::vector<Point> points; // id of a point is its index
+    size_t rebuilds = 0; // by Build(), Sync() with a lot of changes or a removal that failed
+
+    // all points at once, ids are indexes of new_points
+    void Build(std::span<const Point> new_points);
+    void Clear();
+
+    // returns the id of the point
+    uint32_t Insert(Point p);
+    void Remove(uint32_t id);
+    void Move(uint32_t id, Point p);
+
+    // makes the points the same as new_points with ids being indexes:
+    // changed points are moved, extra ones are inserted or removed, a lot of changes are a rebuild
+    void Sync(std::span<const Point> new_points);
+
+    size_t NumTriangles() const {
+        return finite_triangles;
+    }
+
+    // every edge between two points once, func(Point a, Point b)
+    // points that are the same as another point or that are all on one line are not connected
+    template <typename Func>
+    void ForEachEdge(Func &&func) const {
+        for (const Triangle &t : triangles) {
+            if (t.v[0] == NONE) {
+                continue;
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                uint32_t a = t.v[i];
+                uint32_t b = t.v[(i + 1) % 3];
+                // every edge is in two triangles, once from a to b and once from b to a
+                if (a < b && b != INFINITE) {
+                    func(vertexes[a], vertexes[b]);
+                }
+            }
+        }
+    }
+
+    // finite triangles as a mesh (e.g. to locate points in it), its vertexes are in the order of the last rebuild, not by ids
+    // the mesh covers the convex hull of the points
+    void ExportMesh(TriangleMesh &mesh) const;
+
+    size_t MemoryUsage() const;
+
+private:
+    struct Triangle {
+        // vertexes (not ids) counter-clockwise in math coordinates, v[0] is NONE when the slot is free
+        std::array<uint32_t, 3> v;
+        // n[i] is across the edge from v[i] to v[i + 1]
+        std::array<uint32_t, 3> n;
+    };
+
+    enum class VertexState : uint8_t {
+        Removed,
+        Pending,  // all points so far are on one line, there are no triangles
+        Hidden,   // same as an inserted point
+        Inserted,
+    };
+
+    // points in the order of insertion of the last rebuild, so points next to each other in the triangulation
+    // are mostly next to each other in memory; new points are added at the end
+    std::vector<Point> vertexes;
+    std::vector<uint32_t> vertex_ids;  // NONE for removed points
+    std::vector<uint32_t> id_vertexes; // NONE for removed points
+    std::vector<VertexState> states;
+    std::vector<Triangle> triangles;
+    std::vector<uint32_t> vertex_triangles; // a triangle of every inserted vertex
+    std::vector<uint32_t> free_triangles;
+    std::vector<uint32_t> pending;
+    std::vector<uint32_t> hidden;
+    uint32_t pending_second = NONE; // first pending point that is not the same as pending[0]
+    uint32_t last_triangle = NONE;  // walks start from it
+    size_t finite_triangles = 0;
+    size_t inserted = 0;
+
+    // kept between operations, so they don't allocate
+    struct BoundaryEdge {
+        uint32_t a;
+        uint32_t b;
+        uint32_t outside;
+    };
+    std::vector<uint32_t> cavity;
+    std::vector<uint32_t> stack;
+    std::vector<uint32_t> marks;
+    uint32_t stamp = 0;
+    std::vector<BoundaryEdge> boundary;
+    std::vector<uint32_t> fan;
+    std::vector<uint32_t> link;
+    std::vector<uint32_t> outer;
+    std::vector<uint64_t> order;
+
+    void AddVertex(uint32_t id);
+    void Rebuild();
+    void InsertVertex(uint32_t id);
+    void RemoveVertex(uint32_t id);
+    void StartTriangulation(uint32_t a, uint32_t b, uint32_t c);
+
+    uint32_t Locate(Point p);
+    bool Conflicts(uint32_t t, Point p) const;
+    uint32_t NewTriangle(uint32_t a, uint32_t b, uint32_t c);
+    void FreeTriangle(uint32_t t);
+    // sets the neighbour of t across its side and the neighbour of other across the same edge
+    void Link(uint32_t t, uint32_t side, uint32_t other);
+    uint32_t NextStamp();
+};
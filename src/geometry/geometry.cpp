@@ -1,5 +1,7 @@
 #include "geometry.hpp"
 
+#include "render/render.hpp"
+
 #include <numeric>
 #include <numbers>
 #include <cmath>
@@ -77,31 +79,6 @@ std::optional<Point> Intersect(Point a, Point b, Point x, Point y) {
     return std::nullopt;
 }
 
-void DrawLineDotted(Point start, Point end, float segment_len, float thick, Color color) {
-    const int nsegments = (int) std::ceil(Distance(start, end) / (2 * segment_len));
-    
-    Point delta = end - start;
-    Point step = Vector2Normalize(delta) * segment_len;
-
-    bool draw_end_cap = true;
-    
-    for (int i = 0; i < nsegments; ++i) {
-        Point segment_start = start + step * (float) (2 * i);
-        Point segment_end   = segment_start + step;
-
-        if (i == nsegments - 1 && Distance(segment_start, segment_end) > Distance(segment_start, end)) {
-            segment_end = end;
-            draw_end_cap = false;
-        }
-
-        DrawLineEx(segment_start, segment_end, thick, color);
-    }
-
-    if (draw_end_cap) {
-        DrawLineEx(end + step*0.05f, end - step*0.05f, thick, color);
-    }    
-};
-
 bool IsInsideTriangle(Point p, Point a, Point b, Point c) {
     float d  = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
     float k1 = ((b.x - p.x) * (c.y - p.y) - (c.x - p.x) * (b.y - p.y)) / d;
@@ -172,16 +149,16 @@ void Polygon::Draw(Color color_line, Color color_point) const {
 
     Point a = vertexes.front();
     for (size_t i = 1; i < vertexes.size(); i++) {
-        DrawLineV(a, vertexes[i], color_line);
-        DrawCircleV(vertexes[i], 5, color_point);
+        Render::DrawLine(a, vertexes[i], color_line);
+        Render::DrawCircle(vertexes[i], 5, color_point);
         a = vertexes[i];
     }
-    DrawLineV(a, vertexes.front(), color_line);
-    DrawCircleV(vertexes.front(), 5, color_point);
+    Render::DrawLine(a, vertexes.front(), color_line);
+    Render::DrawCircle(vertexes.front(), 5, color_point);
 }
 
 void Polygon::DrawCenter(Color color) const {
-    DrawCircleV(GetCenter(), 7, color);
+    Render::DrawCircle(GetCenter(), 7, color);
 }
 
 Polygon Polygon::Ellipse(Point center, float a, float b, int poly_steps) {
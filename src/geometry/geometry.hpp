@@ -6,13 +6,13 @@
 #include <deque>
 #include <ranges>
 #include <optional>
+#include <memory_resource>
 
 using Point = Vector2;
 
 template <typename Range, typename Value>
 concept RangeOf = std::ranges::random_access_range<Range> &&
-                  std::convertible_to<typename std::ranges::iterator_t<Range>::value_type,
-                                       Value>;
+                  std::convertible_to<std::ranges::range_value_t<Range>, Value>;
 
 inline Point GetScreenCenter() {
     return Point { GetScreenWidth() / 2.f, GetScreenHeight() / 2.f };
@@ -23,6 +23,13 @@ inline Point GetRandomPoint(int min_x, int max_x, int min_y, int max_y) {
                    (float) GetRandomValue(min_y, max_y) };
 };
 
+// twice the signed area of triangle abc: > 0 when a, b, c go counter-clockwise in math coordinates
+// (clockwise on the screen, where y goes down), 0 when they are on one line
+// in doubles, so the sign is right for points close to each other and every orientation test agrees with the others
+inline double Orientation(Point a, Point b, Point c) {
+    return ((double) b.x - a.x) * ((double) c.y - a.y) - ((double) b.y - a.y) * ((double) c.x - a.x);
+}
+
 Point RotatePoint(Point point, float angle, Point center=Vector2Zeros);
 float Distance(Point a, Point b);
 float Length(Point a);
@@ -37,13 +44,23 @@ bool IsInsideTriangle2(Point p, Point a, Point b, Point c);
 // cast rays from p to center and checks intersections
 bool IsInsideTriangle3(Point p, Point a, Point b, Point c);
 
-void DrawLineDotted(Point start, Point end, float segment_len, float thick, Color color);
-
 struct Polygon {
-    std::deque<Point> vertexes;
+    // polygon can be placed into any memory resource (e.g. the frame arena)
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    std::pmr::deque<Point> vertexes;
 
     Polygon() = default;
-    Polygon(std::initializer_list<Point> points) : vertexes(points) {}
+    explicit Polygon(const allocator_type &alloc) : vertexes(alloc) {}
+    Polygon(std::initializer_list<Point> points, const allocator_type &alloc={}) : vertexes(points, alloc) {}
+
+    Polygon(const Polygon &) = default;
+    Polygon(Polygon &&) = default;
+    Polygon(const Polygon &other, const allocator_type &alloc) : vertexes(other.vertexes, alloc) {}
+    Polygon(Polygon &&other, const allocator_type &alloc) : vertexes(std::move(other.vertexes), alloc) {}
+
+    Polygon &operator=(const Polygon &) = default;
+    Polygon &operator=(Polygon &&) = default;
 
     static Polygon Ellipse(Point center, float a, float b, int poly_steps=40);
 
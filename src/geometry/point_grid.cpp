@@ -0,0 +1,67 @@
+#include "point_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void PointGrid::Clear() {
+    cell_start.clear();
+    indexes.clear();
+    positions.clear();
+    nx = ny = 0;
+}
+
+void PointGrid::Build(std::span<const Point> points) {
+    Clear();
+    if (points.empty()) {
+        return;
+    }
+
+    Point min = points.front();
+    Point max = min;
+    for (Point p : points) {
+        min = Vector2Min(min, p);
+        max = Vector2Max(max, p);
+    }
+
+    // square cells sized so that an average cell holds a few points
+    float width  = std::max(max.x - min.x, 1.f);
+    float height = std::max(max.y - min.y, 1.f);
+    float cell_size = std::sqrt(width * height * POINTS_PER_CELL / (float) points.size());
+    cell_size = std::max({ cell_size, width / MAX_CELLS_PER_AXIS, height / MAX_CELLS_PER_AXIS });
+
+    origin = min;
+    inv_cell_size = 1.f / cell_size;
+    nx = std::clamp((int) (width * inv_cell_size) + 1, 1, MAX_CELLS_PER_AXIS);
+    ny = std::clamp((int) (height * inv_cell_size) + 1, 1, MAX_CELLS_PER_AXIS);
+
+    // counting sort by cell
+    cell_start.assign((size_t) nx * ny + 1, 0);
+    for (Point p : points) {
+        ++cell_start[CellY(p.y) * nx + CellX(p.x) + 1];
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c) {
+        cell_start[c] += cell_start[c - 1];
+    }
+
+    indexes.resize(points.size());
+    positions.resize(points.size());
+
+    std::vector<uint32_t> next(cell_start.begin(), cell_start.end() - 1);
+    for (uint32_t i = 0; i < (uint32_t) points.size(); ++i) {
+        uint32_t slot = next[CellY(points[i].y) * nx + CellX(points[i].x)]++;
+        indexes[slot]   = i;
+        positions[slot] = points[i];
+    }
+}
+
+int PointGrid::CellX(float x) const {
+    return std::clamp((int) std::floor((x - origin.x) * inv_cell_size), 0, nx - 1);
+}
+
+int PointGrid::CellY(float y) const {
+    return std::clamp((int) std::floor((y - origin.y) * inv_cell_size), 0, ny - 1);
+}
+
+size_t PointGrid::MemoryUsage() const {
+    return (cell_start.capacity() + indexes.capacity()) * sizeof(uint32_t) + positions.capacity() * sizeof(Point);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+#include "geometry.hpp"
+
+// uniform grid over a snapshot of points, finds points in a rectangle without looking at the rest
+// cells are stored as one sorted array (counting sort), so building it is O(n) and queries read memory in order
+struct PointGrid {
+    static constexpr float POINTS_PER_CELL = 4.f;
+    static constexpr int MAX_CELLS_PER_AXIS = 1024;
+
+    // positions are copied, so the grid stays valid when the points move (it just gets stale)
+    void Build(std::span<const Point> points);
+    void Clear();
+
+    size_t Size() const {
+        return positions.size();
+    }
+
+    // calls func(idx) for every point with min <= point <= max, idx is its index in the built span
+    template <typename Func>
+    void QueryRect(Point min, Point max, Func &&func) const;
+
+    size_t MemoryUsage() const;
+
+private:
+    Point origin = Vector2Zeros;
+    float inv_cell_size = 1.f;
+    int nx = 0;
+    int ny = 0;
+
+    std::vector<uint32_t> cell_start; // points of cell c are [cell_start[c], cell_start[c + 1])
+    std::vector<uint32_t> indexes;    // original index of every point, in cell order
+    std::vector<Point> positions;     // positions in the same order
+
+    int CellX(float x) const;
+    int CellY(float y) const;
+};
+
+template <typename Func>
+void PointGrid::QueryRect(Point min, Point max, Func &&func) const {
+    if (positions.empty() || min.x > max.x || min.y > max.y) {
+        return;
+    }
+
+    int x0 = CellX(min.x), x1 = CellX(max.x);
+    int y0 = CellY(min.y), y1 = CellY(max.y);
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            int cell = y * nx + x;
+
+            // cells strictly inside of the rectangle need no test, only the border ones do
+            bool inside = x > x0 && x < x1 && y > y0 && y < y1;
+
+            for (uint32_t i = cell_start[cell], end = cell_start[cell + 1]; i < end; ++i) {
+                Point p = positions[i];
+                if (inside || (p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y)) {
+                    func(indexes[i]);
+                }
+            }
+        }
+    }
+}
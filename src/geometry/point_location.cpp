@@ -0,0 +1,198 @@
+#include "point_location.hpp"
+
+#include <atomic>
+#include <cassert>
+
+#include "parallel/thread_pool.hpp"
+#include "memory/allocation_counter.hpp"
+
+namespace {
+
+// inside is on the left of every edge of a mesh triangle, with the boundary
+bool ContainsPoint(Point a, Point b, Point c, Point p) {
+    return Orientation(a, b, p) >= 0 && Orientation(b, c, p) >= 0 && Orientation(c, a, p) >= 0;
+}
+
+} // namespace
+
+uint32_t LocatePointBruteForce(const TriangleMesh &mesh, Point p) {
+    for (uint32_t t = 0; t < (uint32_t) mesh.triangles.size(); ++t) {
+        const auto &triangle = mesh.triangles[t];
+        if (IsInsideTriangle(p, mesh.vertexes[triangle[0]], mesh.vertexes[triangle[1]], mesh.vertexes[triangle[2]])) {
+            return t;
+        }
+    }
+    return TriangleMesh::NONE;
+}
+
+uint32_t MeshWalker::Locate(Point p) {
+    const auto &triangles = mesh->triangles;
+    if (triangles.empty()) {
+        return TriangleMesh::NONE;
+    }
+
+    uint32_t t = current < triangles.size() ? current : 0;
+    uint32_t came_from = TriangleMesh::NONE;
+
+    // walks end with probability 1, the limit only guards against broken meshes
+    for (size_t step = 0; step < triangles.size(); ++step) {
+        ++steps;
+
+        // xorshift32
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        uint32_t first = random_state % 3;
+
+        uint32_t next = t;
+        for (uint32_t k = 0; k < 3 && next == t; ++k) {
+            uint32_t side = (first + k) % 3;
+            uint32_t neighbour = mesh->neighbours[t][side];
+            if (neighbour == came_from && neighbour != TriangleMesh::NONE) {
+                continue;
+            }
+
+            Point a = mesh->vertexes[triangles[t][side]];
+            Point b = mesh->vertexes[triangles[t][(side + 1) % 3]];
+            if (Orientation(a, b, p) < 0) {
+                if (neighbour == TriangleMesh::NONE) {
+                    current = t;
+                    return TriangleMesh::NONE;
+                }
+                next = neighbour;
+            }
+        }
+
+        if (next == t) {
+            current = t;
+            return t;
+        }
+        came_from = t;
+        t = next;
+    }
+
+    TraceLog(LOG_WARNING, "MeshWalker: walk didn't end in %zu steps, the mesh is broken", triangles.size());
+    return LocatePointBruteForce(*mesh, p);
+}
+
+void MeshGridIndex::Clear() {
+    mesh = nullptr;
+    cell_start.clear();
+    items.clear();
+    nx = ny = 0;
+}
+
+void MeshGridIndex::Build(const TriangleMesh &mesh) {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    Clear();
+    if (mesh.triangles.empty()) {
+        return;
+    }
+    this->mesh = &mesh;
+
+    min = max = mesh.vertexes[mesh.triangles[0][0]];
+    for (const auto &triangle : mesh.triangles) {
+        for (uint32_t v : triangle) {
+            min = Vector2Min(min, mesh.vertexes[v]);
+            max = Vector2Max(max, mesh.vertexes[v]);
+        }
+    }
+
+    // square cells sized so that an average cell is touched by a few triangles
+    float width  = std::max(max.x - min.x, 1e-3f);
+    float height = std::max(max.y - min.y, 1e-3f);
+    float cell_size = std::sqrt(width * height * TRIANGLES_PER_CELL / (float) mesh.triangles.size());
+    cell_size = std::max({ cell_size, width / MAX_CELLS_PER_AXIS, height / MAX_CELLS_PER_AXIS });
+
+    inv_cell_size = 1.f / cell_size;
+    nx = std::clamp((int) (width * inv_cell_size) + 1, 1, MAX_CELLS_PER_AXIS);
+    ny = std::clamp((int) (height * inv_cell_size) + 1, 1, MAX_CELLS_PER_AXIS);
+
+    auto ForEachCell = [&](uint32_t t, auto &&func) {
+        const auto &triangle = mesh.triangles[t];
+        Point a = mesh.vertexes[triangle[0]];
+        Point b = mesh.vertexes[triangle[1]];
+        Point c = mesh.vertexes[triangle[2]];
+        int x0 = CellX(std::min({ a.x, b.x, c.x }));
+        int x1 = CellX(std::max({ a.x, b.x, c.x }));
+        int y0 = CellY(std::min({ a.y, b.y, c.y }));
+        int y1 = CellY(std::max({ a.y, b.y, c.y }));
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                func((size_t) y * nx + x);
+            }
+        }
+    };
+
+    // counting sort by cell
+    cell_start.assign((size_t) nx * ny + 1, 0);
+    for (uint32_t t = 0; t < (uint32_t) mesh.triangles.size(); ++t) {
+        ForEachCell(t, [&](size_t cell) { ++cell_start[cell + 1]; });
+    }
+    for (size_t c = 1; c < cell_start.size(); ++c) {
+        cell_start[c] += cell_start[c - 1];
+    }
+
+    items.resize(cell_start.back());
+    std::vector<uint32_t> next(cell_start.begin(), cell_start.end() - 1);
+    for (uint32_t t = 0; t < (uint32_t) mesh.triangles.size(); ++t) {
+        const auto &triangle = mesh.triangles[t];
+        Item item { mesh.vertexes[triangle[0]], mesh.vertexes[triangle[1]], mesh.vertexes[triangle[2]], t };
+        ForEachCell(t, [&](size_t cell) { items[next[cell]++] = item; });
+    }
+}
+
+uint32_t MeshGridIndex::Locate(Point p) const {
+    if (!mesh || p.x < min.x || p.y < min.y || p.x > max.x || p.y > max.y) {
+        return TriangleMesh::NONE;
+    }
+
+    size_t cell = (size_t) CellY(p.y) * nx + CellX(p.x);
+    for (uint32_t i = cell_start[cell]; i < cell_start[cell + 1]; ++i) {
+        const Item &item = items[i];
+        if (ContainsPoint(item.a, item.b, item.c, p)) {
+            return item.triangle;
+        }
+    }
+    return TriangleMesh::NONE;
+}
+
+size_t MeshGridIndex::MemoryUsage() const {
+    return cell_start.capacity() * sizeof(uint32_t) + items.capacity() * sizeof(Item);
+}
+
+void LocatePointsBruteForce(const TriangleMesh &mesh, std::span<const Point> points, std::span<uint32_t> results) {
+    assert(points.size() == results.size());
+
+    // every point is slow, so chunks are small to keep the threads busy
+    GetThreadPool().ParallelFor(points.size(), 16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = LocatePointBruteForce(mesh, points[i]);
+        }
+    });
+}
+
+size_t LocatePointsByWalk(const TriangleMesh &mesh, std::span<const Point> points, std::span<uint32_t> results) {
+    assert(points.size() == results.size());
+
+    std::atomic<size_t> steps = 0;
+    GetThreadPool().ParallelFor(points.size(), POINT_LOCATION_GRAIN, [&](size_t begin, size_t end) {
+        MeshWalker walker(mesh);
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = walker.Locate(points[i]);
+        }
+        steps += walker.steps;
+    });
+    return steps;
+}
+
+void LocatePointsByGrid(const MeshGridIndex &grid, std::span<const Point> points, std::span<uint32_t> results) {
+    assert(points.size() == results.size());
+
+    GetThreadPool().ParallelFor(points.size(), POINT_LOCATION_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i] = grid.Locate(points[i]);
+        }
+    });
+}
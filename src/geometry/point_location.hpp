@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#include "triangle_mesh.hpp"
+
+// points are split into chunks of this size, chunks are located in parallel
+static constexpr size_t POINT_LOCATION_GRAIN = 4096;
+
+// triangle with the point inside by IsInsideTriangle() over all triangles, O(n); NONE when there is none
+// points on the edges are not inside of any triangle for it
+uint32_t LocatePointBruteForce(const TriangleMesh &mesh, Point p);
+
+// remembering stochastic walk (Devillers, Pion, Teillaud): starting from the triangle of the previous query
+// it crosses an edge that has the point on its other side, edges are tried in random order
+// and the edge the walk came through is skipped; the walk may visit a triangle again, but it ends with probability 1,
+// a walk of more steps than there are triangles (only in a broken mesh) falls back to brute force
+// steps are side tests, coherent queries (neighbour pixels, points along a curve) take a few steps, random ones O(sqrt n)
+// mesh has to cover a convex area: the point is outside (NONE) when the walk reaches the boundary
+struct MeshWalker {
+    const TriangleMesh *mesh;
+    uint32_t current = 0; // triangle of the last query, the next walk starts from it
+    size_t steps = 0;     // triangles visited by all walks
+
+    explicit MeshWalker(const TriangleMesh &mesh) : mesh(&mesh) {}
+
+    // points on an edge are in either of its triangles
+    uint32_t Locate(Point p);
+
+private:
+    uint32_t random_state = 0x9e3779b9;
+};
+
+// uniform grid of buckets, every triangle is in the buckets its bounding box touches
+// a query tests the triangles of its bucket only, so it's about O(1) in any order of queries
+// buckets keep copies of their triangles, so a query reads one piece of memory
+struct MeshGridIndex {
+    static constexpr float TRIANGLES_PER_CELL = 2.f;
+    static constexpr int MAX_CELLS_PER_AXIS = 2048;
+
+    // the mesh is not copied, it must stay alive and unchanged while the index is used
+    void Build(const TriangleMesh &mesh);
+    void Clear();
+
+    size_t Size() const {
+        return items.size();
+    }
+
+    // points on an edge are in either of its triangles
+    uint32_t Locate(Point p) const;
+
+    size_t MemoryUsage() const;
+
+private:
+    const TriangleMesh *mesh = nullptr;
+    Point min = Vector2Zeros;
+    Point max = Vector2Zeros;
+    float inv_cell_size = 1.f;
+    int nx = 0;
+    int ny = 0;
+
+    struct Item {
+        Point a;
+        Point b;
+        Point c;
+        uint32_t triangle;
+    };
+
+    std::vector<uint32_t> cell_start; // triangles of cell c are [cell_start[c], cell_start[c + 1])
+    std::vector<Item> items;
+
+    int CellX(float x) const {
+        return std::clamp((int) std::floor((x - min.x) * inv_cell_size), 0, nx - 1);
+    }
+    int CellY(float y) const {
+        return std::clamp((int) std::floor((y - min.y) * inv_cell_size), 0, ny - 1);
+    }
+};
+
+// batched queries in parallel, results[i] is the triangle of points[i] or NONE
+void LocatePointsBruteForce(const TriangleMesh &mesh, std::span<const Point> points, std::span<uint32_t> results);
+// every chunk walks from one point to the next, so coherent points should be next to each other
+// returns the number of steps of all walks
+size_t LocatePointsByWalk(const TriangleMesh &mesh, std::span<const Point> points, std::span<uint32_t> results);
+void LocatePointsByGrid(const MeshGridIndex &grid, std::span<const Point> points, std::span<uint32_t> results);
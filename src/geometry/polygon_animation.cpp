@@ -1,18 +1,34 @@
 #include "polygon_animation.hpp"
+#include "convex_hull.hpp"
 
+#include "render/render.hpp"
+
+#include <algorithm>
+#include <numbers>
 #include <cassert>
+#include <cmath>
 
 PolygonAnimation::PolygonAnimation(const Polygon &polygon) :
     original_polygon(&polygon),
     original_point(polygon.GetCenter()),
-    animated_polygon(polygon),
     trajectory(original_point)
-{}
+{
+    SetShape(polygon);
+}
 
-PolygonAnimation::PolygonAnimation(const Polygon &polygon, const Polygon &trajectory) :
-    original_polygon(&polygon), animated_polygon(polygon),
+PolygonAnimation::PolygonAnimation(const Polygon &polygon, const PolygonAnimation &trajectory) :
+    original_polygon(&polygon),
     trajectory(&trajectory)
-{}
+{
+    SetShape(polygon);
+}
+
+PolygonAnimation::PolygonAnimation(const Polygon &polygon, Trajectory trajectory) :
+    original_polygon(&polygon),
+    trajectory(std::move(trajectory))
+{
+    SetShape(polygon);
+}
 
 Point PolygonAnimation::InterpolatorStep(float dt) {
     float speed = moving_speed * 100 * dt;
@@ -21,63 +37,168 @@ Point PolygonAnimation::InterpolatorStep(float dt) {
         return trajectory.GetPoint();
     }
 
-    assert(trajectory.IsPolygon() && "trajectory is in invalid state");
+    // every kind of trajectory knows its length and finds a point by distance without walking it
+    float len = trajectory.Length();
+    if (len == 0) {
+        return trajectory.PointAt(0);
+    }
+
+    trajectory_distance = fmodf(trajectory_distance + fmodf(speed, len), len);
+    return trajectory.PointAt(trajectory_distance);
+}
+
+void PolygonAnimation::Update(float dt) {
+    position = InterpolatorStep(dt);
+    SetAngle(angle + rotation_speed * dt);
+    animated_polygon_dirty = true;
+    animated_hull_dirty    = true;
+}
+
+void PolygonAnimation::Reset() {
+    SetShape(*original_polygon);
+
+    if (trajectory.IsPoint()) {
+        trajectory.GetPoint() = original_point;
+    }
+    trajectory_distance = 0.f;
+}
+
+Polygon &PolygonAnimation::AnimatedPolygon() {
+    if (!animated_polygon_dirty) {
+        return animated_polygon;
+    }
 
-    auto *polygon_trajectory = trajectory.GetPolygon();
-    if (!polygon_trajectory) {
+    // vertexes are overwritten in place, so pointers to them stay valid
+    auto &vertexes = animated_polygon.vertexes;
+    vertexes.resize(local_polygon.NumPoints());
+    for (size_t i = 0; i < vertexes.size(); ++i) {
+        vertexes[i] = GetPoint(i);
+    }
+
+    animated_polygon_dirty = false;
+    return animated_polygon;
+}
+
+const Polygon &PolygonAnimation::AnimatedHull() {
+    if (!animated_hull_dirty) {
+        return animated_hull;
+    }
+
+    auto &vertexes = animated_hull.vertexes;
+    vertexes.resize(hull_indexes.size());
+    for (size_t i = 0; i < vertexes.size(); ++i) {
+        vertexes[i] = GetPoint(hull_indexes[i]);
+    }
+
+    animated_hull_dirty = false;
+    return animated_hull;
+}
+
+void PolygonAnimation::ApplyEdits() {
+    assert(!animated_polygon_dirty && "vertexes were edited before they were computed");
+
+    Point center = animated_polygon.GetCenter();
+
+    // world = center + rotate(local, angle), so local = rotate(world - center, -angle)
+    auto &local = local_polygon.vertexes;
+    for (size_t i = 0; i < local.size(); ++i) {
+        Point d = animated_polygon.vertexes[i] - center;
+        local[i] = { d.x * cos_angle + d.y * sin_angle, -d.x * sin_angle + d.y * cos_angle };
+    }
+
+    position = center;
+    UpdateShapeMeasures();
+}
+
+Point PolygonAnimation::GetPoint(size_t idx) const {
+    if (idx >= local_polygon.NumPoints()) {
         return Vector2Zeros;
     }
 
-    float len = polygon_trajectory->Perimeter();
-    size_t npoints = polygon_trajectory->NumPoints();
+    Point p = local_polygon.vertexes[idx];
+    return {
+        position.x + p.x * cos_angle - p.y * sin_angle,
+        position.y + p.x * sin_angle + p.y * cos_angle,
+    };
+}
 
+Point PolygonAnimation::PointAtDistance(float distance) const {
+    size_t npoints = NumPoints();
     if (npoints == 0) {
         return Vector2Zeros;
     }
-    if (len == 0) {
-        return polygon_trajectory->GetPoint(0);
+
+    float sample = edge_lengths.SampleAt(distance);
+    size_t i = std::min((size_t) sample, npoints - 1);
+    return Lerp(GetPoint(i), GetPoint((i + 1) % npoints), sample - (float) i);
+}
+
+void PolygonAnimation::Shift(Point shift) {
+    position += shift;
+    animated_polygon_dirty = true;
+    animated_hull_dirty    = true;
+}
+
+void PolygonAnimation::Draw(Color color_line, Color color_point) {
+    if (IsOnScreen()) {
+        AnimatedPolygon().Draw(color_line, color_point);
     }
+}
 
-    float step_len = fmodf(speed, len);
+void PolygonAnimation::DrawCenter(Color color) const {
+    Render::DrawCircle(position, 7, color);
+}
 
-    Point a = polygon_trajectory->GetPoint(trajectory_edge_idx % npoints);
-    Point b = polygon_trajectory->GetPoint((trajectory_edge_idx + 1) % npoints);
+bool PolygonAnimation::IsOnScreen() const {
+    // points are drawn as circles of radius 5
+    float r = radius + 5;
+    return position.x + r >= 0 && position.x - r <= (float) Render::GetScreenWidth() &&
+           position.y + r >= 0 && position.y - r <= (float) Render::GetScreenHeight();
+}
 
-    Point current_pos = Lerp(a, b, trajectory_edge_interpolator);
+void PolygonAnimation::SetShape(const Polygon &polygon) {
+    Point center = polygon.NumPoints() > 0 ? polygon.GetCenter() : Vector2Zeros;
 
-    while (step_len > 0) {
-        float d = Distance(current_pos, b);
+    local_polygon.vertexes.clear();
+    for (Point p : polygon.vertexes) {
+        local_polygon.AddPoint(p - center);
+    }
 
-        if (d > step_len) {
-            trajectory_edge_interpolator += step_len / Distance(a, b);
-            break;
-        }
+    position = center;
+    SetAngle(0);
+    UpdateShapeMeasures();
 
-        // switch to next edge
-        step_len -= d;
-        trajectory_edge_interpolator = 0;
+    animated_polygon_dirty = true;
+    animated_hull_dirty    = true;
+}
 
-        current_pos = b;
-        a = b;
-        b = polygon_trajectory->GetPoint((trajectory_edge_idx + 2) % npoints);
+void PolygonAnimation::UpdateShapeMeasures() {
+    const auto &local = local_polygon.vertexes;
 
-        trajectory_edge_idx = (trajectory_edge_idx + 1) % npoints;
+    radius = 0;
+    for (Point p : local) {
+        radius = std::max(radius, Length(p));
     }
 
-    return Lerp(a, b, trajectory_edge_interpolator);
-}
+    std::vector<Point> closed(local.begin(), local.end());
+    if (!closed.empty()) {
+        closed.push_back(closed.front());
+    }
+    edge_lengths.Build(closed);
 
-void PolygonAnimation::Update(float dt) {
-    animated_polygon.SetCenter(InterpolatorStep(dt));
-    animated_polygon.Rotate(rotation_speed * dt);
+    closed.resize(local.size());
+    hull_indexes = ConvexHullIndexes(closed);
+    animated_hull_dirty = true;
 }
 
-void PolygonAnimation::Reset() {
-    animated_polygon = *original_polygon;
+void PolygonAnimation::SetAngle(float new_angle) {
+    constexpr float two_pi = 2 * std::numbers::pi_v<float>;
 
-    if (trajectory.IsPoint()) {
-        trajectory.GetPoint() = original_point;
+    angle = std::fmod(new_angle, two_pi);
+    if (angle < 0) {
+        angle += two_pi;
     }
-    trajectory_edge_idx = 0;
-    trajectory_edge_interpolator = 0.f;
-}
\ No newline at end of file
+
+    cos_angle = std::cos(angle);
+    sin_angle = std::sin(angle);
+}
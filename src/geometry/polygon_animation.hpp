@@ -1,38 +1,14 @@
 #pragma once
 
-#include <variant>
+#include <vector>
+#include <cstdint>
 
 #include "geometry.hpp"
+#include "trajectory.hpp"
 
-// simple wrapper around std::variant for convinience
-// Trajectory can be reference to polygon or single point
-struct Trajectory {
-    using PolygonPtr = const Polygon *;
-
-    std::variant<PolygonPtr, Point> trajectory;
-
-    Trajectory() = default;
-    Trajectory(PolygonPtr polygon) : trajectory(polygon) {}
-    Trajectory(Point point) : trajectory(point) {}
-
-    bool IsPolygon() const {
-        return std::holds_alternative<PolygonPtr>(trajectory);
-    }
-    bool IsPoint() const {
-        return std::holds_alternative<Point>(trajectory);
-    }
-
-    PolygonPtr GetPolygon() const {
-        return std::get<PolygonPtr>(trajectory);
-    }
-    Point& GetPoint() {
-        return std::get<Point>(trajectory);
-    }
-    Point GetPoint() const {
-        return std::get<Point>(trajectory);
-    }
-};
-
+// polygon is kept as its shape around the center plus position and angle of the center,
+// so a frame of animation costs O(1) and vertexes never drift, however long it runs
+// vertexes in the world are computed only when something reads them
 struct PolygonAnimation {
     // reference to orignal polygon that is animated
     const Polygon *original_polygon = nullptr;
@@ -40,22 +16,79 @@ struct PolygonAnimation {
     // original position of polygon if no trajectory-as-polygon was introduced
     Point original_point = Vector2Zeros;
 
-    // copy of original polygon that is actually changed during animation
-    Polygon animated_polygon;
-    
+    // vertexes relative to the center, world vertex i is position + rotate(local_polygon[i], angle)
+    Polygon local_polygon;
+    Point position = Vector2Zeros;
+    float angle    = 0.f; // radians in [0, 2pi), so its precision doesn't degrade
+
     Trajectory trajectory;
-    size_t trajectory_edge_idx         = 0;   // edge of trajectory we're currently at
-    float trajectory_edge_interpolator = 0.f; // interpolator for the current edge
-    
+    float trajectory_distance = 0.f; // from the start of the trajectory, the animation moves at constant speed along it
+
     // animation parameters
     float moving_speed   = 0.f;
     float rotation_speed = 0.f;
 
     PolygonAnimation() = default;
     PolygonAnimation(const Polygon &polygon);
-    PolygonAnimation(const Polygon &polygon, const Polygon &trajectory);
+    PolygonAnimation(const Polygon &polygon, const PolygonAnimation &trajectory);
+    PolygonAnimation(const Polygon &polygon, Trajectory trajectory);
 
     Point InterpolatorStep(float dt);
     void Update(float dt);
     void Reset();
+
+    // world vertexes, brought up to date if the animation moved since they were read last time
+    // addresses of the vertexes never change, so they can be given to PointDragger
+    // if they are edited through them, ApplyEdits() must be called before the animation moves again
+    Polygon &AnimatedPolygon();
+    // shape, position and angle are taken from the edited world vertexes
+    void ApplyEdits();
+
+    // convex hull of the world vertexes
+    // rotation and translation don't change which vertexes are on the hull, so it is found once per shape
+    // and only its vertexes are moved, instead of the whole polygon
+    const Polygon &AnimatedHull();
+
+    // same as in AnimatedPolygon(), but without computing all of them
+    Point GetPoint(size_t idx) const;
+    size_t NumPoints() const {
+        return local_polygon.NumPoints();
+    }
+    Point GetCenter() const {
+        return position;
+    }
+    // rigid motion keeps lengths, so it is the perimeter of the shape
+    float Perimeter() const {
+        return edge_lengths.Total();
+    }
+    // point on the perimeter at distance from vertex 0, when other animations move along this one
+    Point PointAtDistance(float distance) const;
+
+    void Shift(Point shift);
+
+    // polygons that are off the screen are not computed at all
+    // animations are drawn without a camera, so the screen is where they are visible
+    void Draw(Color color_line, Color color_point=BLANK);
+    void DrawCenter(Color color) const;
+    bool IsOnScreen() const;
+
+private:
+    Polygon animated_polygon;
+    bool animated_polygon_dirty = true;
+
+    std::vector<uint32_t> hull_indexes; // of the vertexes of the shape
+    Polygon animated_hull;
+    bool animated_hull_dirty = true;
+
+    float cos_angle = 1.f;
+    float sin_angle = 0.f;
+    float radius    = 0.f; // of the circle around the center that contains every vertex
+
+    ArcLengthTable edge_lengths; // of the closed shape, vertex 0 is repeated at the end
+
+    // take the shape of the polygon, its center becomes the position
+    void SetShape(const Polygon &polygon);
+    // perimeter, bounds and hull of the shape
+    void UpdateShapeMeasures();
+    void SetAngle(float new_angle);
 };
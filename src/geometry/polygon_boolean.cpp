@@ -0,0 +1,455 @@
+#include "polygon_boolean.hpp"
+
+#include "segment_grid.hpp"
+#include "parallel/thread_pool.hpp"
+
+#include <algorithm>
+#include <numbers>
+#include <cstdint>
+#include <cassert>
+#include <cmath>
+#include <mutex>
+#include <optional>
+#include <set>
+
+namespace {
+
+// pieces usually stop crossing after one more split, rounding that keeps making new crossings is cut off
+constexpr int MAX_SPLIT_ROUNDS = 4;
+
+double Dot(Point o, Point a, Point b) {
+    return ((double) a.x - o.x) * ((double) b.x - o.x) + ((double) a.y - o.y) * ((double) b.y - o.y);
+}
+
+bool PointLess(Point a, Point b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+bool PointEqual(Point a, Point b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+// edge of the operands from a to b
+struct Edge {
+    Point a;
+    Point b;
+    int winding[2]; // what crossing it from right to left adds to the winding numbers of the subject and the clip
+    bool moved = false; // piece of an edge that was split at a rounded crossing
+};
+
+std::vector<Edge> CollectEdges(std::span<const Polygon> subject, std::span<const Polygon> clip) {
+    std::vector<Edge> edges;
+    for (int operand = 0; operand < 2; ++operand) {
+        for (const Polygon &ring : operand == 0 ? subject : clip) {
+            const auto &v = ring.vertexes;
+            for (size_t i = 0; i < v.size(); ++i) {
+                Point a = v[i];
+                Point b = v[(i + 1) % v.size()];
+                if (!PointEqual(a, b)) {
+                    edges.push_back({ a, b, { operand == 0 ? 1 : 0, operand == 1 ? 1 : 0 } });
+                }
+            }
+        }
+    }
+    return edges;
+}
+
+// p is on the line of the edge, is it strictly between its ends
+bool IsInsideEdge(Point p, const Edge &edge) {
+    return Dot(edge.a, p, edge.b) > 0 && Dot(edge.b, p, edge.a) > 0;
+}
+
+// points where every edge must be split: crossings and ends of other edges that lie on it (so collinear overlaps too)
+// crossed[i] is set when edge i is split at a crossing; with only_moved, pairs of edges that didn't move aren't tested
+std::vector<std::vector<Point>> FindSplits(std::span<const Edge> edges, std::vector<uint8_t> &crossed, bool only_moved=false) {
+    struct Split {
+        uint32_t edge;
+        Point point;
+        bool crossing;
+    };
+
+    auto TestPair = [&](uint32_t i, uint32_t j, std::vector<Split> &found) {
+        const Edge &e = edges[i];
+        const Edge &f = edges[j];
+
+        double d1 = Orientation(e.a, e.b, f.a);
+        double d2 = Orientation(e.a, e.b, f.b);
+        double d3 = Orientation(f.a, f.b, e.a);
+        double d4 = Orientation(f.a, f.b, e.b);
+
+        if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+            // both edges are split at the same rounded point, so their pieces meet exactly
+            double t = d3 / (d3 - d4);
+            Point p = {
+                (float) (e.a.x + ((double) e.b.x - e.a.x) * t),
+                (float) (e.a.y + ((double) e.b.y - e.a.y) * t),
+            };
+            found.push_back({ i, p, true });
+            found.push_back({ j, p, true });
+            return;
+        }
+
+        if (d1 == 0 && IsInsideEdge(f.a, e)) found.push_back({ i, f.a, false });
+        if (d2 == 0 && IsInsideEdge(f.b, e)) found.push_back({ i, f.b, false });
+        if (d3 == 0 && IsInsideEdge(e.a, f)) found.push_back({ j, e.a, false });
+        if (d4 == 0 && IsInsideEdge(e.b, f)) found.push_back({ j, e.b, false });
+    };
+
+    std::vector<Point> a(edges.size());
+    std::vector<Point> b(edges.size());
+    std::vector<Point> min(edges.size());
+    std::vector<Point> max(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        a[i] = edges[i].a;
+        b[i] = edges[i].b;
+        min[i] = Vector2Min(a[i], b[i]);
+        max[i] = Vector2Max(a[i], b[i]);
+    }
+
+    SegmentGrid grid;
+    grid.Build(a, b);
+
+    std::vector<Split> splits;
+    std::mutex splits_mutex;
+    GetThreadPool().ParallelFor(grid.NumCells(), 256, [&](size_t begin, size_t end) {
+        std::vector<Split> found;
+        std::vector<uint32_t> items;
+        for (size_t cell = begin; cell < end; ++cell) {
+            // edges of a curve crowd into the cells it goes through, so they are swept by x inside of the cell too
+            auto cell_items = grid.Cell(cell);
+            items.assign(cell_items.begin(), cell_items.end());
+            std::sort(items.begin(), items.end(), [&](uint32_t i, uint32_t j) { return min[i].x < min[j].x; });
+
+            for (size_t k = 0; k < items.size(); ++k) {
+                uint32_t i = items[k];
+                for (size_t l = k + 1; l < items.size() && min[items[l]].x <= max[i].x; ++l) {
+                    uint32_t j = items[l];
+                    if (min[j].y > max[i].y || min[i].y > max[j].y) {
+                        continue;
+                    }
+                    if (only_moved && !edges[i].moved && !edges[j].moved) {
+                        continue;
+                    }
+                    // boxes of the edges overlap in the cells of their common box, the pair is tested in the first one
+                    if (grid.CellOf(Vector2Max(min[i], min[j])) != cell) {
+                        continue;
+                    }
+                    TestPair(i, j, found);
+                }
+            }
+        }
+
+        std::lock_guard lock(splits_mutex);
+        splits.insert(splits.end(), found.begin(), found.end());
+    });
+
+    std::vector<std::vector<Point>> edge_splits(edges.size());
+    crossed.assign(edges.size(), 0);
+    for (const Split &split : splits) {
+        edge_splits[split.edge].push_back(split.point);
+        crossed[split.edge] |= split.crossing;
+    }
+    return edge_splits;
+}
+
+// piece of an edge that doesn't cross other pieces, from its leftmost end to the rightmost one
+// pieces of different edges that are the same segment are merged
+struct Segment {
+    Point left;
+    Point right;
+    int winding[2] = { 0, 0 }; // what crossing it from below to above adds to the winding numbers of the operands
+    int above[2]   = { 0, 0 }; // winding numbers of the area just above it
+
+    bool boundary = false;     // of the result
+    bool forward  = false;     // result goes from left to right, it's inside above then
+    bool moved    = false;     // piece of an edge that was split at a rounded crossing
+};
+
+std::vector<Segment> SplitEdges(std::span<const Edge> edges, std::vector<std::vector<Point>> &splits, std::span<const uint8_t> crossed) {
+    std::vector<Segment> segments;
+
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const Edge &edge = edges[i];
+        auto &points = splits[i];
+        std::sort(points.begin(), points.end(), [&](Point p, Point q) { return Dot(edge.a, p, edge.b) < Dot(edge.a, q, edge.b); });
+        points.push_back(edge.b);
+
+        Point from = edge.a;
+        for (Point to : points) {
+            if (PointEqual(from, to)) {
+                continue;
+            }
+
+            Segment segment;
+            // area on the left of an edge is above it when the edge goes to the right
+            bool to_the_right = PointLess(from, to);
+            segment.left  = to_the_right ? from : to;
+            segment.right = to_the_right ? to : from;
+            segment.winding[0] = to_the_right ? edge.winding[0] : -edge.winding[0];
+            segment.winding[1] = to_the_right ? edge.winding[1] : -edge.winding[1];
+            segment.moved = crossed[i] != 0;
+            segments.push_back(segment);
+
+            from = to;
+        }
+    }
+
+    std::sort(segments.begin(), segments.end(), [](const Segment &s, const Segment &t) {
+        if (!PointEqual(s.left, t.left)) {
+            return PointLess(s.left, t.left);
+        }
+        return PointLess(s.right, t.right);
+    });
+
+    // shared edges (e.g. of polygons that touch) become one segment, so there is no area between them
+    size_t kept = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (kept > 0 && PointEqual(segments[kept - 1].left, segments[i].left) && PointEqual(segments[kept - 1].right, segments[i].right)) {
+            segments[kept - 1].winding[0] += segments[i].winding[0];
+            segments[kept - 1].winding[1] += segments[i].winding[1];
+            segments[kept - 1].moved = segments[kept - 1].moved || segments[i].moved;
+        } else {
+            segments[kept++] = segments[i];
+        }
+    }
+    segments.resize(kept);
+
+    std::erase_if(segments, [](const Segment &s) { return s.winding[0] == 0 && s.winding[1] == 0; });
+    return segments;
+}
+
+struct SweepEvent {
+    Point point;
+    uint32_t segment;
+    bool left; // the segment starts here
+};
+
+// segment i is below segment j, both of them cross the sweep line and don't cross each other
+struct StatusLess {
+    const std::vector<Segment> *segments;
+
+    bool operator()(uint32_t i, uint32_t j) const {
+        if (i == j) {
+            return false;
+        }
+        const Segment &s = (*segments)[i];
+        const Segment &t = (*segments)[j];
+
+        if (PointEqual(s.left, t.left)) {
+            double o = Orientation(s.left, s.right, t.right);
+            return o != 0 ? o > 0 : i < j;
+        }
+
+        // the segment that started later is compared against the other one at its start
+        if (PointLess(s.left, t.left)) {
+            double o = Orientation(s.left, s.right, t.left);
+            if (o == 0) {
+                o = Orientation(s.left, s.right, t.right);
+            }
+            return o != 0 ? o > 0 : i < j;
+        }
+        double o = Orientation(t.left, t.right, s.left);
+        if (o == 0) {
+            o = Orientation(t.left, t.right, s.right);
+        }
+        return o != 0 ? o < 0 : i < j;
+    }
+};
+
+bool IsInside(int winding, FillRule fill_rule) {
+    return fill_rule == FillRule::EvenOdd ? (winding & 1) != 0 : winding != 0;
+}
+
+bool IsInsideResult(const int winding[2], BooleanOperation operation, FillRule fill_rule) {
+    bool subject = IsInside(winding[0], fill_rule);
+    bool clip    = IsInside(winding[1], fill_rule);
+
+    switch (operation) {
+        case BooleanOperation::Union:        return subject || clip;
+        case BooleanOperation::Intersection: return subject && clip;
+        case BooleanOperation::Difference:   return subject && !clip;
+        case BooleanOperation::Xor:          return subject != clip;
+    }
+    return false;
+}
+
+// winding numbers above every segment come from the segment right below it when it starts
+void ClassifySegments(std::vector<Segment> &segments, BooleanOperation operation, FillRule fill_rule) {
+    std::vector<SweepEvent> events;
+    events.reserve(2 * segments.size());
+    for (uint32_t i = 0; i < segments.size(); ++i) {
+        events.push_back({ segments[i].left, i, true });
+        events.push_back({ segments[i].right, i, false });
+    }
+
+    std::sort(events.begin(), events.end(), [&](const SweepEvent &e, const SweepEvent &f) {
+        if (!PointEqual(e.point, f.point)) {
+            return PointLess(e.point, f.point);
+        }
+        // segments that end here leave before new ones come, and new ones come from the bottom up,
+        // so the segment below every new one is already classified
+        if (e.left != f.left) {
+            return !e.left;
+        }
+        if (e.left) {
+            double o = Orientation(e.point, segments[e.segment].right, segments[f.segment].right);
+            if (o != 0) {
+                return o > 0;
+            }
+        }
+        return e.segment < f.segment;
+    });
+
+    using Status = std::set<uint32_t, StatusLess>;
+    Status status(StatusLess{ &segments });
+    std::vector<Status::iterator> positions(segments.size());
+
+    for (const SweepEvent &event : events) {
+        if (!event.left) {
+            status.erase(positions[event.segment]);
+            continue;
+        }
+
+        auto it = status.insert(event.segment).first;
+        positions[event.segment] = it;
+
+        Segment &segment = segments[event.segment];
+        int below[2] = { 0, 0 };
+        if (it != status.begin()) {
+            const Segment &previous = segments[*std::prev(it)];
+            below[0] = previous.above[0];
+            below[1] = previous.above[1];
+        }
+        segment.above[0] = below[0] + segment.winding[0];
+        segment.above[1] = below[1] + segment.winding[1];
+
+        bool inside_below = IsInsideResult(below, operation, fill_rule);
+        bool inside_above = IsInsideResult(segment.above, operation, fill_rule);
+        segment.boundary = inside_below != inside_above;
+        segment.forward  = inside_above;
+    }
+}
+
+// boundary segments are chained into rings with the result on the left
+// where several rings touch, the ring turns to the edge that is the first clockwise from where it came,
+// so it goes around one face and touching rings stay apart
+std::vector<Polygon> ConnectRings(std::span<const Segment> segments) {
+    struct Directed {
+        Point from;
+        Point to;
+    };
+    std::vector<Directed> edges;
+    for (const Segment &s : segments) {
+        if (s.boundary) {
+            edges.push_back(s.forward ? Directed{ s.left, s.right } : Directed{ s.right, s.left });
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const Directed &e, const Directed &f) { return PointLess(e.from, f.from); });
+
+    std::vector<uint8_t> used(edges.size(), 0);
+    std::vector<Polygon> rings;
+
+    for (size_t start = 0; start < edges.size(); ++start) {
+        if (used[start]) {
+            continue;
+        }
+
+        Polygon ring;
+        size_t current = start;
+        while (true) {
+            used[current] = 1;
+            ring.AddPoint(edges[current].from);
+
+            Point at = edges[current].to;
+            if (PointEqual(at, edges[start].from)) {
+                break;
+            }
+
+            Vector2 back = edges[current].from - at;
+            auto first = std::partition_point(edges.begin(), edges.end(), [&](const Directed &e) { return PointLess(e.from, at); });
+
+            std::optional<size_t> next;
+            double best_angle = 0;
+            for (auto it = first; it != edges.end() && PointEqual(it->from, at); ++it) {
+                size_t idx = it - edges.begin();
+                if (used[idx]) {
+                    continue;
+                }
+                Vector2 out = it->to - at;
+                // clockwise angle from the way back to the edge, in (0, 2pi]
+                double angle = std::atan2(-((double) back.x * out.y - (double) back.y * out.x), (double) back.x * out.x + (double) back.y * out.y);
+                if (angle <= 0) {
+                    angle += 2 * std::numbers::pi;
+                }
+                if (!next.has_value() || angle < best_angle) {
+                    next = idx;
+                    best_angle = angle;
+                }
+            }
+
+            // every vertex of the boundary has as many edges going in as going out, so it happens only after rounding
+            if (!next.has_value()) {
+                break;
+            }
+            current = next.value();
+        }
+
+        // vertexes where edges were split in the middle of a straight line
+        auto &v = ring.vertexes;
+        for (size_t i = 0; i < v.size() && v.size() >= 3;) {
+            if (Orientation(v[(i + v.size() - 1) % v.size()], v[i], v[(i + 1) % v.size()]) == 0) {
+                v.erase(v.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+
+        if (ring.NumPoints() >= 3) {
+            rings.push_back(std::move(ring));
+        }
+    }
+
+    return rings;
+}
+
+} // namespace
+
+std::vector<Polygon> PolygonBoolean(std::span<const Polygon> subject, std::span<const Polygon> clip,
+                                    BooleanOperation operation, FillRule fill_rule) {
+    std::vector<Edge> edges = CollectEdges(subject, clip);
+    std::vector<uint8_t> crossed;
+    std::vector<std::vector<Point>> splits = FindSplits(edges, crossed);
+    std::vector<Segment> segments = SplitEdges(edges, splits, crossed);
+
+    // crossings are rounded to floats, which turns pieces a little, so where edges are dense they may cross other pieces
+    // and the sweep would put them in the wrong order, such pieces are split again
+    for (int round = 0; round < MAX_SPLIT_ROUNDS; ++round) {
+        if (std::none_of(segments.begin(), segments.end(), [](const Segment &s) { return s.moved; })) {
+            break;
+        }
+        edges.clear();
+        for (const Segment &segment : segments) {
+            edges.push_back({ segment.left, segment.right, { segment.winding[0], segment.winding[1] }, segment.moved });
+        }
+        splits = FindSplits(edges, crossed, true);
+        if (std::all_of(splits.begin(), splits.end(), [](const auto &points) { return points.empty(); })) {
+            break;
+        }
+        segments = SplitEdges(edges, splits, crossed);
+    }
+    ClassifySegments(segments, operation, fill_rule);
+    return ConnectRings(segments);
+}
+
+std::vector<std::vector<Polygon>> PolygonBooleanMany(std::span<const BooleanJob> jobs) {
+    std::vector<std::vector<Polygon>> results(jobs.size());
+
+    GetThreadPool().ParallelFor(jobs.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const BooleanJob &job = jobs[i];
+            results[i] = PolygonBoolean(job.subject, job.clip, job.operation, job.fill_rule);
+        }
+    });
+
+    return results;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <span>
+
+#include "geometry.hpp"
+
+enum class BooleanOperation {
+    Union,
+    Intersection,
+    Difference, // subject without clip
+    Xor,
+};
+
+// which points are inside of a set of rings that may cross themselves and each other
+enum class FillRule {
+    EvenOdd, // inside when a ray from the point crosses the rings an odd number of times, orientation doesn't matter
+    NonZero, // inside when the rings wind around the point, holes must go the other way than their outer ring
+};
+
+// operands are sets of rings, e.g. outer boundaries and their holes
+// edges are split where they cross or touch, then one sweep over x (as in Martinez-Rueda) finds the winding numbers
+// on both sides of every piece, pieces with the result inside on one side only are its boundary
+// the sweep is O((n + k) log n) for n edges and k crossings; crossings are found in parallel with a SegmentGrid,
+// which is about linear while edges are short compared to the operands, but long edges over many others make it slower
+// result rings go counter-clockwise around the area in math coordinates (clockwise on the screen, where y goes down),
+// holes go the other way
+std::vector<Polygon> PolygonBoolean(std::span<const Polygon> subject, std::span<const Polygon> clip,
+                                    BooleanOperation operation, FillRule fill_rule=FillRule::EvenOdd);
+
+struct BooleanJob {
+    std::span<const Polygon> subject;
+    std::span<const Polygon> clip;
+    BooleanOperation operation = BooleanOperation::Intersection;
+    FillRule fill_rule = FillRule::EvenOdd;
+};
+
+// independent jobs (e.g. thousands of shapes clipped against the viewport) are done in parallel, results[i] is of jobs[i]
+std::vector<std::vector<Polygon>> PolygonBooleanMany(std::span<const BooleanJob> jobs);
@@ -0,0 +1,41 @@
+#include "segment_grid.hpp"
+
+void SegmentGrid::Build(std::span<const Point> a, std::span<const Point> b) {
+    size_t n = a.size();
+    if (n == 0) {
+        nx = ny = 1;
+        cell_start.assign(2, 0);
+        items.clear();
+        return;
+    }
+
+    Point min = a[0];
+    Point max = a[0];
+    float total_length = 0;
+    for (size_t i = 0; i < n; ++i) {
+        min = Vector2Min(min, Vector2Min(a[i], b[i]));
+        max = Vector2Max(max, Vector2Max(a[i], b[i]));
+        total_length += Vector2Distance(a[i], b[i]);
+    }
+
+    float width  = std::max(max.x - min.x, 1.f);
+    float height = std::max(max.y - min.y, 1.f);
+    float cell_size = std::max(total_length / (float) n, std::sqrt(width * height / (float) n));
+    cell_size = std::max({ cell_size, width / MAX_CELLS_PER_AXIS, height / MAX_CELLS_PER_AXIS });
+
+    origin = min;
+    inv_cell_size = 1.f / cell_size;
+    nx = std::clamp((int) (width * inv_cell_size) + 1, 1, MAX_CELLS_PER_AXIS);
+    ny = std::clamp((int) (height * inv_cell_size) + 1, 1, MAX_CELLS_PER_AXIS);
+
+    // counting sort, every segment goes into the cells of its bounding box
+    cell_start.assign((size_t) nx * ny + 1, 0);
+    ForEachCell(a, b, [&](size_t, size_t cell) { ++cell_start[cell + 1]; });
+    for (size_t c = 1; c < cell_start.size(); ++c) {
+        cell_start[c] += cell_start[c - 1];
+    }
+
+    items.resize(cell_start.back());
+    std::vector<uint32_t> next(cell_start.begin(), cell_start.end() - 1);
+    ForEachCell(a, b, [&](size_t i, size_t cell) { items[next[cell]++] = (uint32_t) i; });
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#include "geometry.hpp"
+
+// uniform grid over segments a[i] -> b[i], every segment is in the cells of its bounding box
+// segments that cross each other share a cell, so only segments of the same cell have to be tested
+struct SegmentGrid {
+    Point origin = Vector2Zeros;
+    float inv_cell_size = 1.f;
+    int nx = 1;
+    int ny = 1;
+    std::vector<uint32_t> cell_start;
+    std::vector<uint32_t> items;
+
+    static constexpr int MAX_CELLS_PER_AXIS = 1024;
+
+    // cells are about as big as an average segment, so a segment covers a few of them
+    void Build(std::span<const Point> a, std::span<const Point> b);
+
+    size_t NumCells() const {
+        return (size_t) nx * ny;
+    }
+
+    std::span<const uint32_t> Cell(size_t cell) const {
+        return { items.data() + cell_start[cell], items.data() + cell_start[cell + 1] };
+    }
+
+    // points outside of the grid are in its border cells
+    size_t CellOf(Point p) const {
+        return (size_t) CellY(p.y) * nx + CellX(p.x);
+    }
+
+    // cells that the segment a -> b goes through, column by column, with one more cell above and below
+    // so that rounding never skips one, a segment that crosses it is in one of them
+    template <typename Func>
+    void ForEachCellOnSegment(Point a, Point b, Func &&func) const {
+        if (a.x > b.x) {
+            std::swap(a, b);
+        }
+        float slope = b.x > a.x ? (b.y - a.y) / (b.x - a.x) : 0.f;
+        int x0 = CellX(a.x);
+        int x1 = CellX(b.x);
+        for (int x = x0; x <= x1; ++x) {
+            // border columns also hold everything outside of the grid
+            float left  = x == x0 ? a.x : origin.x + x / inv_cell_size;
+            float right = x == x1 ? b.x : origin.x + (x + 1) / inv_cell_size;
+            float y_left  = x == x0 ? a.y : a.y + (left - a.x) * slope;
+            float y_right = x == x1 ? b.y : a.y + (right - a.x) * slope;
+            int y0 = std::max(CellY(std::min(y_left, y_right)) - 1, 0);
+            int y1 = std::min(CellY(std::max(y_left, y_right)) + 1, ny - 1);
+            for (int y = y0; y <= y1; ++y) {
+                func((size_t) y * nx + x);
+            }
+        }
+    }
+
+private:
+    int CellX(float x) const {
+        return std::clamp((int) std::floor((x - origin.x) * inv_cell_size), 0, nx - 1);
+    }
+    int CellY(float y) const {
+        return std::clamp((int) std::floor((y - origin.y) * inv_cell_size), 0, ny - 1);
+    }
+
+    template <typename Func>
+    void ForEachCell(std::span<const Point> a, std::span<const Point> b, Func &&func) const {
+        for (size_t i = 0; i < a.size(); ++i) {
+            int x0 = CellX(std::min(a[i].x, b[i].x));
+            int x1 = CellX(std::max(a[i].x, b[i].x));
+            int y0 = CellY(std::min(a[i].y, b[i].y));
+            int y1 = CellY(std::max(a[i].y, b[i].y));
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    func(i, (size_t) y * nx + x);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,419 @@
+#include "simplify.hpp"
+
+#include "segment_grid.hpp"
+#include "parallel/thread_pool.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <mutex>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+float DistanceToSegmentSqr(Point p, Point a, Point b) {
+    Vector2 ab = b - a;
+    float len_sqr = Vector2LengthSqr(ab);
+    float t = len_sqr > 0 ? Clamp(Vector2DotProduct(p - a, ab) / len_sqr, 0.f, 1.f) : 0.f;
+    return Vector2DistanceSqr(p, a + ab * t);
+}
+
+// segments cross in a point that is inside both of them, touching or sharing an end doesn't count
+bool SegmentsCross(Point a, Point b, Point x, Point y) {
+    double d1 = Orientation(a, b, x);
+    double d2 = Orientation(a, b, y);
+    double d3 = Orientation(x, y, a);
+    double d4 = Orientation(x, y, b);
+    return ((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0));
+}
+
+// vertexes of the chain (first, last) that are needed, ends are already kept
+void DouglasPeucker(std::span<const Point> points, size_t first, size_t last, float tolerance, std::vector<uint8_t> &keep) {
+    float tolerance_sqr = tolerance * tolerance;
+
+    std::vector<std::pair<size_t, size_t>> stack { { first, last } };
+    while (!stack.empty()) {
+        auto [a, b] = stack.back();
+        stack.pop_back();
+
+        float max_distance = -1;
+        size_t farthest = a;
+        for (size_t i = a + 1; i < b; ++i) {
+            float distance = DistanceToSegmentSqr(points[i], points[a], points[b]);
+            if (distance > max_distance) {
+                max_distance = distance;
+                farthest = i;
+            }
+        }
+
+        if (max_distance > tolerance_sqr) {
+            keep[farthest] = 1;
+            stack.push_back({ a, farthest });
+            stack.push_back({ farthest, b });
+        }
+    }
+}
+
+// vertex with the smallest triangle is removed first, its neighbours get new triangles
+// triangle of a vertex is never smaller than the one removed before it (effective area), so removal order is monotonic
+void VisvalingamWhyatt(std::span<const Point> points, size_t first, size_t last, float tolerance, std::vector<uint8_t> &keep) {
+    float min_area = tolerance * tolerance;
+    size_t n = last - first + 1;
+    if (n < 3) {
+        return;
+    }
+
+    // local indexes, prev/next form a linked list of the vertexes that are left
+    std::vector<uint32_t> prev(n), next(n);
+    std::vector<float> area(n, 0.f);
+
+    auto Triangle = [&](size_t i) {
+        Point a = points[first + prev[i]];
+        Point b = points[first + i];
+        Point c = points[first + next[i]];
+        return (float) std::abs(Orientation(a, b, c)) / 2;
+    };
+
+    using Entry = std::pair<float, uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+
+    for (size_t i = 1; i + 1 < n; ++i) {
+        prev[i] = (uint32_t) i - 1;
+        next[i] = (uint32_t) i + 1;
+        area[i] = Triangle(i);
+        heap.push({ area[i], (uint32_t) i });
+    }
+
+    std::vector<uint8_t> removed(n, 0);
+    while (!heap.empty()) {
+        auto [a, i] = heap.top();
+        heap.pop();
+
+        // stale entry, the triangle changed after it was pushed
+        if (removed[i] || a != area[i]) {
+            continue;
+        }
+        if (a >= min_area) {
+            break;
+        }
+
+        removed[i] = 1;
+        keep[first + i] = 0;
+
+        uint32_t p = prev[i];
+        uint32_t q = next[i];
+        next[p] = q;
+        prev[q] = p;
+
+        for (uint32_t j : { p, q }) {
+            if (j != 0 && j != n - 1) {
+                area[j] = std::max(Triangle(j), a);
+                heap.push({ area[j], j });
+            }
+        }
+    }
+}
+
+// vertexes of the chain [0, last] to keep, ends included
+std::vector<uint8_t> SimplifyChain(std::span<const Point> points, size_t last, float tolerance, SimplifyMethod method) {
+    // Douglas-Peucker adds vertexes to the ends, Visvalingam-Whyatt removes vertexes from all of them
+    std::vector<uint8_t> keep(last + 1, method == SimplifyMethod::DouglasPeucker ? 0 : 1);
+    keep[0] = keep[last] = 1;
+
+    auto SimplifyRange = [&](size_t first, size_t last) {
+        if (method == SimplifyMethod::DouglasPeucker) {
+            DouglasPeucker(points, first, last, tolerance, keep);
+        } else {
+            VisvalingamWhyatt(points, first, last, tolerance, keep);
+        }
+    };
+
+    if (last + 1 < SIMPLIFY_PARALLEL_THRESHOLD) {
+        SimplifyRange(0, last);
+        return keep;
+    }
+
+    // chunks share their ends, every chunk writes only inside of itself
+    ThreadPool &pool = GetThreadPool();
+    size_t nchunks = std::max<size_t>(pool.NumThreads() * 4, 1);
+    size_t chunk = (last + nchunks - 1) / nchunks;
+    for (size_t i = chunk; i < last; i += chunk) {
+        keep[i] = 1;
+    }
+
+    pool.ParallelFor(nchunks, 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            size_t first = c * chunk;
+            if (first < last) {
+                SimplifyRange(first, std::min(first + chunk, last));
+            }
+        }
+    });
+
+    return keep;
+}
+
+// simplified edges that cross another edge get back the vertex farthest from them, until nothing crosses
+// edges that were not simplified are left alone, if they cross it was so in the original polyline too
+// polylines that cross themselves a lot could take many rounds, so after a few ones edges get back all their vertexes
+void RepairTopology(std::span<const Point> points, std::vector<uint32_t> &kept, bool closed) {
+    static constexpr int FARTHEST_VERTEX_ROUNDS = 4;
+
+    size_t n = points.size();
+
+    std::vector<Point> a, b;
+    for (int round = 0; ; ++round) {
+        size_t nedges = closed ? kept.size() : kept.size() - 1;
+        if (nedges < 2) {
+            return;
+        }
+
+        auto EdgeEnd = [&](size_t e) -> size_t {
+            return e + 1 < kept.size() ? kept[e + 1] : kept[0] + n;
+        };
+        auto IsSimplified = [&](size_t e) {
+            return EdgeEnd(e) - kept[e] > 1;
+        };
+
+        a.resize(nedges);
+        b.resize(nedges);
+        for (size_t e = 0; e < nedges; ++e) {
+            a[e] = points[kept[e]];
+            b[e] = points[EdgeEnd(e) % n];
+        }
+
+        SegmentGrid grid;
+        grid.Build(a, b);
+
+        std::vector<uint32_t> crossing;
+        std::mutex crossing_mutex;
+        GetThreadPool().ParallelFor(grid.NumCells(), 256, [&](size_t begin, size_t end) {
+            std::vector<uint32_t> found;
+            for (size_t cell = begin; cell < end; ++cell) {
+                auto edges = grid.Cell(cell);
+                for (size_t i = 0; i < edges.size(); ++i) {
+                    for (size_t j = i + 1; j < edges.size(); ++j) {
+                        uint32_t e = edges[i];
+                        uint32_t f = edges[j];
+                        if ((IsSimplified(e) || IsSimplified(f)) && SegmentsCross(a[e], b[e], a[f], b[f])) {
+                            if (IsSimplified(e)) {
+                                found.push_back(e);
+                            }
+                            if (IsSimplified(f)) {
+                                found.push_back(f);
+                            }
+                        }
+                    }
+                }
+            }
+
+            std::lock_guard lock(crossing_mutex);
+            crossing.insert(crossing.end(), found.begin(), found.end());
+        });
+
+        if (crossing.empty()) {
+            return;
+        }
+
+        std::sort(crossing.begin(), crossing.end());
+        crossing.erase(std::unique(crossing.begin(), crossing.end()), crossing.end());
+
+        std::vector<uint32_t> restored;
+        for (uint32_t e : crossing) {
+            size_t first = kept[e];
+            size_t last  = EdgeEnd(e);
+
+            if (round >= FARTHEST_VERTEX_ROUNDS) {
+                for (size_t i = first + 1; i < last; ++i) {
+                    restored.push_back((uint32_t) (i % n));
+                }
+                continue;
+            }
+
+            float max_distance = -1;
+            size_t farthest = first + 1;
+            for (size_t i = first + 1; i < last; ++i) {
+                float distance = DistanceToSegmentSqr(points[i % n], a[e], b[e]);
+                if (distance > max_distance) {
+                    max_distance = distance;
+                    farthest = i;
+                }
+            }
+            restored.push_back((uint32_t) (farthest % n));
+        }
+
+        kept.insert(kept.end(), restored.begin(), restored.end());
+        std::sort(kept.begin(), kept.end());
+    }
+}
+
+} // namespace
+
+std::vector<uint32_t> Simplify(std::span<const Point> points, float tolerance, SimplifyMethod method, bool closed) {
+    size_t n = points.size();
+
+    std::vector<uint32_t> kept;
+    if (n <= (closed ? 3u : 2u)) {
+        for (uint32_t i = 0; i < (uint32_t) n; ++i) {
+            kept.push_back(i);
+        }
+        return kept;
+    }
+
+    std::vector<uint8_t> keep;
+    if (closed) {
+        // closed polygon is a chain that comes back to its first vertex
+        std::vector<Point> chain(points.begin(), points.end());
+        chain.push_back(points[0]);
+        keep = SimplifyChain(chain, n, tolerance, method);
+        keep.pop_back();
+    } else {
+        keep = SimplifyChain(points, n - 1, tolerance, method);
+    }
+
+    for (uint32_t i = 0; i < (uint32_t) n; ++i) {
+        if (keep[i]) {
+            kept.push_back(i);
+        }
+    }
+
+    // polygon smaller than the tolerance keeps its shape as a triangle: the first vertex,
+    // the one farthest from it and the one farthest from the line between them
+    if (closed && kept.size() < 3) {
+        auto Farthest = [&](auto &&distance) {
+            uint32_t farthest = 0;
+            for (uint32_t i = 1; i < (uint32_t) n; ++i) {
+                if (distance(points[i]) > distance(points[farthest])) {
+                    farthest = i;
+                }
+            }
+            return farthest;
+        };
+
+        uint32_t second = Farthest([&](Point p) { return Vector2DistanceSqr(p, points[0]); });
+        uint32_t third  = Farthest([&](Point p) { return std::abs(Orientation(points[0], points[second], p)); });
+        kept = { 0, second, third };
+        std::sort(kept.begin(), kept.end());
+        kept.erase(std::unique(kept.begin(), kept.end()), kept.end());
+    }
+
+    RepairTopology(points, kept, closed);
+    return kept;
+}
+
+void SimplifyPolygon(Polygon &polygon, float tolerance, SimplifyMethod method) {
+    std::vector<Point> points(polygon.vertexes.begin(), polygon.vertexes.end());
+    std::vector<uint32_t> kept = Simplify(points, tolerance, method);
+
+    polygon.vertexes.clear();
+    for (uint32_t i : kept) {
+        polygon.vertexes.push_back(points[i]);
+    }
+}
+
+void StreamingSimplifier::Begin(float tolerance) {
+    this->tolerance = tolerance;
+    points.clear();
+    run.clear();
+    kept_edges.clear();
+    num_indexed = 0;
+}
+
+void StreamingSimplifier::Add(Point point) {
+    if (points.empty()) {
+        points.push_back(point);
+        run.assign({ point });
+        return;
+    }
+    if (point == points.back()) {
+        return;
+    }
+
+    run.push_back(point);
+
+    // run.size() == 2 means the new point is the first one after the kept vertex, there is nothing to drop
+    bool fits = run.size() > 2 && run.size() <= MAX_RUN;
+    if (fits) {
+        float tolerance_sqr = tolerance * tolerance;
+        for (size_t i = 1; i + 1 < run.size(); ++i) {
+            if (DistanceToSegmentSqr(run[i], run.front(), point) > tolerance_sqr) {
+                fits = false;
+                break;
+            }
+        }
+    }
+    if (fits) {
+        IndexKept();
+        fits = !CrossesKept(run.front(), point);
+    }
+
+    if (fits) {
+        // previous point is dropped
+        points.back() = point;
+        return;
+    }
+
+    if (run.size() > 2) {
+        // previous point is kept, the run starts at it
+        run.erase(run.begin(), run.end() - 2);
+    }
+    points.push_back(point);
+}
+
+void StreamingSimplifier::KeepLast() {
+    if (!points.empty()) {
+        run.assign({ points.back() });
+    }
+}
+
+void StreamingSimplifier::Shift(Point shift) {
+    for (Point &p : points) {
+        p += shift;
+    }
+    for (Point &p : run) {
+        p += shift;
+    }
+    // grids are built again for the moved edges, at once on the next Add
+    kept_edges.clear();
+    num_indexed = 0;
+}
+
+void StreamingSimplifier::IndexKept() {
+    size_t num_kept = points.size() >= 2 ? points.size() - 2 : 0;
+    if (num_indexed == num_kept) {
+        return;
+    }
+
+    // new edges and the smaller grids at the end go into one grid, which reuses the memory of the last merged one
+    KeptEdges edges;
+    edges.first = num_indexed;
+    edges.count = num_kept - num_indexed;
+    while (!kept_edges.empty() && kept_edges.back().count <= 2 * edges.count) {
+        edges.first = kept_edges.back().first;
+        edges.count += kept_edges.back().count;
+        edges.grid = std::move(kept_edges.back().grid);
+        kept_edges.pop_back();
+    }
+    std::span<const Point> kept(points);
+    edges.grid.Build(kept.subspan(edges.first, edges.count), kept.subspan(edges.first + 1, edges.count));
+    kept_edges.push_back(std::move(edges));
+    num_indexed = num_kept;
+}
+
+bool StreamingSimplifier::CrossesKept(Point a, Point b) const {
+    // points end with the start of the run and the previous point, edges before the run end at points.size() - 2,
+    // all of them are indexed, only those in the cells along a -> b are tested
+    for (const KeptEdges &edges : kept_edges) {
+        bool crosses = false;
+        edges.grid.ForEachCellOnSegment(a, b, [&](size_t cell) {
+            for (uint32_t i : edges.grid.Cell(cell)) {
+                size_t edge = edges.first + i;
+                crosses = crosses || SegmentsCross(points[edge], points[edge + 1], a, b);
+            }
+        });
+        if (crosses) {
+            return true;
+        }
+    }
+    return false;
+}
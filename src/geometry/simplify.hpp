@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstddef>
+
+#include "geometry.hpp"
+#include "segment_grid.hpp"
+
+enum class SimplifyMethod {
+    DouglasPeucker,    // removed vertexes are within tolerance of the simplified polyline
+    VisvalingamWhyatt, // vertexes are removed while the triangle with their neighbours is smaller than tolerance^2
+};
+
+// polylines longer than this are split into chunks that are simplified in parallel
+// ends of the chunks are kept, so the result differs from the sequential one only around them
+static constexpr size_t SIMPLIFY_PARALLEL_THRESHOLD = 1 << 16;
+
+// indexes of the vertexes that are kept, sorted; the first vertex is always kept, and the last one of open polylines
+// closed polygons keep at least 3 vertexes
+// simplified edges that cross another edge are refined until they don't, so no new self-intersections appear
+std::vector<uint32_t> Simplify(std::span<const Point> points, float tolerance, SimplifyMethod method, bool closed=true);
+
+void SimplifyPolygon(Polygon &polygon, float tolerance, SimplifyMethod method);
+
+// simplifies a polyline while points are appended to it, e.g. while it is drawn with the mouse
+// points since the last surely kept vertex are the run, every new point is checked only against the run:
+// if the run still fits the segment from its start to the new point, the previous point is dropped
+// a dropped point never comes back, so the polyline before the run never changes
+struct StreamingSimplifier {
+    // the run is cut when it gets this long, it bounds the work per point
+    static constexpr size_t MAX_RUN = 256;
+
+    float tolerance = 1.f;
+
+    // simplified polyline, the last point is the last appended one
+    std::vector<Point> points;
+
+    void Begin(float tolerance);
+    void Add(Point point);
+    // last point is kept even if the next ones go on in the same direction (e.g. a vertex that was clicked)
+    void KeepLast();
+    void Shift(Point shift);
+
+private:
+    std::vector<Point> run; // run.front() is the last surely kept vertex, run.back() is points.back()
+
+    // edges before the run never change, they are indexed in grids over consecutive edges [first, first + count),
+    // each grid more than twice as big as the next one, so an edge is indexed O(log n) times and a query
+    // looks into O(log n) grids
+    struct KeptEdges {
+        size_t first = 0;
+        size_t count = 0;
+        SegmentGrid grid;
+    };
+    std::vector<KeptEdges> kept_edges;
+    size_t num_indexed = 0;
+
+    // indexes the edges that have been kept since the last call
+    void IndexKept();
+    // segment from the start of the run to its end doesn't cross edges before the run
+    bool CrossesKept(Point a, Point b) const;
+};
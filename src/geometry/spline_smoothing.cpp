@@ -0,0 +1,161 @@
+#include "spline_smoothing.hpp"
+
+#include <vector>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+struct Vector2d {
+    double x = 0;
+    double y = 0;
+
+    Vector2d operator-(const Vector2d &other) const {
+        return { x - other.x, y - other.y };
+    }
+    Vector2d operator*(double k) const {
+        return { x * k, y * k };
+    }
+    Vector2d operator/(double k) const {
+        return { x / k, y / k };
+    }
+};
+
+// symmetric tridiagonal system by the Thomas algorithm, rhs becomes the solution, diagonal is overwritten
+// upper[i] is the element at (i, i + 1), the matrix must be positive definite, so no pivoting is needed
+template <typename T>
+void SolveTridiagonal(std::span<double> diagonal, std::span<const double> upper, std::span<T> rhs) {
+    size_t n = diagonal.size();
+    if (n == 0) {
+        return;
+    }
+
+    for (size_t i = 1; i < n; ++i) {
+        double m = upper[i - 1] / diagonal[i - 1];
+        diagonal[i] -= m * upper[i - 1];
+        rhs[i]       = rhs[i] - rhs[i - 1] * m;
+    }
+
+    rhs[n - 1] = rhs[n - 1] / diagonal[n - 1];
+    for (size_t i = n - 1; i-- > 0;) {
+        rhs[i] = (rhs[i] - rhs[i + 1] * upper[i]) / diagonal[i];
+    }
+}
+
+double Dot(Vector2 a, Vector2 b) {
+    return (double) a.x * b.x + (double) a.y * b.y;
+}
+
+// every joint is a constraint A (x + d) = 0 on the points around it, the smallest move is d = A^T lambda,
+// where (A A^T) lambda = -A x; only neighbour joints share a point (and only for quadratic curves),
+// so A A^T is tridiagonal
+
+// left + right - 2 * joint = 0, x and y have the same matrix, so they are solved together
+void SmoothC1(std::span<Point> points, size_t order, size_t njoints, bool interpolate) {
+    std::vector<double> diagonal(njoints, (interpolate ? 2.0 : 6.0) + SplineSmoothing::REGULARIZATION);
+    std::vector<double> upper(njoints, order == 2 ? 1.0 : 0.0);
+    std::vector<Vector2d> lambda(njoints);
+
+    for (size_t k = 0; k < njoints; ++k) {
+        size_t joint = (k + 1) * order;
+        Point l = points[joint - 1];
+        Point j = points[joint];
+        Point r = points[joint + 1];
+
+        lambda[k] = { -((double) l.x + r.x - 2.0 * j.x), -((double) l.y + r.y - 2.0 * j.y) };
+    }
+
+    SolveTridiagonal<Vector2d>(diagonal, upper, lambda);
+
+    for (size_t k = 0; k < njoints; ++k) {
+        size_t joint = (k + 1) * order;
+        Point d = { (float) lambda[k].x, (float) lambda[k].y };
+
+        points[joint - 1] += d;
+        points[joint + 1] += d;
+        if (!interpolate) {
+            points[joint] -= d * 2.f;
+        }
+    }
+}
+
+// G1 is not linear, so the direction of the tangent at every joint is chosen first,
+// then both control points are moved onto the line through the joint: n . (left - joint) = 0 and n . (right - joint) = 0
+// constraints go in pairs: 2k for the left point of joint k and 2k + 1 for the right one
+void SmoothG1(std::span<Point> points, size_t order, size_t njoints, bool interpolate) {
+    std::vector<Vector2> normals(njoints);
+    for (size_t k = 0; k < njoints; ++k) {
+        size_t joint = (k + 1) * order;
+        Point l = points[joint - 1];
+        Point r = points[joint + 1];
+
+        // control points may only slide along the lines, so through fixed joints the tangents are taken
+        // from the neighbour joints (as in Catmull-Rom), otherwise noise in them would throw the points far away
+        // free joints keep the direction of their own control points
+        Point tangent = interpolate ? points[joint + order] - points[joint - order] : r - l;
+        if (Vector2LengthSqr(tangent) == 0) {
+            tangent = r - l;
+        }
+        if (Vector2LengthSqr(tangent) == 0) {
+            tangent = points[joint] - l;
+        }
+        // if all three points are the same, zero normal gives zero constraints, it's already smooth
+        tangent = Vector2Normalize(tangent);
+        normals[k] = { -tangent.y, tangent.x };
+    }
+
+    size_t n = 2 * njoints;
+    std::vector<double> diagonal(n);
+    std::vector<double> upper(n, 0.0);
+    std::vector<double> lambda(n);
+
+    for (size_t k = 0; k < njoints; ++k) {
+        size_t joint = (k + 1) * order;
+        Vector2 normal = normals[k];
+        double nn = Dot(normal, normal);
+
+        diagonal[2 * k]     = (interpolate ? nn : 2 * nn) + SplineSmoothing::REGULARIZATION;
+        diagonal[2 * k + 1] = diagonal[2 * k];
+
+        // both constraints of a joint share it, right point of a quadratic curve is the left one of the next joint
+        upper[2 * k] = interpolate ? 0.0 : nn;
+        if (order == 2 && k + 1 < njoints) {
+            upper[2 * k + 1] = Dot(normal, normals[k + 1]);
+        }
+
+        lambda[2 * k]     = -Dot(normal, points[joint - 1] - points[joint]);
+        lambda[2 * k + 1] = -Dot(normal, points[joint + 1] - points[joint]);
+    }
+
+    SolveTridiagonal<double>(diagonal, upper, lambda);
+
+    for (size_t k = 0; k < njoints; ++k) {
+        size_t joint = (k + 1) * order;
+        Vector2 normal = normals[k];
+
+        points[joint - 1] += normal * (float) lambda[2 * k];
+        points[joint + 1] += normal * (float) lambda[2 * k + 1];
+        if (!interpolate) {
+            points[joint] -= normal * (float) (lambda[2 * k] + lambda[2 * k + 1]);
+        }
+    }
+}
+
+} // namespace
+
+void SmoothSpline(std::span<Point> control_points, size_t order, const SplineSmoothing &smoothing) {
+    // joints of linear curves have no control points of their own
+    assert(order >= 2);
+
+    size_t size = control_points.size();
+    size_t ncurves = size > order ? (size - 1) / order : 0;
+    if (ncurves < 2) {
+        return;
+    }
+
+    if (smoothing.continuity == SplineContinuity::C1) {
+        SmoothC1(control_points, order, ncurves - 1, smoothing.interpolate);
+    } else {
+        SmoothG1(control_points, order, ncurves - 1, smoothing.interpolate);
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <span>
+#include <cstddef>
+
+#include "geometry.hpp"
+
+// continuity at the joints, where neighbour curves of a spline meet
+enum class SplineContinuity {
+    C1, // control points around a joint are symmetric, so the tangent is the same on both sides
+    G1, // control points around a joint are on one line with it, only the direction is the same
+};
+
+struct SplineSmoothing {
+    SplineContinuity continuity = SplineContinuity::G1;
+    bool interpolate = false; // joints stay in place, so the spline still goes through them
+
+    // added to the diagonal, keeps the system solvable when constraints contradict each other
+    // (e.g. G1 through fixed joints with parallel tangents at both ends of a quadratic curve)
+    static constexpr double REGULARIZATION = 1e-6;
+};
+
+// control points of consecutive bezier curves of the same order that share end points, like in SceneBezier::BezierSet:
+// curve i uses points [i * order, i * order + order], trailing points that make no curve are left alone
+// points are moved as little as possible (least squares) so that every joint gets the continuity,
+// only neighbour joints share points, so it is one tridiagonal system solved in O(n)
+void SmoothSpline(std::span<Point> control_points, size_t order, const SplineSmoothing &smoothing);
@@ -0,0 +1,143 @@
+#include "trajectory.hpp"
+
+#include "polygon_animation.hpp"
+
+#include <algorithm>
+#include <numbers>
+#include <cmath>
+
+void ArcLengthTable::Build(std::span<const Point> samples) {
+    lengths.resize(samples.size());
+    if (samples.empty()) {
+        return;
+    }
+
+    lengths[0] = 0;
+    for (size_t i = 1; i < samples.size(); ++i) {
+        lengths[i] = lengths[i - 1] + Distance(samples[i - 1], samples[i]);
+    }
+}
+
+float ArcLengthTable::SampleAt(float s) const {
+    if (lengths.size() < 2) {
+        return 0;
+    }
+
+    s = Clamp(s, 0, lengths.back());
+
+    // first sample that is further than s, the point is between it and the previous one
+    size_t i = (size_t) (std::upper_bound(lengths.begin() + 1, lengths.end() - 1, s) - lengths.begin());
+    float segment = lengths[i] - lengths[i - 1];
+    float t = segment > 0 ? (s - lengths[i - 1]) / segment : 0.f;
+
+    return (float) (i - 1) + t;
+}
+
+EllipseTrajectory::EllipseTrajectory(Point center, float a, float b, const PolygonAnimation *frame) :
+    center(center), a(a), b(b), frame(frame)
+{
+    if (a == b) {
+        return;
+    }
+
+    static constexpr float two_pi = 2 * std::numbers::pi_v<float>;
+
+    std::vector<Point> samples(TABLE_SAMPLES + 1);
+    for (int i = 0; i <= TABLE_SAMPLES; ++i) {
+        float angle = two_pi * (float) i / TABLE_SAMPLES;
+        samples[i] = { a * std::cos(angle), -b * std::sin(angle) };
+    }
+    table.Build(samples);
+}
+
+float EllipseTrajectory::Length() const {
+    if (a == b) {
+        return 2 * std::numbers::pi_v<float> * a;
+    }
+    return table.Total();
+}
+
+Point EllipseTrajectory::PointAt(float distance) const {
+    static constexpr float two_pi = 2 * std::numbers::pi_v<float>;
+
+    float angle = 0;
+    if (a == b) {
+        angle = a > 0 ? distance / a : 0.f;
+    } else {
+        // samples are uniform in angle, so the fractional sample is the angle itself
+        angle = table.SampleAt(distance) * two_pi / TABLE_SAMPLES;
+    }
+
+    Point p = center + Point { a * std::cos(angle), -b * std::sin(angle) };
+
+    if (frame) {
+        return frame->GetCenter() + RotatePoint(p, frame->angle);
+    }
+    return p;
+}
+
+SplineTrajectory::SplineTrajectory(const std::pmr::deque<BezierCurve> &curves) {
+    samples.reserve(curves.size() * SAMPLES_PER_CURVE + 1);
+
+    for (const auto &curve : curves) {
+        if (curve.control_points.size() < 2) {
+            continue;
+        }
+
+        // end point of a curve is the start of the next one, so it is added only once
+        int first = samples.empty() ? 0 : 1;
+        auto sample = [&](auto bezier) {
+            for (int i = first; i <= SAMPLES_PER_CURVE; ++i) {
+                samples.push_back(bezier((float) i / SAMPLES_PER_CURVE));
+            }
+        };
+
+        if (!VisitBezier(curve.control_points, sample)) {
+            auto func = BezierFunc(curve.control_points);
+            for (int i = first; i <= SAMPLES_PER_CURVE; ++i) {
+                samples.push_back(func((float) i / SAMPLES_PER_CURVE));
+            }
+        }
+    }
+
+    table.Build(samples);
+}
+
+Point SplineTrajectory::PointAt(float distance) const {
+    if (samples.empty()) {
+        return Vector2Zeros;
+    }
+
+    float sample = table.SampleAt(distance);
+    size_t i = std::min((size_t) sample, samples.size() - 1);
+    if (i + 1 == samples.size()) {
+        return samples.back();
+    }
+    return Lerp(samples[i], samples[i + 1], sample - (float) i);
+}
+
+float Trajectory::Length() const {
+    return std::visit([](const auto &trajectory) -> float {
+        using T = std::decay_t<decltype(trajectory)>;
+        if constexpr (std::is_same_v<T, AnimationPtr>) {
+            return trajectory ? trajectory->Perimeter() : 0.f;
+        } else if constexpr (std::is_same_v<T, Point>) {
+            return 0.f;
+        } else {
+            return trajectory.Length();
+        }
+    }, trajectory);
+}
+
+Point Trajectory::PointAt(float distance) const {
+    return std::visit([distance](const auto &trajectory) -> Point {
+        using T = std::decay_t<decltype(trajectory)>;
+        if constexpr (std::is_same_v<T, AnimationPtr>) {
+            return trajectory ? trajectory->PointAtDistance(distance) : Vector2Zeros;
+        } else if constexpr (std::is_same_v<T, Point>) {
+            return trajectory;
+        } else {
+            return trajectory.PointAt(distance);
+        }
+    }, trajectory);
+}
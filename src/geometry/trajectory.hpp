@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <variant>
+#include <span>
+#include <memory_resource>
+
+#include "geometry.hpp"
+#include "bezier.hpp"
+
+struct PolygonAnimation;
+
+// cumulative length of a polyline, maps distance along it back to the position of the sample
+// curves are sampled densely once, then walked at constant speed with a binary search
+struct ArcLengthTable {
+    std::vector<float> lengths; // lengths[i] is the length of the polyline up to sample i
+
+    void Build(std::span<const Point> samples);
+
+    float Total() const {
+        return lengths.empty() ? 0.f : lengths.back();
+    }
+    // fractional index of the sample at distance s, s is clamped to [0, Total()]
+    float SampleAt(float s) const;
+};
+
+// ellipse with semi-axes a along x and b along y, same as Polygon::Ellipse():
+// it starts at (a, 0) from the center and goes counterclockwise on the screen
+// when frame is set, the center is relative to the frame animation and the ellipse turns with it
+struct EllipseTrajectory {
+    static constexpr int TABLE_SAMPLES = 1024;
+
+    Point center = Vector2Zeros;
+    float a = 0.f;
+    float b = 0.f;
+    const PolygonAnimation *frame = nullptr;
+
+    EllipseTrajectory(Point center, float a, float b, const PolygonAnimation *frame=nullptr);
+
+    // circles have a closed form, ellipses go through the table
+    float Length() const;
+    Point PointAt(float distance) const;
+
+private:
+    ArcLengthTable table; // over angles [0, 2pi], empty for circles
+};
+
+// chain of bezier curves that share end points (like a set of SceneBezier), it is walked from start to end
+// curves are copied into samples, so the trajectory must be rebuilt when they change
+struct SplineTrajectory {
+    static constexpr int SAMPLES_PER_CURVE = 32;
+
+    SplineTrajectory() = default;
+    explicit SplineTrajectory(const std::pmr::deque<BezierCurve> &curves);
+
+    float Length() const {
+        return table.Total();
+    }
+    Point PointAt(float distance) const;
+
+private:
+    std::vector<Point> samples;
+    ArcLengthTable table;
+};
+
+// simple wrapper around std::variant for convinience
+// Trajectory can be reference to another animated polygon, single point, ellipse or spline
+struct Trajectory {
+    using AnimationPtr = const PolygonAnimation *;
+
+    std::variant<AnimationPtr, Point, EllipseTrajectory, SplineTrajectory> trajectory;
+
+    Trajectory() = default;
+    Trajectory(AnimationPtr animation) : trajectory(animation) {}
+    Trajectory(Point point) : trajectory(point) {}
+    Trajectory(EllipseTrajectory ellipse) : trajectory(std::move(ellipse)) {}
+    Trajectory(SplineTrajectory spline) : trajectory(std::move(spline)) {}
+
+    bool IsAnimation() const {
+        return std::holds_alternative<AnimationPtr>(trajectory);
+    }
+    bool IsPoint() const {
+        return std::holds_alternative<Point>(trajectory);
+    }
+
+    AnimationPtr GetAnimation() const {
+        return std::get<AnimationPtr>(trajectory);
+    }
+    Point& GetPoint() {
+        return std::get<Point>(trajectory);
+    }
+    Point GetPoint() const {
+        return std::get<Point>(trajectory);
+    }
+
+    // 0 for a point, polygons are walked along their perimeter
+    float Length() const;
+    Point PointAt(float distance) const;
+};
@@ -0,0 +1,59 @@
+#include "transform.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define TRANSFORM_SSE2
+#endif
+
+Matrix MatrixAround(Point pivot, float angle, float scale, Point translation) {
+    float c = std::cos(angle) * scale;
+    float s = std::sin(angle) * scale;
+
+    // p' = R * (p - pivot) + pivot + translation, same layout as MatrixRotateZ()
+    Matrix m = MatrixIdentity();
+    m.m0 = c;  m.m4 = -s;
+    m.m1 = s;  m.m5 = c;
+    m.m12 = pivot.x + translation.x - (c * pivot.x - s * pivot.y);
+    m.m13 = pivot.y + translation.y - (s * pivot.x + c * pivot.y);
+    return m;
+}
+
+void TransformPoints(const Matrix &m, std::span<const Point> src, std::span<Point> dst) {
+    assert(src.size() == dst.size());
+
+    size_t n = src.size();
+    size_t i = 0;
+
+#ifdef TRANSFORM_SSE2
+    static_assert(sizeof(Point) == 2 * sizeof(float));
+
+    // two points in a register: [x0 y0 x1 y1] * [m0 m5 m0 m5] + [y0 x0 y1 x1] * [m4 m1 m4 m1] + [m12 m13 m12 m13]
+    const __m128 diagonal     = _mm_setr_ps(m.m0, m.m5, m.m0, m.m5);
+    const __m128 antidiagonal = _mm_setr_ps(m.m4, m.m1, m.m4, m.m1);
+    const __m128 translation  = _mm_setr_ps(m.m12, m.m13, m.m12, m.m13);
+
+    const float *in = (const float *) src.data();
+    float *out      = (float *) dst.data();
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 a = _mm_loadu_ps(in + 2 * i);
+        __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+
+        __m128 a_swapped = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 b_swapped = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+
+        a = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, diagonal), _mm_mul_ps(a_swapped, antidiagonal)), translation);
+        b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, diagonal), _mm_mul_ps(b_swapped, antidiagonal)), translation);
+
+        _mm_storeu_ps(out + 2 * i, a);
+        _mm_storeu_ps(out + 2 * i + 4, b);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        dst[i] = Vector2Transform(src[i], m);
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <raylib.h>
+#include <raymath.h>
+
+#include <span>
+
+#include "geometry.hpp"
+
+// affine transforms of point groups are raymath matrices, only their 2d part (m0 m4 m12, m1 m5 m13) is used
+
+// rotate by angle (radians) and scale around pivot, then translate
+Matrix MatrixAround(Point pivot, float angle, float scale, Point translation=Vector2Zeros);
+
+// dst[i] = m * src[i], src and dst may be the same span
+// 4 points per iteration with SSE2, so a group of 10^5 points takes a fraction of a millisecond
+void TransformPoints(const Matrix &m, std::span<const Point> src, std::span<Point> dst);
+
+inline void TransformPoints(const Matrix &m, std::span<Point> points) {
+    TransformPoints(m, points, points);
+}
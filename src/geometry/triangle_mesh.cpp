@@ -0,0 +1,95 @@
+#include "triangle_mesh.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <cassert>
+
+#include "memory/allocation_counter.hpp"
+
+void TriangleMesh::Build() {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    for (Triangle &t : triangles) {
+        double cross = Orientation(vertexes[t[0]], vertexes[t[1]], vertexes[t[2]]);
+        assert(cross != 0 && "degenerate triangle");
+        if (cross < 0) {
+            std::swap(t[1], t[2]);
+        }
+    }
+
+    // edges are sorted by their vertexes, so the two sides of an edge become neighbours in the array
+    struct Edge {
+        uint64_t key;
+        uint32_t triangle;
+        uint32_t side;
+    };
+    std::vector<Edge> edges;
+    edges.reserve(triangles.size() * 3);
+    for (uint32_t t = 0; t < (uint32_t) triangles.size(); ++t) {
+        for (uint32_t i = 0; i < 3; ++i) {
+            uint32_t u = triangles[t][i];
+            uint32_t v = triangles[t][(i + 1) % 3];
+            edges.push_back(Edge { (uint64_t) std::min(u, v) << 32 | std::max(u, v), t, i });
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+        return a.key < b.key;
+    });
+
+    neighbours.assign(triangles.size(), Triangle { NONE, NONE, NONE });
+    for (size_t i = 0; i + 1 < edges.size(); ++i) {
+        if (edges[i].key == edges[i + 1].key) {
+            neighbours[edges[i].triangle][edges[i].side] = edges[i + 1].triangle;
+            neighbours[edges[i + 1].triangle][edges[i + 1].side] = edges[i].triangle;
+            ++i;
+        }
+    }
+}
+
+size_t TriangleMesh::MemoryUsage() const {
+    return vertexes.capacity() * sizeof(Point) + (triangles.capacity() + neighbours.capacity()) * sizeof(Triangle);
+}
+
+TriangleMesh GenerateGridMesh(Rectangle area, int nx, int ny, float jitter) {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+    assert(nx > 0 && ny > 0);
+
+    TriangleMesh mesh;
+    float cell_w = area.width / (float) nx;
+    float cell_h = area.height / (float) ny;
+    int max_offset = (int) (jitter * 1000);
+
+    mesh.vertexes.reserve((size_t) (nx + 1) * (ny + 1));
+    for (int y = 0; y <= ny; ++y) {
+        for (int x = 0; x <= nx; ++x) {
+            Point p { area.x + (float) x * cell_w, area.y + (float) y * cell_h };
+            if (x > 0 && x < nx) {
+                p.x += (float) GetRandomValue(-max_offset, max_offset) / 1000.f * cell_w;
+            }
+            if (y > 0 && y < ny) {
+                p.y += (float) GetRandomValue(-max_offset, max_offset) / 1000.f * cell_h;
+            }
+            mesh.vertexes.push_back(p);
+        }
+    }
+
+    mesh.triangles.reserve((size_t) nx * ny * 2);
+    for (int y = 0; y < ny; ++y) {
+        for (int x = 0; x < nx; ++x) {
+            uint32_t v00 = (uint32_t) (y * (nx + 1) + x);
+            uint32_t v10 = v00 + 1;
+            uint32_t v01 = v00 + (uint32_t) (nx + 1);
+            uint32_t v11 = v01 + 1;
+            if (GetRandomValue(0, 1)) {
+                mesh.triangles.push_back({ v00, v10, v11 });
+                mesh.triangles.push_back({ v00, v11, v01 });
+            } else {
+                mesh.triangles.push_back({ v00, v10, v01 });
+                mesh.triangles.push_back({ v10, v11, v01 });
+            }
+        }
+    }
+
+    mesh.Build();
+    return mesh;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include "geometry.hpp"
+
+// triangles sharing vertexes, with links to the triangles across every edge
+struct TriangleMesh {
+    static constexpr uint32_t NONE = UINT32_MAX;
+    using Triangle = std::array<uint32_t, 3>;
+
+    std::vector<Point> vertexes;
+    // every triangle is turned so that cross(b - a, c - a) > 0, it is counter-clockwise in math coordinates
+    std::vector<Triangle> triangles;
+    // neighbours[t][i] is across the edge from vertex i to vertex i + 1 of triangle t, NONE on the boundary
+    std::vector<Triangle> neighbours;
+
+    // orients triangles and finds their neighbours, called after vertexes and triangles are filled
+    void Build();
+
+    size_t MemoryUsage() const;
+};
+
+// nx * ny cells of the area, each split into 2 triangles by a random diagonal
+// inner vertexes are moved randomly by up to jitter of a cell (jitter < 0.25 keeps the cells convex, so both diagonals are valid),
+// the border stays the same, so the mesh covers the whole convex area
+TriangleMesh GenerateGridMesh(Rectangle area, int nx, int ny, float jitter=0.2f);
@@ -4,6 +4,8 @@
 
 #include "colors.h"
 #include "gui.hpp"
+#include "memory/allocation_counter.hpp"
+#include "render/render.hpp"
 
 namespace GUI {
 
@@ -53,6 +55,13 @@ void InputBox::UpdateTextBuffer() {
     }
 }
 
+double InputBox::GetValue() const {
+    if (std::holds_alternative<Value<int>>(value)) {
+        return *std::get<Value<int>>(value).ptr;
+    }
+    return *std::get<Value<float>>(value).ptr;
+}
+
 void InputBox::Reset() {
     text_buffer[0] = '0';
     std::fill(text_buffer + 1, text_buffer + RAYGUI_VALUEBOX_MAX_CHARS + 1, '\0');
@@ -97,6 +106,8 @@ void InputBox::Draw() {
 }
 
 void InputBoxPanel::Add(float *value, std::string text) {
+    ScopedMemoryTag memory_tag(MemoryTag::GUI);
+
     size_t nboxes = input_boxes.size();
     Rectangle input_box = { panel.x + panel.width / 2,
                             DEFAULT_MARGIN + panel.y + nboxes * (DEFAULT_BOX_HEIGHT + DEFAULT_BOX_PADDING),
@@ -106,6 +117,8 @@ void InputBoxPanel::Add(float *value, std::string text) {
 }
 
 void InputBoxPanel::Add(int *value, int min, int max, std::string text) {
+    ScopedMemoryTag memory_tag(MemoryTag::GUI);
+
     size_t nboxes = input_boxes.size();
     Rectangle input_box = { panel.x + panel.width / 2,
                             DEFAULT_MARGIN + panel.y + nboxes * (DEFAULT_BOX_HEIGHT + DEFAULT_BOX_PADDING),
@@ -115,13 +128,42 @@ void InputBoxPanel::Add(int *value, int min, int max, std::string text) {
 }
 
 void InputBoxPanel::Draw() {
-    // fill with background color to hide scene behind
-    DrawRectangleRec(panel, COLOR_BACKGROUND);
-    GuiGroupBox(panel, "Parameters");
+    // gui is only drawn to the window
+    if (Render::IsSoftware()) {
+        return;
+    }
 
-    for (auto &input_box : input_boxes) {
-        input_box.Draw();
+    ScopedMemoryTag memory_tag(MemoryTag::GUI);
+
+    if (IsInteractive()) {
+        // hover and edit states change every frame, nothing to cache
+        layer.Invalidate();
+
+        // fill with background color to hide scene behind
+        DrawRectangleRec(panel, COLOR_BACKGROUND);
+        DrawBoxes();
+    } else {
+        if (ValuesChanged()) {
+            layer.Invalidate();
+        }
+
+        if (layer.Begin((int) panel.width, (int) panel.height, COLOR_BACKGROUND)) {
+            Camera2D camera {};
+            camera.offset = { -panel.x, -panel.y };
+            camera.zoom   = 1;
+
+            BeginMode2D(camera);
+            DrawBoxes();
+            EndMode2D();
+
+            layer.End();
+            CacheValues();
+        }
+        layer.Draw({ panel.x, panel.y });
     }
+
+    // group box title sticks out of the panel, so it is not cached
+    GuiGroupBox(panel, "Parameters");
 }
 
 void InputBoxPanel::Reset() {
@@ -130,11 +172,49 @@ void InputBoxPanel::Reset() {
     }
 }
 
+void InputBoxPanel::DrawBoxes() {
+    for (auto &input_box : input_boxes) {
+        input_box.Draw();
+    }
+}
+
+bool InputBoxPanel::IsInteractive() const {
+    if (CheckCollisionPointRec(GetMousePosition(), panel)) {
+        return true;
+    }
+
+    return std::any_of(input_boxes.begin(), input_boxes.end(),
+                       [](const InputBox &input_box) { return input_box.editmode; });
+}
+
+bool InputBoxPanel::ValuesChanged() const {
+    if (cached_values.size() != input_boxes.size()) {
+        return true;
+    }
+
+    for (size_t i = 0; i < input_boxes.size(); ++i) {
+        if (input_boxes[i].GetValue() != cached_values[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void InputBoxPanel::CacheValues() {
+    cached_values.resize(input_boxes.size());
+    for (size_t i = 0; i < input_boxes.size(); ++i) {
+        cached_values[i] = input_boxes[i].GetValue();
+    }
+}
+
 Toggle::Toggle(Rectangle box, std::string text_inactive, std::string text_active) :
     box(box), text_inactive(std::move(text_inactive)), text_active(std::move(text_active))
 {}
 
 void Toggle::Draw() {
+    if (Render::IsSoftware()) {
+        return;
+    }
     GuiToggle(box, active ? text_active.c_str() : text_inactive.c_str(), &active);
 }
 
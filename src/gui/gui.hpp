@@ -10,6 +10,8 @@
 #include <limits>
 #include <functional>
 
+#include "render/cached_layer.hpp"
+
 namespace GUI {
 
 struct InputBox {
@@ -45,6 +47,7 @@ struct InputBox {
     InputBox(Rectangle box, float *value, std::string text);
 
     void UpdateTextBuffer();
+    double GetValue() const;
     void Reset();
     void Draw();
 };
@@ -53,6 +56,10 @@ struct InputBoxPanel {
     Rectangle panel;
     std::vector<GUI::InputBox> input_boxes;
 
+    // panel is drawn from the layer while nobody interacts with it
+    CachedLayer layer { "input box panel" };
+    std::vector<double> cached_values; // values shown in the layer, to notice changes made from outside
+
     static const int DEFAULT_BOX_WIDTH   = 80;
     static const int DEFAULT_BOX_HEIGHT  = 30;
     static const int DEFAULT_BOX_PADDING = 10;
@@ -66,6 +73,12 @@ struct InputBoxPanel {
 
     void Draw();
     void Reset();
+
+private:
+    void DrawBoxes();
+    bool IsInteractive() const;
+    bool ValuesChanged() const;
+    void CacheValues();
 };
 
 struct Toggle {
@@ -0,0 +1,105 @@
+#include "undo_history.hpp"
+
+#include <raylib.h>
+
+void UndoHistory::MarkDirty(size_t sequence_idx, size_t point_idx) {
+    if (dirty_chunks.size() <= sequence_idx) {
+        dirty_chunks.resize(sequence_idx + 1);
+    }
+
+    auto &chunks = dirty_chunks[sequence_idx];
+    size_t chunk_idx = point_idx / CHUNK_SIZE;
+
+    // drag marks the same point every frame
+    if (std::find(chunks.begin(), chunks.end(), chunk_idx) == chunks.end()) {
+        chunks.push_back(chunk_idx);
+    }
+}
+
+void UndoHistory::MarkDirty(size_t sequence_idx) {
+    if (dirty_sequences.size() <= sequence_idx) {
+        dirty_sequences.resize(sequence_idx + 1, false);
+    }
+    dirty_sequences[sequence_idx] = true;
+}
+
+bool UndoHistory::Undo() {
+    if (!CanUndo()) {
+        return false;
+    }
+
+    --current;
+    return true;
+}
+
+bool UndoHistory::Redo() {
+    if (!CanRedo()) {
+        return false;
+    }
+
+    ++current;
+    return true;
+}
+
+void UndoHistory::Clear() {
+    snapshots.clear();
+    current = 0;
+    bytes_total = 0;
+
+    dirty_chunks.clear();
+    dirty_sequences.clear();
+}
+
+bool UndoHistory::IsDirty(size_t sequence_idx) const {
+    return sequence_idx < dirty_chunks.size() && !dirty_chunks[sequence_idx].empty();
+}
+
+size_t UndoHistory::SequenceBytes(const Sequence &sequence) {
+    return sizeof(Sequence) + sequence.chunks.capacity() * sizeof(std::shared_ptr<const Chunk>);
+}
+
+size_t UndoHistory::ChunkBytes(const Chunk &chunk) {
+    return sizeof(Chunk) + chunk.capacity() * sizeof(Point);
+}
+
+size_t UndoHistory::SnapshotBytes(const Snapshot &snapshot) {
+    size_t bytes = snapshot.sequences.capacity() * sizeof(std::shared_ptr<const Sequence>);
+    for (const auto &sequence : snapshot.sequences) {
+        bytes += SequenceBytes(*sequence);
+        for (const auto &chunk : sequence->chunks) {
+            bytes += ChunkBytes(*chunk);
+        }
+    }
+    return bytes;
+}
+
+void UndoHistory::PushSnapshot(Snapshot snapshot) {
+    // new step makes the undone ones unreachable
+    if (!snapshots.empty()) {
+        while (snapshots.size() > current + 1) {
+            bytes_total -= snapshots.back().bytes;
+            snapshots.pop_back();
+        }
+    }
+
+    bytes_total += snapshot.bytes;
+    snapshots.push_back(std::move(snapshot));
+    current = snapshots.size() - 1;
+
+    // memory of a step is what it doesn't share with the previous one,
+    // so when the oldest step is dropped the next one owns everything it references
+    while (snapshots.size() > 1 && bytes_total > memory_budget) {
+        bytes_total -= snapshots.front().bytes;
+        snapshots.pop_front();
+        --current;
+
+        Snapshot &front = snapshots.front();
+        bytes_total -= front.bytes;
+        front.bytes = SnapshotBytes(front);
+        bytes_total += front.bytes;
+    }
+
+    if (bytes_total > memory_budget) {
+        TraceLog(LOG_WARNING, "UndoHistory: single step takes %zu bytes, budget is %zu bytes", bytes_total, memory_budget);
+    }
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+#include "geometry/geometry.hpp"
+#include "memory/allocation_counter.hpp"
+
+// undo/redo history of a list of point sequences (bezier sets, polygons)
+// snapshots are persistent: points are kept in immutable chunks shared between snapshots,
+// so a step costs memory and time proportional to the chunks changed in it
+// oldest steps are dropped when history takes more than memory_budget
+struct UndoHistory {
+    static constexpr size_t CHUNK_SIZE = 1024;
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 64 << 20;
+
+    using Chunk = std::vector<Point>;
+
+    struct Sequence {
+        size_t size = 0;
+        std::vector<std::shared_ptr<const Chunk>> chunks;
+
+        template <std::output_iterator<Point> Iterator>
+        void CopyPoints(Iterator out) const {
+            for (const auto &chunk : chunks) {
+                out = std::copy(chunk->begin(), chunk->end(), out);
+            }
+        }
+    };
+
+    struct Snapshot {
+        std::vector<std::shared_ptr<const Sequence>> sequences;
+        uint32_t flags = 0; // state of the owner that is not points
+        size_t bytes   = 0; // memory of chunks and sequences that are not shared with the previous snapshot
+    };
+
+    size_t memory_budget = DEFAULT_MEMORY_BUDGET;
+
+    // edits of points that don't change sizes of sequences must be marked before Commit()
+    // changes of sizes are detected by Commit() itself
+    void MarkDirty(size_t sequence_idx, size_t point_idx);
+    void MarkDirty(size_t sequence_idx);
+
+    // store current state as a new step, steps that could be redone are dropped
+    // sequences is a range of anything, points_of(sequence) gives its random access range of points
+    template <typename Sequences, typename Projection>
+    void Commit(const Sequences &sequences, Projection points_of, uint32_t flags=0);
+
+    bool CanUndo() const {
+        return current > 0;
+    }
+    bool CanRedo() const {
+        return current + 1 < snapshots.size();
+    }
+
+    // move to the previous or next step, snapshots stay where they are, so references to them are still valid
+    bool Undo();
+    bool Redo();
+
+    const Snapshot &Current() const {
+        return snapshots[current];
+    }
+
+    // how to get from one snapshot to another:
+    // resized(sequence_idx, sequence) for sequences that appeared or changed their size,
+    // changed(sequence_idx, first_point, points) for changed chunks of other sequences
+    // sequences that are not in `to` are up to the caller to remove
+    template <typename Resized, typename Changed>
+    static void Diff(const Snapshot &from, const Snapshot &to, Resized resized, Changed changed);
+
+    size_t Steps() const {
+        return snapshots.size();
+    }
+    size_t MemoryUsage() const {
+        return bytes_total;
+    }
+
+    void Clear();
+
+private:
+    std::deque<Snapshot> snapshots;
+    size_t current = 0;
+    size_t bytes_total = 0;
+
+    std::vector<std::vector<size_t>> dirty_chunks; // [sequence_idx] -> chunk indexes
+    std::vector<bool> dirty_sequences;
+
+    bool IsDirty(size_t sequence_idx) const;
+
+    template <typename Points>
+    std::shared_ptr<const Sequence> CommitSequence(const std::shared_ptr<const Sequence> &old, size_t sequence_idx,
+                                                   const Points &points, size_t &bytes) const;
+
+    template <typename Points>
+    static std::shared_ptr<const Chunk> MakeChunk(const Points &points, size_t chunk_idx, size_t &bytes);
+
+    static size_t SequenceBytes(const Sequence &sequence);
+    static size_t ChunkBytes(const Chunk &chunk);
+    // memory of the whole snapshot as if it shared nothing
+    static size_t SnapshotBytes(const Snapshot &snapshot);
+
+    void PushSnapshot(Snapshot snapshot);
+};
+
+template <typename Sequences, typename Projection>
+void UndoHistory::Commit(const Sequences &sequences, Projection points_of, uint32_t flags) {
+    ScopedMemoryTag memory_tag(MemoryTag::History);
+
+    const Snapshot *previous = snapshots.empty() ? nullptr : &snapshots[current];
+
+    Snapshot snapshot;
+    snapshot.flags = flags;
+
+    size_t sequence_idx = 0;
+    for (const auto &sequence : sequences) {
+        std::shared_ptr<const Sequence> old;
+        if (previous && sequence_idx < previous->sequences.size()) {
+            old = previous->sequences[sequence_idx];
+        }
+
+        snapshot.sequences.push_back(CommitSequence(old, sequence_idx, points_of(sequence), snapshot.bytes));
+        ++sequence_idx;
+    }
+    snapshot.bytes += snapshot.sequences.capacity() * sizeof(std::shared_ptr<const Sequence>);
+
+    dirty_chunks.clear();
+    dirty_sequences.clear();
+
+    PushSnapshot(std::move(snapshot));
+}
+
+template <typename Points>
+std::shared_ptr<const UndoHistory::Sequence> UndoHistory::CommitSequence(const std::shared_ptr<const Sequence> &old, size_t sequence_idx,
+                                                                         const Points &points, size_t &bytes) const {
+    size_t size = (size_t) std::distance(std::begin(points), std::end(points));
+    bool whole = sequence_idx < dirty_sequences.size() && dirty_sequences[sequence_idx];
+
+    if (old && old->size == size && !whole) {
+        if (!IsDirty(sequence_idx)) {
+            return old;
+        }
+
+        // only marked chunks are copied, the rest is shared
+        auto sequence = std::make_shared<Sequence>(*old);
+        for (size_t chunk_idx : dirty_chunks[sequence_idx]) {
+            if (chunk_idx < sequence->chunks.size()) {
+                sequence->chunks[chunk_idx] = MakeChunk(points, chunk_idx, bytes);
+            }
+        }
+        bytes += SequenceBytes(*sequence);
+        return sequence;
+    }
+
+    // size has changed or everything is marked, chunks that are still equal are shared anyway
+    auto sequence = std::make_shared<Sequence>();
+    sequence->size = size;
+
+    size_t nchunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    sequence->chunks.reserve(nchunks);
+
+    for (size_t chunk_idx = 0; chunk_idx < nchunks; ++chunk_idx) {
+        size_t first = chunk_idx * CHUNK_SIZE;
+        size_t last  = std::min(first + CHUNK_SIZE, size);
+
+        if (old && chunk_idx < old->chunks.size()) {
+            const auto &old_chunk = old->chunks[chunk_idx];
+            if (old_chunk->size() == last - first &&
+                std::equal(old_chunk->begin(), old_chunk->end(), std::begin(points) + first,
+                           [](Point a, Point b) { return a.x == b.x && a.y == b.y; }))
+            {
+                sequence->chunks.push_back(old_chunk);
+                continue;
+            }
+        }
+
+        sequence->chunks.push_back(MakeChunk(points, chunk_idx, bytes));
+    }
+
+    bytes += SequenceBytes(*sequence);
+    return sequence;
+}
+
+template <typename Points>
+std::shared_ptr<const UndoHistory::Chunk> UndoHistory::MakeChunk(const Points &points, size_t chunk_idx, size_t &bytes) {
+    size_t size  = (size_t) std::distance(std::begin(points), std::end(points));
+    size_t first = chunk_idx * CHUNK_SIZE;
+    size_t last  = std::min(first + CHUNK_SIZE, size);
+
+    auto chunk = std::make_shared<Chunk>(std::begin(points) + first, std::begin(points) + last);
+    bytes += ChunkBytes(*chunk);
+    return chunk;
+}
+
+template <typename Resized, typename Changed>
+void UndoHistory::Diff(const Snapshot &from, const Snapshot &to, Resized resized, Changed changed) {
+    for (size_t sequence_idx = 0; sequence_idx < to.sequences.size(); ++sequence_idx) {
+        const auto &sequence = to.sequences[sequence_idx];
+
+        if (sequence_idx >= from.sequences.size() || from.sequences[sequence_idx]->size != sequence->size) {
+            resized(sequence_idx, *sequence);
+            continue;
+        }
+
+        const auto &old = from.sequences[sequence_idx];
+        if (old == sequence) {
+            continue;
+        }
+
+        for (size_t chunk_idx = 0; chunk_idx < sequence->chunks.size(); ++chunk_idx) {
+            const auto &chunk = sequence->chunks[chunk_idx];
+            if (chunk != old->chunks[chunk_idx]) {
+                changed(sequence_idx, chunk_idx * CHUNK_SIZE, std::span<const Point>(*chunk));
+            }
+        }
+    }
+}
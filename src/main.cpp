@@ -1,12 +1,28 @@
 
 #include <raylib.h>
 
+#include <chrono>
+
+#include "scenes/scene_registry.hpp"
 #include "scenes/scene_ellipses.hpp"
 #include "scenes/scene_draw_polygons.hpp"
 #include "scenes/scene_localization.hpp"
 #include "scenes/scene_bezier_elementary.hpp"
 #include "scenes/scene_bezier.hpp"
 
+#include "memory/frame_arena.hpp"
+#include "memory/allocation_counter.hpp"
+#include "memory/counting_resource.hpp"
+#include "memory/memory_report.hpp"
+#include "render/cached_layer.hpp"
+#include "render/render.hpp"
+#include "render/software_rasterizer.hpp"
+#include "parallel/async_tessellator.hpp"
+#include "profiling/frame_recorder.hpp"
+#include "profiling/cpu_usage.hpp"
+#include "platform/idle_waiter.hpp"
+#include "platform/pointer_input.hpp"
+
 #include "colors.h"
 
 #define WIDTH  1600
@@ -15,71 +31,198 @@
 #define TARGET_FPS (GetMonitorRefreshRate(GetCurrentMonitor()))
 
 void DrawThePlayground();
+void RegisterScenes(SceneRegistry &registry);
+bool RenderScene(Scene &scene, SoftwareRasterizer &rasterizer, const char *file_name);
+void CaptureScene(Scene &scene);
+int RenderHeadless(const SceneRegistry &registry, int key, const char *file_name);
+
+void DrawDebugOverlay(const FrameAllocations &frame_allocations, const FrameRecorder &frame_recorder,
+                      const CpuUsageMeter &cpu_usage, const IdleWaiter &idle_waiter, bool idle_mode);
+void DrawMemoryOverlay(const FrameAllocations &frame_allocations, const SceneRegistry &registry, double startup_time);
+void DumpMemoryReport(const FrameAllocations &frame_allocations, const Scene *scene);
+
+int main(int argc, char **argv) {
+    auto process_start = std::chrono::steady_clock::now();
+    double startup_time = 0; // from the start of the process to the end of the first frame, in seconds
+
+    // scenes are constructed when they are opened for the first time
+    SceneRegistry registry;
+    RegisterScenes(registry);
+
+    // main --render <scene key> <file.png> draws one scene with the software rasterizer, no window is opened
+    if (argc == 4 && TextIsEqual(argv[1], "--render")) {
+        return RenderHeadless(registry, argv[2][0], argv[3]);
+    }
+
+    // statistics of every visited scene are written to disk when the window is closed
+    bool export_frame_stats = argc > 1 && TextIsEqual(argv[1], "--frame-stats");
 
-int main() {
     InitWindow(WIDTH, HEIGHT, "Graphics");
     SetTargetFPS(TARGET_FPS);
 
     SetTraceLogLevel(LOG_DEBUG);
 
+    // every cursor event is recorded, not only the last one of a frame
+    GetPointerInput().Install();
+
     GuiSetStyle(DEFAULT, TEXT_SIZE, 20);
     GuiSetStyle(DEFAULT, LINE_COLOR, ColorToInt(GRAY));
 
-    SceneDrawPolygons     scene_draw_polygons;
-    SceneLocalization     scene_localization;
-    SceneBezierElementary scene_elementary_bezier;
-    SceneBezier           scene_bezier;
-    SceneEllipses         scene_ellipses;
+    registry.Activate('1');
+    Scene *scene = registry.CurrentScene();
+
+    FrameAllocations frame_allocations;
+
+    FrameRecorder playground_frame_recorder("playground");
+    FrameRecorder *frame_recorder = &registry.Current()->frame_recorder;
+    int nframe_exports = 0;
 
-    Scene *scene = &scene_draw_polygons;
+    bool show_debug_overlay = false;
+    bool show_memory_overlay = false;
+
+    // nothing is redrawn while the scene is not dirty and there is no input
+    bool idle_mode = true;
+    IdleWaiter idle_waiter;
+    bool waited = false; // last EndDrawing() slept waiting for events
+    CpuUsageMeter cpu_usage;
 
     while (!WindowShouldClose()) {
+        double frame_start = GetTime();
+        FrameTimes frame_times;
+
+        frame_allocations.BeginFrame();
+        GetPointerInput().BeginFrame();
 
         // scene is not switchable when input boxes are active
         if (!scene || scene->IsSwitchable()) {
-            switch (GetCharPressed()) {
-            case '1':
-                ShowCursor(); 
-                scene = &scene_draw_polygons;
-                break;
-            case '2':
-                ShowCursor(); 
-                scene = &scene_ellipses;
-                break;
-            case '3':
-                HideCursor();
-                scene = &scene_localization;
-                break;
-            case '4':
-                ShowCursor(); 
-                scene = &scene_elementary_bezier;
-                break;
-            case '5':
-                ShowCursor();
-                scene = &scene_bezier;
-                break;
-
-            case '0':
-                ShowCursor(); 
-                scene = nullptr; // empty scene used for testing
-                break;
+            Scene *prev_scene = scene;
+
+            if (int key = GetCharPressed(); key == '0') {
+                registry.Deactivate(); // empty scene used for testing
+            } else if (key != 0) {
+                registry.Activate(key);
+            }
+
+            scene = registry.CurrentScene();
+            frame_recorder = registry.Current() ? &registry.Current()->frame_recorder : &playground_frame_recorder;
+
+            // allocation counters are per scene
+            if (scene != prev_scene) {
+                frame_allocations.Reset();
+                for (AsyncTessellator *tessellator : AsyncTessellator::Registry()) {
+                    tessellator->ResetStats();
+                }
+            }
+        }
+
+        if (IsKeyPressed(KEY_F1)) {
+            show_debug_overlay = !show_debug_overlay;
+        }
+        if (IsKeyPressed(KEY_F2)) {
+            if (IsKeyDown(KEY_LEFT_CONTROL)) {
+                DumpMemoryReport(frame_allocations, scene);
+            } else {
+                show_memory_overlay = !show_memory_overlay;
+            }
+        }
+        if (IsKeyPressed(KEY_F4)) {
+            idle_mode = !idle_mode;
+            TraceLog(LOG_INFO, "Idle mode %s", idle_mode ? "on" : "off");
+        }
+        // scene is captured when the frame is on the screen
+        bool capture = IsKeyPressed(KEY_F12) && scene;
+        if (IsKeyPressed(KEY_F3)) {
+            std::string prefix = TextFormat("frames_%s_%02i", frame_recorder->name.c_str(), nframe_exports++);
+            if (frame_recorder->Export(prefix.c_str())) {
+                TraceLog(LOG_INFO, "Exported frame statistics to %s.csv and %s.json", prefix.c_str(), prefix.c_str());
             }
         }
         
         if (scene) {
-            scene->Update(GetFrameTime());
+            ScopedMemoryTag memory_tag(MemoryTag::Scene);
+
+            // time spent waiting for events is not a frame the scene should catch up with
+            double update_start = GetTime();
+            scene->Update(waited ? 0.f : GetFrameTime());
+            frame_times.update = GetTime() - update_start;
         }
 
+        double draw_start = GetTime();
         BeginDrawing();
 
             ClearBackground(COLOR_BACKGROUND);
             if (scene) {
+                ScopedMemoryTag memory_tag(MemoryTag::Scene);
                 scene->Draw();
             } else {
                 DrawThePlayground();
             }
 
+            if (show_debug_overlay) {
+                DrawDebugOverlay(frame_allocations, *frame_recorder, cpu_usage, idle_waiter, idle_mode);
+            }
+            if (show_memory_overlay) {
+                DrawMemoryOverlay(frame_allocations, registry, startup_time);
+            }
+
+            // events are polled in EndDrawing(), so this is where the loop sleeps
+            if (idle_mode && !(scene && scene->IsDirty())) {
+                idle_waiter.Arm();
+            } else {
+                idle_waiter.Disarm();
+            }
+
+            double draw_end = GetTime();
+            double deadline = TARGET_FPS > 0 ? 1.0 / TARGET_FPS : 0;
+
+            // scenes are preloaded in the time the frame has left before the swap, or not at all
+            registry.Maintain(deadline - (draw_end - frame_start));
+
+        double swap_start = GetTime();
         EndDrawing();
+        frame_times.draw = draw_end - draw_start;
+        frame_times.swap = GetTime() - swap_start;
+
+        // an armed waiter returns as soon as an event comes, so the loop only slept
+        // when the swap took longer than a frame would, e.g. not while the mouse moves
+        waited = idle_waiter.Armed() && frame_times.swap > (deadline > 0 ? deadline : 1.0 / 60);
+
+        if (capture) {
+            CaptureScene(*scene);
+        }
+
+        // nothing allocated from the arena may outlive the frame
+        GetFrameArena().Reset();
+
+        frame_allocations.EndFrame();
+
+        frame_times.total = GetTime() - frame_start;
+
+        // frames that slept until the next event would only spoil the statistics
+        if (!waited) {
+            frame_recorder->deadline = deadline;
+            frame_recorder->Record(frame_start, frame_times);
+        }
+
+        cpu_usage.Update();
+
+        if (startup_time == 0) {
+            startup_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - process_start).count();
+            TraceLog(LOG_INFO, "Startup to first frame: %f ms", startup_time * 1000);
+        }
+    }
+
+    if (export_frame_stats) {
+        auto export_recorder = [](const FrameRecorder &recorder) {
+            if (recorder.frames > 0) {
+                std::string prefix = "frames_" + recorder.name;
+                recorder.Export(prefix.c_str());
+            }
+        };
+        for (const auto &entry : registry.Entries()) {
+            export_recorder(entry.frame_recorder);
+        }
+        export_recorder(playground_frame_recorder);
     }
 
     CloseWindow();
@@ -87,13 +230,84 @@ int main() {
     return 0;
 }
 
+void RegisterScenes(SceneRegistry &registry) {
+    registry.Register<SceneDrawPolygons>('1', "draw_polygons");
+    registry.Register<SceneEllipses>('2', "ellipses", true, true);
+    registry.Register<SceneLocalization>('3', "localization", false);
+    registry.Register<SceneBezierElementary>('4', "elementary_bezier");
+    registry.Register<SceneBezier>('5', "bezier");
+}
+
+// draws the scene into the rasterizer and writes it to a png, text and gui are skipped
+bool RenderScene(Scene &scene, SoftwareRasterizer &rasterizer, const char *file_name) {
+    rasterizer.Clear(COLOR_BACKGROUND);
+
+    SoftwareRasterizer *prev_target = Render::GetSoftwareTarget();
+    Render::SetSoftwareTarget(&rasterizer);
+    scene.Draw();
+    Render::SetSoftwareTarget(prev_target);
+
+    size_t nprimitives = rasterizer.PendingPrimitives();
+
+    // GetTime() only works with a window
+    auto start = std::chrono::steady_clock::now();
+    rasterizer.Flush();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!rasterizer.Export(file_name)) {
+        TraceLog(LOG_ERROR, "Failed to write %s", file_name);
+        return false;
+    }
+    TraceLog(LOG_INFO, "Rendered scene to %s: %zu primitives rasterized in %f ms", file_name, nprimitives, elapsed * 1000);
+    return true;
+}
+
+void CaptureScene(Scene &scene) {
+    static int ncaptures = 0;
+
+    SoftwareRasterizer rasterizer(GetScreenWidth(), GetScreenHeight());
+    RenderScene(scene, rasterizer, TextFormat("capture_%02i.png", ncaptures++));
+}
+
+int RenderHeadless(const SceneRegistry &registry, int key, const char *file_name) {
+    // frames the scene is updated for before it is drawn, so animations get going
+    const int nframes = 60;
+
+    const SceneRegistry::Entry *entry = nullptr;
+    for (const auto &candidate : registry.Entries()) {
+        if (candidate.key == key) {
+            entry = &candidate;
+        }
+    }
+    if (!entry) {
+        TraceLog(LOG_ERROR, "There is no scene with key '%c'", key);
+        return 1;
+    }
+
+    // random generator is only seeded by InitWindow(), the fixed seed makes renders reproducible
+    SetRandomSeed(0x5eed);
+
+    // target is set before the scene is constructed, so the scene is laid out for its size
+    SoftwareRasterizer rasterizer(WIDTH, HEIGHT);
+    Render::SetSoftwareTarget(&rasterizer);
+
+    std::unique_ptr<Scene> scene = entry->factory();
+    for (int i = 0; i < nframes; ++i) {
+        scene->Update(1.f / 60);
+    }
+    bool rendered = RenderScene(*scene, rasterizer, file_name);
+
+    Render::SetSoftwareTarget(nullptr);
+    return rendered ? 0 : 1;
+}
+
 void DrawThePlayground() {
     DrawLineBezier({100, 100}, {200, 200}, 2, COLOR_LINE_PRIMARY);
     GuiGroupBox({300, 300, 400, 400}, "Window"); 
 
     // DrawCircleV({450, 450}, 3, COLOR_POINT_PRIMARY);
     // DrawCircleV({500, 500}, 3, COLOR_POINT_PRIMARY);
-    DrawLineDotted({450, 450}, {500, 500}, 20, 5, GRAY);
+    Render::DrawLineDotted({450, 450}, {500, 500}, 20, 5, GRAY);
 
     DrawLineEx({600, 300}, {601, 300}, 16, GRAY);
 
@@ -107,4 +321,140 @@ void DrawThePlayground() {
         DrawCircleV({ 100, 100 }, 7, BROWN);
         DrawCircleV(i.value(), 7, COLOR_POINT_SECONDARY);
     }
+}
+
+void DrawDebugOverlay(const FrameAllocations &frame_allocations, const FrameRecorder &frame_recorder,
+                      const CpuUsageMeter &cpu_usage, const IdleWaiter &idle_waiter, bool idle_mode) {
+    const int font_size = 20;
+
+    int nlines = 7 + (int) CachedLayer::Registry().size() + (int) AsyncTessellator::Registry().size();
+    int y = GetScreenHeight() - nlines * (font_size + 5);
+
+    DrawFPS(20, y);
+    y += font_size + 5;
+
+    DrawText(TextFormat("cpu: %.1f%% of a core; idle mode %s%s", cpu_usage.usage * 100,
+                        idle_mode ? "on" : "off", idle_waiter.Armed() ? ", sleeping until input" : ""),
+             20, y, font_size, GRAY);
+    y += font_size + 5;
+
+    const PointerInput &pointer = GetPointerInput();
+    DrawText(TextFormat("pointer: %zu events last frame, %.0f px/s", pointer.FrameSamples().size(), Vector2Length(pointer.Velocity())),
+             20, y, font_size, GRAY);
+    y += font_size + 5;
+
+    const FrameTimes &last = frame_recorder.Last().times;
+    DrawText(TextFormat("update %.3f ms, draw %.3f ms, swap %.3f ms (max update %.3f ms)",
+                        last.update * 1000, last.draw * 1000, last.swap * 1000, frame_recorder.update.max * 1000),
+             20, y, font_size, GRAY);
+    y += font_size + 5;
+
+    const DurationHistogram &total = frame_recorder.total;
+    DrawText(TextFormat("frame p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms; missed deadlines: %zu / %zu",
+                        total.Percentile(0.50) * 1000, total.Percentile(0.95) * 1000, total.Percentile(0.99) * 1000,
+                        total.max * 1000, frame_recorder.missed_deadlines, frame_recorder.frames),
+             20, y, font_size, GRAY);
+    y += font_size + 5;
+
+    DrawText(TextFormat("heap allocations last frame: %zu (%zu bytes)",
+                        frame_allocations.last_frame.allocations, frame_allocations.last_frame.bytes),
+             20, y, font_size, GRAY);
+    y += font_size + 5;
+
+    DrawText(TextFormat("frames with allocations: %zu / %zu",
+                        frame_allocations.frames_with_allocations, frame_allocations.frames),
+             20, y, font_size, GRAY);
+    y += font_size + 5;
+
+    for (const CachedLayer *layer : CachedLayer::Registry()) {
+        DrawText(TextFormat("layer '%s' cache hits: %.1f%% (%zu / %zu)",
+                            layer->name, layer->HitRate() * 100, layer->hits, layer->hits + layer->misses),
+                 20, y, font_size, GRAY);
+        y += font_size + 5;
+    }
+
+    for (const AsyncTessellator *tessellator : AsyncTessellator::Registry()) {
+        const auto &stats = tessellator->stats;
+        DrawText(TextFormat("tessellator '%s' (%s): latency %.3f ms avg, %.3f ms max; %zu jobs, %zu coalesced",
+                            tessellator->name, tessellator->async ? "async" : "sync",
+                            stats.latency_average * 1000, stats.latency_max * 1000,
+                            stats.submitted, stats.coalesced),
+                 20, y, font_size, GRAY);
+        y += font_size + 5;
+    }
+}
+
+void DrawMemoryOverlay(const FrameAllocations &frame_allocations, const SceneRegistry &registry, double startup_time) {
+    const int font_size = 20;
+    const int x = GetScreenWidth() - 620;
+    int y = 20;
+
+    DrawText(TextFormat("heap: %.2f MB (peak %.2f MB)", GetHeapBytesCurrent() / 1048576.0, GetHeapBytesPeak() / 1048576.0),
+             x, y, font_size, GRAY);
+    y += font_size + 5;
+
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        MemoryTag tag = (MemoryTag) i;
+        MemoryTagStats stats = GetMemoryTagStats(tag);
+        DrawText(TextFormat("%s: %.2f MB (peak %.2f MB), %zu allocs last frame",
+                            MemoryTagName(tag), stats.bytes_current / 1048576.0, stats.bytes_peak / 1048576.0,
+                            frame_allocations.tags_last_frame[i]),
+                 x, y, font_size, GRAY);
+        y += font_size + 5;
+    }
+
+    for (const CountingResource *resource : CountingResource::Registry()) {
+        DrawText(TextFormat("resource '%s': %.2f MB (peak %.2f MB)",
+                            resource->name, resource->BytesCurrent() / 1048576.0, resource->BytesPeak() / 1048576.0),
+                 x, y, font_size, GRAY);
+        y += font_size + 5;
+    }
+
+    DrawText(TextFormat("startup to first frame: %.1f ms", startup_time * 1000), x, y, font_size, GRAY);
+    y += font_size + 5;
+
+    for (const auto &entry : registry.Entries()) {
+        if (!entry.scene) {
+            DrawText(TextFormat("scene '%s': not loaded", entry.name), x, y, font_size, GRAY);
+            y += font_size + 5;
+            continue;
+        }
+
+        auto usage = entry.scene->MemoryUsage();
+
+        size_t resident = 0;
+        for (const auto &[name, bytes] : usage) {
+            resident += bytes;
+        }
+
+        DrawText(TextFormat("scene '%s': built in %.2f ms (%.2f MB), %.2f MB now%s",
+                            entry.name, entry.construction_time * 1000, entry.construction_bytes / 1048576.0,
+                            resident / 1048576.0, entry.heavy_state_released ? ", released" : ""),
+                 x, y, font_size, GRAY);
+        y += font_size + 5;
+
+        // breakdown only for the scene on screen
+        if (&entry != registry.Current()) {
+            continue;
+        }
+        for (const auto &[name, bytes] : usage) {
+            DrawText(TextFormat("  %s: %.2f MB", name, bytes / 1048576.0), x, y, font_size, GRAY);
+            y += font_size + 5;
+        }
+    }
+}
+
+void DumpMemoryReport(const FrameAllocations &frame_allocations, const Scene *scene) {
+    static int nreports = 0;
+
+    std::vector<MemoryUsageEntry> scene_usage;
+    if (scene) {
+        scene_usage = scene->MemoryUsage();
+    }
+
+    // report is formatted with TextFormat() too, so the name is copied out of its buffer
+    std::string file_name = TextFormat("memory_%02i.json", nreports++);
+    if (ExportMemoryReport(file_name.c_str(), frame_allocations, scene_usage)) {
+        TraceLog(LOG_INFO, "Exported memory report to %s", file_name.c_str());
+    }
 }
\ No newline at end of file
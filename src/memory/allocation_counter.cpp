@@ -0,0 +1,314 @@
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <new>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+/*
+    Replacements of the global operator new and delete, aligned versions included:
+    std::pmr::new_delete_resource() allocates with the aligned ones, so every pmr container goes through them.
+
+    Every block is prefixed with a header that keeps its size and tag,
+    so live bytes are known without asking malloc and frees go to the right tag.
+    The header is 16 bytes and sits right before the block, so blocks keep the alignment malloc gives them.
+    Over-aligned blocks are moved forward in a larger malloc one, the header keeps how far.
+
+    The only locked operations per allocation are the ones on the heap total,
+    so the counters are cheap enough to be always on.
+*/
+
+namespace {
+
+struct alignas(16) Header {
+    size_t size;
+    uint32_t offset; // from the start of the malloc block to the returned one
+    MemoryTag tag;
+};
+
+static_assert(sizeof(Header) == 16);
+
+// every thread counts into its own block, so counting is a plain add instead of a locked one
+// readers sum all blocks, bytes_current of a block may wrap when memory is freed by another thread,
+// but the sum is still right
+struct TagCounters {
+    std::atomic<size_t> allocations   = 0;
+    std::atomic<size_t> deallocations = 0;
+    std::atomic<size_t> bytes         = 0;
+    std::atomic<size_t> bytes_current = 0;
+};
+
+struct alignas(64) ThreadCounters {
+    TagCounters tags[MEMORY_TAG_COUNT];
+};
+
+// blocks are never released, so counts of finished threads stay in the sums
+// threads that didn't get a block of their own share the last one with locked adds
+constexpr size_t MAX_COUNTED_THREADS = 64;
+ThreadCounters thread_counters[MAX_COUNTED_THREADS + 1];
+ThreadCounters &shared_counters = thread_counters[MAX_COUNTED_THREADS];
+std::atomic<size_t> nthreads_counted = 0;
+
+thread_local ThreadCounters *own_counters = nullptr;
+thread_local MemoryTag current_tag = MemoryTag::Untagged;
+
+// peak of the whole heap is exact, peaks of tags are sampled when they are read
+std::atomic<size_t> heap_bytes_current = 0;
+std::atomic<size_t> heap_bytes_peak    = 0;
+std::atomic<size_t> tag_bytes_peak[MEMORY_TAG_COUNT] = {};
+
+ThreadCounters &OwnCounters() {
+    if (!own_counters) {
+        size_t idx = nthreads_counted.fetch_add(1, std::memory_order_relaxed);
+        own_counters = idx < MAX_COUNTED_THREADS ? &thread_counters[idx] : &shared_counters;
+    }
+    return *own_counters;
+}
+
+void Add(ThreadCounters &counters, std::atomic<size_t> &counter, size_t value) {
+    if (&counters == &shared_counters) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    } else {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+}
+
+void UpdatePeak(std::atomic<size_t> &peak, size_t value) {
+    size_t old = peak.load(std::memory_order_relaxed);
+    while (value > old && !peak.compare_exchange_weak(old, value, std::memory_order_relaxed)) {}
+}
+
+size_t CountedThreads() {
+    return std::min(nthreads_counted.load(std::memory_order_relaxed), MAX_COUNTED_THREADS);
+}
+
+// sum of a counter over all threads
+size_t Sum(size_t tag_idx, std::atomic<size_t> TagCounters::*counter) {
+    size_t sum = (shared_counters.tags[tag_idx].*counter).load(std::memory_order_relaxed);
+    for (size_t i = 0, n = CountedThreads(); i < n; ++i) {
+        sum += (thread_counters[i].tags[tag_idx].*counter).load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void *Allocate(size_t size, size_t alignment=sizeof(Header)) {
+    // malloc blocks are aligned to 16 bytes, so a block moves by alignment - 16 at most
+    alignment = std::max(alignment, sizeof(Header));
+    char *block = (char *) std::malloc(alignment + size);
+    if (!block) {
+        return nullptr;
+    }
+
+    char *ptr = block + sizeof(Header);
+    ptr += (alignment - (uintptr_t) ptr % alignment) % alignment;
+
+    MemoryTag tag = current_tag;
+    Header *header = new ((Header *) ptr - 1) Header { size, (uint32_t) (ptr - block), tag };
+
+    ThreadCounters &counters = OwnCounters();
+    TagCounters &tag_counters = counters.tags[(size_t) tag];
+    Add(counters, tag_counters.allocations, 1);
+    Add(counters, tag_counters.bytes, size);
+    Add(counters, tag_counters.bytes_current, size);
+
+    UpdatePeak(heap_bytes_peak, heap_bytes_current.fetch_add(size, std::memory_order_relaxed) + size);
+
+    return header + 1;
+}
+
+void Deallocate(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    Header *header = (Header *) ptr - 1;
+
+    ThreadCounters &counters = OwnCounters();
+    TagCounters &tag_counters = counters.tags[(size_t) header->tag];
+    Add(counters, tag_counters.deallocations, 1);
+    Add(counters, tag_counters.bytes_current, -header->size);
+
+    heap_bytes_current.fetch_sub(header->size, std::memory_order_relaxed);
+
+    std::free((char *) ptr - header->offset);
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+    if (void *ptr = Allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) {
+    if (void *ptr = Allocate(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return Allocate(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    Deallocate(ptr);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    if (void *ptr = Allocate(size, (size_t) alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    if (void *ptr = Allocate(size, (size_t) alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return Allocate(size, (size_t) alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return Allocate(size, (size_t) alignment);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    Deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    Deallocate(ptr);
+}
+
+AllocationCounters GetAllocationCounters() {
+    AllocationCounters res;
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        res.allocations   += Sum(i, &TagCounters::allocations);
+        res.deallocations += Sum(i, &TagCounters::deallocations);
+        res.bytes         += Sum(i, &TagCounters::bytes);
+    }
+    return res;
+}
+
+const char *MemoryTagName(MemoryTag tag) {
+    switch (tag) {
+    case MemoryTag::Untagged:  return "untagged";
+    case MemoryTag::Scene:     return "scene";
+    case MemoryTag::Geometry:  return "geometry";
+    case MemoryTag::Animation: return "animation";
+    case MemoryTag::GUI:       return "gui";
+    case MemoryTag::History:   return "history";
+    case MemoryTag::Render:    return "render";
+    default:                   return "unknown";
+    }
+}
+
+MemoryTagStats GetMemoryTagStats(MemoryTag tag) {
+    size_t tag_idx = (size_t) tag;
+
+    MemoryTagStats stats;
+    stats.counters = AllocationCounters {
+        Sum(tag_idx, &TagCounters::allocations),
+        Sum(tag_idx, &TagCounters::deallocations),
+        Sum(tag_idx, &TagCounters::bytes)
+    };
+    stats.bytes_current = Sum(tag_idx, &TagCounters::bytes_current);
+
+    UpdatePeak(tag_bytes_peak[tag_idx], stats.bytes_current);
+    stats.bytes_peak = tag_bytes_peak[tag_idx].load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+size_t GetHeapBytesCurrent() {
+    return heap_bytes_current.load(std::memory_order_relaxed);
+}
+
+size_t GetHeapBytesPeak() {
+    return heap_bytes_peak.load(std::memory_order_relaxed);
+}
+
+ScopedMemoryTag::ScopedMemoryTag(MemoryTag tag) : previous(current_tag) {
+    current_tag = tag;
+}
+
+ScopedMemoryTag::~ScopedMemoryTag() {
+    current_tag = previous;
+}
+
+MemoryTag GetCurrentMemoryTag() {
+    return current_tag;
+}
+
+void FrameAllocations::BeginFrame() {
+    frame_start = GetAllocationCounters();
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        tags_frame_start[i] = Sum(i, &TagCounters::allocations);
+    }
+}
+
+void FrameAllocations::EndFrame() {
+    last_frame = GetAllocationCounters() - frame_start;
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        // reading the stats also samples peaks of tags once a frame
+        tags_last_frame[i] = GetMemoryTagStats((MemoryTag) i).counters.allocations - tags_frame_start[i];
+    }
+
+    ++frames;
+    if (last_frame.allocations != 0) {
+        ++frames_with_allocations;
+    }
+}
+
+void FrameAllocations::Reset() {
+    frames = 0;
+    frames_with_allocations = 0;
+}
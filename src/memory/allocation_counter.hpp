@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+// counters of global operator new/delete calls
+// they are used to check that steady-state frames do not touch the heap
+struct AllocationCounters {
+    size_t allocations   = 0;
+    size_t deallocations = 0;
+    size_t bytes         = 0; // total bytes ever requested
+
+    AllocationCounters operator-(const AllocationCounters &other) const {
+        return { allocations - other.allocations, deallocations - other.deallocations, bytes - other.bytes };
+    }
+};
+
+AllocationCounters GetAllocationCounters();
+
+// subsystems heap allocations are attributed to, see ScopedMemoryTag
+enum class MemoryTag : unsigned char {
+    Untagged,
+    Scene,
+    Geometry,
+    Animation,
+    GUI,
+    History,
+    Render,
+
+    Count
+};
+
+constexpr size_t MEMORY_TAG_COUNT = (size_t) MemoryTag::Count;
+
+const char *MemoryTagName(MemoryTag tag);
+
+struct MemoryTagStats {
+    AllocationCounters counters;
+    size_t bytes_current = 0; // bytes allocated under the tag and not freed yet
+    size_t bytes_peak    = 0; // high-water mark of bytes_current, sampled once a frame and whenever stats are read
+};
+
+MemoryTagStats GetMemoryTagStats(MemoryTag tag);
+
+// sums over all tags, the peak is exact
+size_t GetHeapBytesCurrent();
+size_t GetHeapBytesPeak();
+
+// allocations made by this thread while the scope is alive are attributed to tag,
+// scopes nest and the innermost one wins
+// memory is credited back to the tag it was allocated under, whoever frees it
+struct ScopedMemoryTag {
+    explicit ScopedMemoryTag(MemoryTag tag);
+    ~ScopedMemoryTag();
+
+    ScopedMemoryTag(const ScopedMemoryTag &) = delete;
+    ScopedMemoryTag &operator=(const ScopedMemoryTag &) = delete;
+
+private:
+    MemoryTag previous;
+};
+
+MemoryTag GetCurrentMemoryTag();
+
+// allocations made during the last finished frame
+struct FrameAllocations {
+    AllocationCounters frame_start;
+    AllocationCounters last_frame;
+
+    std::array<size_t, MEMORY_TAG_COUNT> tags_frame_start {};
+    std::array<size_t, MEMORY_TAG_COUNT> tags_last_frame {}; // allocations per tag
+
+    size_t frames = 0;
+    size_t frames_with_allocations = 0;
+
+    void BeginFrame();
+    void EndFrame();
+    void Reset();
+};
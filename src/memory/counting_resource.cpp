@@ -0,0 +1,44 @@
+#include "counting_resource.hpp"
+
+#include <algorithm>
+
+CountingResource::CountingResource(const char *name, std::pmr::memory_resource *upstream) :
+    name(name), upstream(upstream)
+{
+    MutableRegistry().push_back(this);
+}
+
+CountingResource::~CountingResource() {
+    auto &registry = MutableRegistry();
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+void *CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    void *ptr = upstream->allocate(bytes, alignment);
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t current = bytes_current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    size_t peak = bytes_peak.load(std::memory_order_relaxed);
+    while (current > peak && !bytes_peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {}
+
+    return ptr;
+}
+
+void CountingResource::do_deallocate(void *ptr, size_t bytes, size_t alignment) {
+    bytes_current.fetch_sub(bytes, std::memory_order_relaxed);
+    upstream->deallocate(ptr, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+const std::vector<CountingResource *> &CountingResource::Registry() {
+    return MutableRegistry();
+}
+
+std::vector<CountingResource *> &CountingResource::MutableRegistry() {
+    static std::vector<CountingResource *> registry;
+    return registry;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+// memory resource that counts what goes through it to upstream
+// containers of a scene are given one to measure exactly how much memory they take, overhead included
+// counters are atomic, containers may grow from several threads (e.g. curves tessellated in parallel)
+struct CountingResource : std::pmr::memory_resource {
+    const char *name;
+
+    explicit CountingResource(const char *name, std::pmr::memory_resource *upstream=std::pmr::get_default_resource());
+    ~CountingResource();
+
+    CountingResource(const CountingResource &) = delete;
+    CountingResource &operator=(const CountingResource &) = delete;
+
+    size_t BytesCurrent() const {
+        return bytes_current.load(std::memory_order_relaxed);
+    }
+    size_t BytesPeak() const {
+        return bytes_peak.load(std::memory_order_relaxed);
+    }
+    size_t Allocations() const {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    // all alive resources, used to show statistics
+    static const std::vector<CountingResource *> &Registry();
+
+private:
+    std::pmr::memory_resource *upstream;
+
+    std::atomic<size_t> bytes_current = 0;
+    std::atomic<size_t> bytes_peak    = 0;
+    std::atomic<size_t> allocations   = 0;
+
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    static std::vector<CountingResource *> &MutableRegistry();
+};
@@ -0,0 +1,11 @@
+#include "frame_arena.hpp"
+
+FrameArena::FrameArena(size_t capacity) :
+    buffer(capacity),
+    resource(buffer.data(), buffer.size(), std::pmr::new_delete_resource())
+{}
+
+FrameArena &GetFrameArena() {
+    static FrameArena arena;
+    return arena;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <cstddef>
+
+// monotonic arena for transient data that never outlives a frame
+// main loop resets it right after EndDrawing(), so memory from it must not be kept between frames
+struct FrameArena {
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 20;
+
+    // buffer is allocated once, arena falls back to the heap only when it is exhausted
+    std::vector<std::byte> buffer;
+    std::pmr::monotonic_buffer_resource resource;
+
+    explicit FrameArena(size_t capacity=DEFAULT_CAPACITY);
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    std::pmr::memory_resource *Resource() {
+        return &resource;
+    }
+
+    void Reset() {
+        resource.release();
+    }
+};
+
+FrameArena &GetFrameArena();
@@ -0,0 +1,53 @@
+#include "memory_report.hpp"
+#include "counting_resource.hpp"
+
+#include <raylib.h>
+
+std::string MemoryReportJson(const FrameAllocations &frame_allocations, std::span<const MemoryUsageEntry> scene_usage) {
+    std::string json = "{\n";
+
+    json += TextFormat("  \"heap\": { \"bytes_current\": %zu, \"bytes_peak\": %zu },\n",
+                       GetHeapBytesCurrent(), GetHeapBytesPeak());
+
+    json += TextFormat("  \"frames\": %zu,\n  \"frames_with_allocations\": %zu,\n",
+                       frame_allocations.frames, frame_allocations.frames_with_allocations);
+
+    json += "  \"tags\": {\n";
+    for (size_t i = 0; i < MEMORY_TAG_COUNT; ++i) {
+        MemoryTag tag = (MemoryTag) i;
+        MemoryTagStats stats = GetMemoryTagStats(tag);
+
+        json += TextFormat("    \"%s\": { \"allocations\": %zu, \"deallocations\": %zu, \"bytes_total\": %zu, "
+                           "\"bytes_current\": %zu, \"bytes_peak\": %zu, \"allocations_last_frame\": %zu }%s\n",
+                           MemoryTagName(tag), stats.counters.allocations, stats.counters.deallocations,
+                           stats.counters.bytes, stats.bytes_current, stats.bytes_peak,
+                           frame_allocations.tags_last_frame[i], i + 1 < MEMORY_TAG_COUNT ? "," : "");
+    }
+    json += "  },\n";
+
+    const auto &resources = CountingResource::Registry();
+    json += "  \"resources\": {\n";
+    for (size_t i = 0; i < resources.size(); ++i) {
+        const CountingResource *resource = resources[i];
+        json += TextFormat("    \"%s\": { \"allocations\": %zu, \"bytes_current\": %zu, \"bytes_peak\": %zu }%s\n",
+                           resource->name, resource->Allocations(), resource->BytesCurrent(), resource->BytesPeak(),
+                           i + 1 < resources.size() ? "," : "");
+    }
+    json += "  },\n";
+
+    json += "  \"scene\": {\n";
+    for (size_t i = 0; i < scene_usage.size(); ++i) {
+        json += TextFormat("    \"%s\": %zu%s\n", scene_usage[i].name, scene_usage[i].bytes,
+                           i + 1 < scene_usage.size() ? "," : "");
+    }
+    json += "  }\n";
+
+    json += "}\n";
+    return json;
+}
+
+bool ExportMemoryReport(const char *file_name, const FrameAllocations &frame_allocations,
+                        std::span<const MemoryUsageEntry> scene_usage) {
+    std::string json = MemoryReportJson(frame_allocations, scene_usage);
+    return SaveFileText(file_name, json.data());
+}
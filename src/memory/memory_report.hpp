@@ -0,0 +1,18 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <cstddef>
+
+#include "allocation_counter.hpp"
+
+// named part of the memory a scene holds, e.g. its control points
+struct MemoryUsageEntry {
+    const char *name;
+    size_t bytes;
+};
+
+// machine-readable dump of tag counters, counting resources and scene's own breakdown
+std::string MemoryReportJson(const FrameAllocations &frame_allocations, std::span<const MemoryUsageEntry> scene_usage);
+bool ExportMemoryReport(const char *file_name, const FrameAllocations &frame_allocations,
+                        std::span<const MemoryUsageEntry> scene_usage);
@@ -0,0 +1,168 @@
+#include "async_tessellator.hpp"
+
+#include <raylib.h>
+
+#include <algorithm>
+
+#include "memory/allocation_counter.hpp"
+
+AsyncTessellator::AsyncTessellator(const char *name, std::pmr::memory_resource *resource) : name(name), resource(resource) {
+    worker = std::thread(&AsyncTessellator::WorkerLoop, this);
+    MutableRegistry().push_back(this);
+}
+
+AsyncTessellator::~AsyncTessellator() {
+    {
+        std::lock_guard lock(mutex);
+        stop = true;
+    }
+    wake.notify_one();
+    worker.join();
+
+    auto &registry = MutableRegistry();
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+void AsyncTessellator::Submit(Key key, BezierCurve &curve) {
+    double now = GetTime();
+    ++stats.submitted;
+
+    if (!async) {
+        curve.Update();
+
+        ++stats.completed;
+        RecordLatency(GetTime() - now);
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+
+        auto [it, inserted] = pending.try_emplace(key, resource);
+        Job &job = it->second;
+        if (inserted) {
+            job.submit_time = now;
+        } else {
+            // worker has not started the previous job yet, so it will only see the latest points
+            ++stats.coalesced;
+        }
+
+        job.control_points.assign(curve.control_points.begin(), curve.control_points.end());
+        job.segments = curve.bezier_segments;
+    }
+    wake.notify_one();
+}
+
+size_t AsyncTessellator::Apply(const CurveLookup &curve_of) {
+    std::lock_guard lock(mutex);
+    if (finished.empty()) {
+        return 0;
+    }
+
+    double now = GetTime();
+    size_t applied = 0;
+
+    for (auto &[key, job] : finished) {
+        BezierCurve *curve = curve_of(key);
+        if (!curve) {
+            continue;
+        }
+
+        // swapping is O(1), but only possible when both buffers come from the same memory resource
+        if (curve->curve_points.get_allocator() == job.curve_points.get_allocator()) {
+            curve->curve_points.swap(job.curve_points);
+            if (spare_buffers.size() < MAX_SPARE_BUFFERS) {
+                spare_buffers.push_back(std::move(job.curve_points));
+            }
+        } else {
+            curve->curve_points.assign(job.curve_points.begin(), job.curve_points.end());
+        }
+
+        ++stats.completed;
+        RecordLatency(now - job.submit_time);
+        ++applied;
+    }
+    finished.clear();
+
+    return applied;
+}
+
+void AsyncTessellator::Finish(const CurveLookup &curve_of) {
+    {
+        std::unique_lock lock(mutex);
+        idle.wait(lock, [this] { return pending.empty() && !in_progress; });
+    }
+    Apply(curve_of);
+}
+
+void AsyncTessellator::SetAsync(bool async, const CurveLookup &curve_of) {
+    if (!async) {
+        Finish(curve_of);
+    }
+    this->async = async;
+
+    TraceLog(LOG_INFO, "AsyncTessellator: '%s' switched to %s mode", name, async ? "async" : "sync");
+}
+
+bool AsyncTessellator::IsBusy() {
+    std::lock_guard lock(mutex);
+    return !pending.empty() || in_progress || !finished.empty();
+}
+
+void AsyncTessellator::WorkerLoop() {
+    ScopedMemoryTag memory_tag(MemoryTag::Geometry);
+
+    // curve_points of the scratch curve are swapped into jobs, so the worker owns no long-living buffers
+    BezierCurve scratch { BezierCurve::allocator_type(resource) };
+
+    std::unique_lock lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stop || !pending.empty(); });
+        if (stop) {
+            return;
+        }
+
+        auto node = pending.extract(pending.begin());
+        in_progress = true;
+        if (!spare_buffers.empty()) {
+            scratch.curve_points.swap(spare_buffers.back());
+            spare_buffers.pop_back();
+        }
+        lock.unlock();
+
+        Job &job = node.mapped();
+        scratch.bezier_segments = job.segments;
+        scratch.SetControlPoints(job.control_points.begin(), job.control_points.end());
+        job.curve_points.swap(scratch.curve_points);
+
+        lock.lock();
+        in_progress = false;
+
+        // result that was not applied yet is superseded, but its edit is still waiting for display
+        if (auto it = finished.find(node.key()); it != finished.end()) {
+            job.submit_time = std::min(job.submit_time, it->second.submit_time);
+            it->second = std::move(job);
+        } else {
+            finished.insert(std::move(node));
+        }
+
+        idle.notify_all();
+    }
+}
+
+void AsyncTessellator::RecordLatency(double latency) {
+    const double alpha = 0.1;
+
+    stats.latency_last    = latency;
+    stats.latency_average = stats.completed == 1 ? latency : stats.latency_average + alpha * (latency - stats.latency_average);
+    stats.latency_max     = std::max(stats.latency_max, latency);
+}
+
+const std::vector<AsyncTessellator *> &AsyncTessellator::Registry() {
+    return MutableRegistry();
+}
+
+std::vector<AsyncTessellator *> &AsyncTessellator::MutableRegistry() {
+    static std::vector<AsyncTessellator *> registry;
+    return registry;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "geometry/geometry.hpp"
+#include "geometry/bezier.hpp"
+
+// tessellates edited bezier curves on a background thread
+// curve keeps its old curve_points until the new ones are ready, then the buffers are swapped
+// new curve points are allocated from the memory resource of the curves, otherwise they could not be swapped
+// several edits of the same curve that come before the worker gets to it are coalesced into one job
+// in sync mode curves are tessellated right away, so both modes can be compared
+struct AsyncTessellator {
+    // identifies a curve, it is up to the owner how to pack it
+    using Key = uint64_t;
+    // returns the curve of the key or nullptr if the curve is gone
+    using CurveLookup = std::function<BezierCurve *(Key key)>;
+
+    struct Stats {
+        size_t submitted = 0;
+        size_t coalesced = 0; // submissions that replaced a pending job of the same curve
+        size_t completed = 0;
+
+        // seconds from the edit to the moment new curve points are in the curve
+        double latency_last    = 0;
+        double latency_average = 0; // exponential moving average
+        double latency_max     = 0;
+    };
+
+    const char *name;
+    bool async = true;
+    Stats stats;
+
+    // resource must be the one curve_points of the curves are allocated from and must outlive the tessellator
+    explicit AsyncTessellator(const char *name, std::pmr::memory_resource *resource=std::pmr::get_default_resource());
+    ~AsyncTessellator();
+
+    AsyncTessellator(const AsyncTessellator &) = delete;
+    AsyncTessellator &operator=(const AsyncTessellator &) = delete;
+
+    // tessellate curve with its current control points and segments
+    void Submit(Key key, BezierCurve &curve);
+    // swap finished buffers into their curves, call this on the thread the curves are drawn from
+    // returns number of updated curves
+    size_t Apply(const CurveLookup &curve_of);
+    // wait for every submitted job and apply it, e.g. before curves are added, removed or reordered
+    void Finish(const CurveLookup &curve_of);
+    // switching to sync mode finishes pending jobs first
+    void SetAsync(bool async, const CurveLookup &curve_of);
+    // some job is queued, running or waiting for Apply()
+    bool IsBusy();
+
+    void ResetStats() {
+        stats = Stats {};
+    }
+
+    // all alive tessellators, used to show statistics
+    static const std::vector<AsyncTessellator *> &Registry();
+
+private:
+    struct Job {
+        std::vector<Point> control_points;
+        int segments = BezierCurve::DEFAULT_SEGMENTS;
+        double submit_time = 0; // time of the first edit that is not displayed yet
+        std::pmr::vector<Point> curve_points;
+
+        explicit Job(std::pmr::memory_resource *resource) : curve_points(resource) {}
+    };
+
+    // old buffers of curves that got new points are reused by the worker
+    static constexpr size_t MAX_SPARE_BUFFERS = 4;
+
+    std::pmr::memory_resource *resource;
+
+    std::mutex mutex;
+    std::condition_variable wake; // new job or stop
+    std::condition_variable idle; // worker finished a job
+    std::unordered_map<Key, Job> pending;
+    std::unordered_map<Key, Job> finished;
+    std::vector<std::pmr::vector<Point>> spare_buffers;
+    bool in_progress = false;
+    bool stop = false;
+
+    std::thread worker;
+
+    void WorkerLoop();
+    void RecordLatency(double latency);
+
+    static std::vector<AsyncTessellator *> &MutableRegistry();
+};
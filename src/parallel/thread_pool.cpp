@@ -0,0 +1,131 @@
+#include "thread_pool.hpp"
+
+#include <raylib.h>
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t nthreads) {
+    nthreads = std::max<size_t>(nthreads, 1);
+
+    for (size_t i = 0; i < nthreads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (size_t i = 1; i < nthreads; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+
+    TraceLog(LOG_INFO, "ThreadPool: started %zu worker threads", workers.size());
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(sleep_mutex);
+        stop = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t n, size_t grain, const RangeFunc &func) {
+    if (n == 0) {
+        return;
+    }
+
+    grain = std::max<size_t>(grain, 1);
+
+    // few chunks per thread, so threads that finish early have something to steal
+    size_t nchunks = std::min((n + grain - 1) / grain, NumThreads() * 4);
+    if (nchunks <= 1 || NumThreads() == 1) {
+        func(0, n);
+        return;
+    }
+
+    std::atomic<size_t> remaining = nchunks;
+
+    // counted before pushing, so a thread that grabs a task early never sees the counter wrap
+    queued_tasks += nchunks;
+
+    // neighbouring chunks go to the same queue to keep memory access local
+    size_t chunks_per_queue = (nchunks + NumThreads() - 1) / NumThreads();
+    for (size_t chunk = 0; chunk < nchunks; ++chunk) {
+        Task task { &func, n * chunk / nchunks, n * (chunk + 1) / nchunks, &remaining, GetCurrentMemoryTag() };
+
+        auto &queue = *queues[chunk / chunks_per_queue];
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+
+    {
+        // sleeping threads check the counter under this lock, so the notification can't be missed
+        std::lock_guard lock(sleep_mutex);
+    }
+    wake.notify_all();
+
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        if (!RunOne(0)) {
+            // the rest of the chunks is being processed by other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop(size_t queue_idx) {
+    while (true) {
+        if (RunOne(queue_idx)) {
+            continue;
+        }
+
+        std::unique_lock lock(sleep_mutex);
+        wake.wait(lock, [this] { return stop || queued_tasks.load() != 0; });
+        if (stop) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::RunOne(size_t queue_idx) {
+    Task task;
+    bool found = false;
+
+    // own queue is processed from the front, others are robbed from the back
+    for (size_t i = 0; i < queues.size() && !found; ++i) {
+        auto &queue = *queues[(queue_idx + i) % queues.size()];
+
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+
+        if (i == 0) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        } else {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        found = true;
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    queued_tasks.fetch_sub(1);
+
+    {
+        ScopedMemoryTag memory_tag(task.tag);
+        (*task.func)(task.begin, task.end);
+    }
+    task.remaining->fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+ThreadPool &GetThreadPool() {
+    static ThreadPool pool;
+    return pool;
+}
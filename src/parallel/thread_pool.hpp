@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "memory/allocation_counter.hpp"
+
+// pool of worker threads with a task queue per thread
+// idle threads steal tasks from the back of other queues
+struct ThreadPool {
+    // calls func(begin, end) for subranges of [0, n)
+    using RangeFunc = std::function<void(size_t begin, size_t end)>;
+
+    // nthreads includes the calling thread, so nthreads - 1 workers are started
+    explicit ThreadPool(size_t nthreads=std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t NumThreads() const {
+        return queues.size();
+    }
+
+    // split [0, n) into chunks of at least grain elements and process them on all threads
+    // the calling thread takes part in the work and returns when every chunk is done,
+    // so it is safe to call it from inside of another ParallelFor
+    void ParallelFor(size_t n, size_t grain, const RangeFunc &func);
+
+private:
+    struct Task {
+        const RangeFunc *func = nullptr;
+        size_t begin = 0;
+        size_t end   = 0;
+        std::atomic<size_t> *remaining = nullptr; // tasks of the same ParallelFor left
+        MemoryTag tag = MemoryTag::Untagged;      // memory tag of the caller, so workers allocate under it too
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; // queues[0] is shared by all non-worker threads
+    std::vector<std::thread> workers;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued_tasks = 0;
+    bool stop = false;
+
+    void WorkerLoop(size_t queue_idx);
+    // pop a task from own queue or steal one, then run it
+    bool RunOne(size_t queue_idx);
+};
+
+// pool shared by the whole program
+ThreadPool &GetThreadPool();
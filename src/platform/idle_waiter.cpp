@@ -0,0 +1,64 @@
+#include "idle_waiter.hpp"
+
+#include <raylib.h>
+
+// raylib waits for events with GLFW, but only lets us enable or disable it
+// posting an empty event is the only way to wake it up from another thread
+extern "C" void glfwPostEmptyEvent(void);
+
+IdleWaiter::IdleWaiter() {
+    timer = std::thread(&IdleWaiter::TimerLoop, this);
+}
+
+IdleWaiter::~IdleWaiter() {
+    {
+        std::lock_guard lock(mutex);
+        stop = true;
+    }
+    wake.notify_one();
+    timer.join();
+}
+
+void IdleWaiter::Arm() {
+    {
+        std::lock_guard lock(mutex);
+        wake_at = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeout));
+    }
+    wake.notify_one();
+
+    if (!armed) {
+        EnableEventWaiting();
+        armed = true;
+    }
+}
+
+void IdleWaiter::Disarm() {
+    {
+        std::lock_guard lock(mutex);
+        wake_at.reset();
+    }
+
+    if (armed) {
+        DisableEventWaiting();
+        armed = false;
+    }
+}
+
+void IdleWaiter::TimerLoop() {
+    std::unique_lock lock(mutex);
+    while (!stop) {
+        if (!wake_at) {
+            wake.wait(lock, [this] { return stop || wake_at.has_value(); });
+            continue;
+        }
+
+        // Arm() may move the deadline or Disarm() may cancel it while we sleep
+        Clock::time_point deadline = *wake_at;
+        if (wake.wait_until(lock, deadline, [&] { return stop || wake_at != deadline; })) {
+            continue;
+        }
+
+        wake_at.reset();
+        glfwPostEmptyEvent();
+    }
+}
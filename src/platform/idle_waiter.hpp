@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// puts the main loop to sleep when nothing on the screen is going to change
+// while armed, EndDrawing() blocks until there is an input event, or until timeout passes,
+// so the window is still redrawn now and then (e.g. for the overlays)
+struct IdleWaiter {
+    static constexpr double DEFAULT_TIMEOUT = 1.0; // seconds
+
+    double timeout = DEFAULT_TIMEOUT;
+
+    IdleWaiter();
+    ~IdleWaiter();
+
+    IdleWaiter(const IdleWaiter &) = delete;
+    IdleWaiter &operator=(const IdleWaiter &) = delete;
+
+    // wait for events in the next EndDrawing()
+    void Arm();
+    // render at full rate again
+    void Disarm();
+
+    bool Armed() const {
+        return armed;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool armed = false;
+
+    // timer thread wakes the main loop up with an empty event when the timeout passes
+    std::thread timer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::optional<Clock::time_point> wake_at;
+    bool stop = false;
+
+    void TimerLoop();
+};
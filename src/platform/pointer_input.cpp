@@ -0,0 +1,125 @@
+#include "pointer_input.hpp"
+
+#include <algorithm>
+
+// raylib registers its own GLFW callbacks and keeps only the last cursor position of a frame,
+// ours is put in front of it and passes every event on
+struct GLFWwindow;
+extern "C" {
+    typedef void (*GLFWcursorposfun)(GLFWwindow *window, double x, double y);
+    GLFWcursorposfun glfwSetCursorPosCallback(GLFWwindow *window, GLFWcursorposfun callback);
+}
+
+namespace {
+
+GLFWcursorposfun raylib_cursor_callback = nullptr;
+
+void CursorPosCallback(GLFWwindow *window, double x, double y) {
+    if (raylib_cursor_callback) {
+        raylib_cursor_callback(window, x, y);
+    }
+    GetPointerInput().AddEvent({ (float) x, (float) y });
+}
+
+} // namespace
+
+void PointerInput::Install() {
+    if (installed) {
+        return;
+    }
+
+    raylib_cursor_callback = glfwSetCursorPosCallback((GLFWwindow *) GetWindowHandle(), CursorPosCallback);
+    installed = true;
+
+    pending.reserve(HISTORY_SIZE);
+    frame_samples.reserve(HISTORY_SIZE);
+}
+
+void PointerInput::AddEvent(Point position) {
+    pending.push_back(position);
+}
+
+void PointerInput::BeginFrame() {
+    double now = GetTime();
+
+    // raylib may move the pointer itself, and applies mouse offset and scale, so its position is the final one
+    Point current = GetMousePosition();
+    if (pending.empty() ? current != position : pending.back() != current) {
+        pending.push_back(current);
+    }
+
+    double span = last_frame_time < 0 ? 0 : std::min(now - last_frame_time, MAX_FRAME_SPAN);
+
+    frame_samples.clear();
+    for (size_t i = 0; i < pending.size(); ++i) {
+        double time = now - span * (double) (pending.size() - 1 - i) / (double) pending.size();
+        frame_samples.push_back({ pending[i], time });
+        AddToHistory(frame_samples.back());
+    }
+    pending.clear();
+
+    previous_position = position;
+    position          = current;
+    last_frame_time   = now;
+}
+
+void PointerInput::AddToHistory(PointerSample sample) {
+    history[nhistory % HISTORY_SIZE] = sample;
+    ++nhistory;
+}
+
+Vector2 PointerInput::Velocity() const {
+    if (nhistory < 2) {
+        return Vector2Zeros;
+    }
+
+    const PointerSample &newest = history[(nhistory - 1) % HISTORY_SIZE];
+
+    // pointer that has not moved for a while is standing still, however fast it was before
+    if (GetTime() - newest.time > VELOCITY_WINDOW) {
+        return Vector2Zeros;
+    }
+
+    // p(t) = p0 + v * t, times are taken relative to the newest sample to keep precision
+    double sum_t = 0, sum_tt = 0;
+    double sum_x = 0, sum_y = 0, sum_tx = 0, sum_ty = 0;
+    size_t n = 0;
+
+    size_t available = std::min(nhistory, HISTORY_SIZE);
+    for (size_t i = 0; i < available; ++i) {
+        const PointerSample &sample = history[(nhistory - 1 - i) % HISTORY_SIZE];
+
+        double t = sample.time - newest.time;
+        if (t < -VELOCITY_WINDOW) {
+            break;
+        }
+
+        sum_t  += t;
+        sum_tt += t * t;
+        sum_x  += sample.position.x;
+        sum_y  += sample.position.y;
+        sum_tx += t * sample.position.x;
+        sum_ty += t * sample.position.y;
+        ++n;
+    }
+
+    double denominator = (double) n * sum_tt - sum_t * sum_t;
+    if (n < 2 || denominator < 1e-12) {
+        return Vector2Zeros;
+    }
+
+    return {
+        (float) (((double) n * sum_tx - sum_t * sum_x) / denominator),
+        (float) (((double) n * sum_ty - sum_t * sum_y) / denominator),
+    };
+}
+
+Point PointerInput::Predict(double ahead) const {
+    ahead = std::clamp(ahead, 0.0, MAX_PREDICTION);
+    return position + Velocity() * (float) ahead;
+}
+
+PointerInput &GetPointerInput() {
+    static PointerInput input;
+    return input;
+}
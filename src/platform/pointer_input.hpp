@@ -0,0 +1,75 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <array>
+#include <vector>
+#include <span>
+#include <cstddef>
+
+#include "geometry/geometry.hpp"
+
+struct PointerSample {
+    Point position;
+    double time; // seconds, same clock as GetTime()
+};
+
+// every cursor position reported by the window between two frames
+// raylib keeps only the last one, so intermediate positions of a fast drag are lost when frames are long
+// drags read the coalesced position once a frame however many events there were,
+// the samples are for whoever needs the whole path and for predicting where the pointer is going
+struct PointerInput {
+    static constexpr size_t HISTORY_SIZE = 256; // samples kept across frames for velocity
+    // velocity is fitted to samples of this age, older motion says little about where the pointer is now
+    static constexpr double VELOCITY_WINDOW = 0.05;
+    // prediction is not extrapolated further than this, it overshoots on every turn anyway
+    static constexpr double MAX_PREDICTION = 0.05;
+    // events of a frame are spread over at most this much time before its end
+    static constexpr double MAX_FRAME_SPAN = 0.1;
+
+    // chain our cursor callback to the one of raylib, must be called after InitWindow()
+    // without it the pointer is sampled once a frame
+    void Install();
+
+    // called once a frame, after events are polled
+    void BeginFrame();
+
+    // samples received during the last frame, oldest first, valid until the next BeginFrame()
+    std::span<const PointerSample> FrameSamples() const {
+        return frame_samples;
+    }
+
+    Point Position() const {
+        return position;
+    }
+    // pointer moved by this much during the last frame
+    Point Delta() const {
+        return position - previous_position;
+    }
+
+    // pixels per second, least squares fit to the samples of the last VELOCITY_WINDOW seconds
+    Vector2 Velocity() const;
+    // where the pointer is expected to be `ahead` seconds after the last sample
+    Point Predict(double ahead) const;
+
+    // called from the window callback
+    void AddEvent(Point position);
+
+private:
+    // all events of a frame are delivered at once when it polls them, so they have no useful timestamps
+    // of their own: BeginFrame() spreads them evenly over the frame they happened during
+    std::vector<Point> pending;
+    std::vector<PointerSample> frame_samples;
+
+    std::array<PointerSample, HISTORY_SIZE> history {};
+    size_t nhistory = 0; // total number added, history[(nhistory - 1) % HISTORY_SIZE] is the newest
+
+    Point position          = Vector2Zeros;
+    Point previous_position = Vector2Zeros;
+    double last_frame_time  = -1;
+    bool installed          = false;
+
+    void AddToHistory(PointerSample sample);
+};
+
+PointerInput &GetPointerInput();
@@ -0,0 +1,57 @@
+#include "cpu_usage.hpp"
+
+#include <chrono>
+
+#if defined(_WIN32)
+    // raylib.h is not included here, its names clash with windows.h
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+double GetProcessCpuTime() {
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+
+    // FILETIME counts 100 ns ticks
+    auto ticks = [](FILETIME time) {
+        return ((unsigned long long) time.dwHighDateTime << 32) | time.dwLowDateTime;
+    };
+    return (double) (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    auto seconds = [](timeval time) {
+        return (double) time.tv_sec + (double) time.tv_usec * 1e-6;
+    };
+    return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+#endif
+}
+
+void CpuUsageMeter::Update() {
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    if (interval_wall_start < 0) {
+        interval_wall_start = wall;
+        interval_cpu_start  = GetProcessCpuTime();
+        return;
+    }
+
+    if (wall - interval_wall_start < INTERVAL) {
+        return;
+    }
+
+    double cpu = GetProcessCpuTime();
+    usage = (cpu - interval_cpu_start) / (wall - interval_wall_start);
+
+    interval_wall_start = wall;
+    interval_cpu_start  = cpu;
+}
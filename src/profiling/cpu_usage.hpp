@@ -0,0 +1,19 @@
+#pragma once
+
+// CPU time used by all threads of the process, in seconds
+double GetProcessCpuTime();
+
+// share of one core the process used, measured over intervals of wall time
+// 1.0 means one core was busy all the time, with several threads it can be above 1
+struct CpuUsageMeter {
+    static constexpr double INTERVAL = 1.0; // seconds
+
+    double usage = 0; // of the last finished interval
+
+    // call once a frame or more often
+    void Update();
+
+private:
+    double interval_wall_start = -1;
+    double interval_cpu_start  = 0;
+};
@@ -0,0 +1,130 @@
+#include "frame_recorder.hpp"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cmath>
+
+void DurationHistogram::Add(double duration) {
+    int bucket = 0;
+    if (duration > MIN_DURATION) {
+        bucket = (int) (std::log2(duration / MIN_DURATION) * BUCKETS_PER_OCTAVE);
+        bucket = std::clamp(bucket, 0, NBUCKETS - 1);
+    }
+
+    ++buckets[bucket];
+    ++count;
+    max  = std::max(max, duration);
+    sum += duration;
+}
+
+double DurationHistogram::Percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t rank = (size_t) std::ceil(p * (double) count);
+    rank = std::clamp<size_t>(rank, 1, count);
+
+    size_t seen = 0;
+    for (int bucket = 0; bucket < NBUCKETS; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            double upper = MIN_DURATION * std::exp2((double) (bucket + 1) / BUCKETS_PER_OCTAVE);
+            // no sample is above max, so the top percentiles are exact
+            return std::min(upper, max);
+        }
+    }
+    return max;
+}
+
+void DurationHistogram::Reset() {
+    buckets.fill(0);
+    count = 0;
+    max   = 0;
+    sum   = 0;
+}
+
+FrameRecorder::FrameRecorder(std::string name) : name(std::move(name)) {
+    history.resize(HISTORY_SIZE);
+}
+
+void FrameRecorder::Record(double time, const FrameTimes &times) {
+    Sample &sample = history[history_next];
+    sample.time  = time;
+    sample.times = times;
+    sample.missed_deadline = deadline > 0 && times.total > deadline * MISSED_DEADLINE_FACTOR;
+
+    history_next = (history_next + 1) % HISTORY_SIZE;
+
+    update.Add(times.update);
+    draw.Add(times.draw);
+    swap.Add(times.swap);
+    total.Add(times.total);
+
+    ++frames;
+    if (sample.missed_deadline) {
+        ++missed_deadlines;
+    }
+}
+
+void FrameRecorder::Reset() {
+    update.Reset();
+    draw.Reset();
+    swap.Reset();
+    total.Reset();
+
+    frames = 0;
+    missed_deadlines = 0;
+    history_next = 0;
+}
+
+const FrameRecorder::Sample &FrameRecorder::Last() const {
+    return history[(history_next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+}
+
+std::string FrameRecorder::ToCsv() const {
+    std::string csv = "frame,time,update_ms,draw_ms,swap_ms,total_ms,missed_deadline\n";
+
+    size_t nsamples = std::min(frames, HISTORY_SIZE);
+    size_t first = (history_next + HISTORY_SIZE - nsamples) % HISTORY_SIZE;
+
+    for (size_t i = 0; i < nsamples; ++i) {
+        const Sample &sample = history[(first + i) % HISTORY_SIZE];
+        csv += TextFormat("%zu,%.6f,%.4f,%.4f,%.4f,%.4f,%i\n", frames - nsamples + i, sample.time,
+                          sample.times.update * 1000, sample.times.draw * 1000,
+                          sample.times.swap * 1000, sample.times.total * 1000, (int) sample.missed_deadline);
+    }
+    return csv;
+}
+
+std::string FrameRecorder::ToJson() const {
+    std::string json = "{\n";
+    json += TextFormat("  \"scene\": \"%s\",\n  \"frames\": %zu,\n  \"missed_deadlines\": %zu,\n  \"deadline_ms\": %.4f,\n",
+                       name.c_str(), frames, missed_deadlines, deadline * 1000);
+
+    const std::pair<const char *, const DurationHistogram *> phases[] = {
+        { "update", &update }, { "draw", &draw }, { "swap", &swap }, { "total", &total }
+    };
+
+    for (size_t i = 0; i < std::size(phases); ++i) {
+        const auto &[phase, histogram] = phases[i];
+        json += TextFormat("  \"%s\": { \"avg_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f }%s\n",
+                           phase, histogram->Average() * 1000,
+                           histogram->Percentile(0.50) * 1000, histogram->Percentile(0.95) * 1000,
+                           histogram->Percentile(0.99) * 1000, histogram->max * 1000,
+                           i + 1 < std::size(phases) ? "," : "");
+    }
+
+    json += "}\n";
+    return json;
+}
+
+bool FrameRecorder::Export(const char *prefix) const {
+    std::string base = prefix;
+
+    std::string csv  = ToCsv();
+    std::string json = ToJson();
+
+    return SaveFileText((base + ".csv").c_str(), csv.data()) && SaveFileText((base + ".json").c_str(), json.data());
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// histogram of durations with logarithmic buckets, memory is fixed whatever number of samples it gets
+// every octave from MIN_DURATION is split into BUCKETS_PER_OCTAVE buckets,
+// percentiles are upper bounds of buckets, so they are never underestimated and are at most 4.4% too high
+struct DurationHistogram {
+    static constexpr double MIN_DURATION = 1e-6; // seconds, shorter durations go to the first bucket
+    static constexpr int OCTAVES = 22;           // up to ~4 seconds, longer durations go to the last bucket
+    static constexpr int BUCKETS_PER_OCTAVE = 16;
+    static constexpr int NBUCKETS = OCTAVES * BUCKETS_PER_OCTAVE;
+
+    std::array<uint32_t, NBUCKETS> buckets {};
+    size_t count = 0;
+    double max   = 0;
+    double sum   = 0;
+
+    void Add(double duration);
+    // upper bound of the bucket the p-th fraction of samples falls into, p is in [0, 1]
+    double Percentile(double p) const;
+    double Average() const {
+        return count == 0 ? 0 : sum / (double) count;
+    }
+    void Reset();
+};
+
+// durations of phases of one frame, in seconds
+struct FrameTimes {
+    double update = 0; // Scene::Update
+    double draw   = 0; // from BeginDrawing() to EndDrawing()
+    double swap   = 0; // EndDrawing(): buffer swap and waiting for the target fps
+    double total  = 0; // from the start of this frame to the start of the next one
+};
+
+// rolling statistics of frame times of one scene
+// histograms cover every frame since Reset(), the last HISTORY_SIZE frames are kept as a time series for export
+struct FrameRecorder {
+    static constexpr size_t HISTORY_SIZE = 3600;
+    // frame is late when it takes this many refresh intervals, i.e. at least one vsync was missed
+    static constexpr double MISSED_DEADLINE_FACTOR = 1.5;
+
+    struct Sample {
+        double time = 0; // GetTime() at the start of the frame
+        FrameTimes times;
+        bool missed_deadline = false;
+    };
+
+    std::string name;
+    double deadline = 0; // refresh interval in seconds, 0 if unknown
+
+    DurationHistogram update;
+    DurationHistogram draw;
+    DurationHistogram swap;
+    DurationHistogram total;
+
+    size_t frames = 0;
+    size_t missed_deadlines = 0;
+
+    explicit FrameRecorder(std::string name);
+
+    void Record(double time, const FrameTimes &times);
+    void Reset();
+
+    // time series is written oldest frame first
+    std::string ToCsv() const;
+    // percentiles of every phase
+    std::string ToJson() const;
+    // writes <prefix>.csv and <prefix>.json
+    bool Export(const char *prefix) const;
+
+    const Sample &Last() const;
+
+private:
+    std::vector<Sample> history; // ring buffer, allocated once
+    size_t history_next = 0;
+};
@@ -0,0 +1,72 @@
+#include "cached_layer.hpp"
+
+#include <algorithm>
+
+CachedLayer::CachedLayer(const char *name) : name(name) {
+    MutableRegistry().push_back(this);
+}
+
+CachedLayer::~CachedLayer() {
+    // scenes may outlive the window, texture is gone together with the context then
+    if (IsWindowReady() && IsRenderTextureValid(target)) {
+        UnloadRenderTexture(target);
+    }
+
+    auto &registry = MutableRegistry();
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+bool CachedLayer::Begin(int width, int height, Color background) {
+    if (target.texture.width != width || target.texture.height != height) {
+        if (IsRenderTextureValid(target)) {
+            UnloadRenderTexture(target);
+        }
+        target = LoadRenderTexture(width, height);
+        valid = false;
+
+        TraceLog(LOG_DEBUG, "CachedLayer: (re)created layer '%s' %ix%i", name, width, height);
+    }
+
+    if (valid) {
+        ++hits;
+        return false;
+    }
+
+    ++misses;
+
+    BeginTextureMode(target);
+    ClearBackground(background);
+    return true;
+}
+
+void CachedLayer::Release() {
+    if (IsRenderTextureValid(target)) {
+        UnloadRenderTexture(target);
+    }
+    target = {};
+    valid = false;
+}
+
+void CachedLayer::End() {
+    EndTextureMode();
+    valid = true;
+}
+
+void CachedLayer::Draw(Vector2 position) const {
+    if (!IsRenderTextureValid(target)) {
+        return;
+    }
+
+    // render textures are flipped vertically in OpenGL
+    Rectangle source = { 0, 0, (float) target.texture.width, (float) -target.texture.height };
+    DrawTextureRec(target.texture, source, position, WHITE);
+}
+
+const std::vector<CachedLayer *> &CachedLayer::Registry() {
+    return MutableRegistry();
+}
+
+std::vector<CachedLayer *> &CachedLayer::MutableRegistry() {
+    static std::vector<CachedLayer *> registry;
+    return registry;
+}
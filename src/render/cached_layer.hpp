@@ -0,0 +1,54 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <vector>
+#include <cstddef>
+
+// off-screen render texture that keeps static content between frames
+// content is redrawn only after Invalidate() (or when size of the layer changes)
+// layers are opaque: they are cleared with background color and cover everything under them
+struct CachedLayer {
+    const char *name;
+
+    RenderTexture2D target {};
+    bool valid = false;
+
+    size_t hits   = 0;
+    size_t misses = 0;
+
+    explicit CachedLayer(const char *name);
+    ~CachedLayer();
+
+    CachedLayer(const CachedLayer &) = delete;
+    CachedLayer &operator=(const CachedLayer &) = delete;
+
+    void Invalidate() {
+        valid = false;
+    }
+
+    // free the texture, it is created again by the next Begin()
+    void Release();
+    // bytes of the texture in video memory
+    size_t MemoryUsage() const {
+        return (size_t) target.texture.width * target.texture.height * 4;
+    }
+
+    // returns true if content has to be redrawn, then everything until End() is drawn into the layer
+    bool Begin(int width, int height, Color background);
+    void End();
+
+    // draw the layer to the screen with its top-left corner at position
+    void Draw(Vector2 position) const;
+
+    float HitRate() const {
+        size_t total = hits + misses;
+        return total == 0 ? 0.f : (float) hits / (float) total;
+    }
+
+    // all alive layers, used to show statistics
+    static const std::vector<CachedLayer *> &Registry();
+
+private:
+    static std::vector<CachedLayer *> &MutableRegistry();
+};
@@ -0,0 +1,95 @@
+#include "render.hpp"
+
+#include "software_rasterizer.hpp"
+
+namespace Render {
+
+namespace {
+
+SoftwareRasterizer *software_target = nullptr;
+Stroker stroker;
+
+} // namespace
+
+void SetSoftwareTarget(SoftwareRasterizer *target) {
+    software_target = target;
+}
+
+SoftwareRasterizer *GetSoftwareTarget() {
+    return software_target;
+}
+
+int GetScreenWidth() {
+    return software_target ? software_target->width : ::GetScreenWidth();
+}
+
+int GetScreenHeight() {
+    return software_target ? software_target->height : ::GetScreenHeight();
+}
+
+Stroker &GetStroker() {
+    return stroker;
+}
+
+void DrawLine(Vector2 start, Vector2 end, Color color) {
+    if (software_target) {
+        software_target->DrawLine(start, end, 1, color);
+    } else {
+        ::DrawLineV(start, end, color);
+    }
+}
+
+void DrawLineEx(Vector2 start, Vector2 end, float thick, Color color) {
+    if (software_target) {
+        software_target->DrawLine(start, end, thick, color);
+    } else {
+        ::DrawLineEx(start, end, thick, color);
+    }
+}
+
+void DrawCircle(Vector2 center, float radius, Color color) {
+    if (software_target) {
+        software_target->DrawCircle(center, radius, color);
+    } else {
+        ::DrawCircleV(center, radius, color);
+    }
+}
+
+void DrawTriangleStrip(std::span<const Vector2> points, Color color) {
+    if (software_target) {
+        for (size_t i = 2; i < points.size(); ++i) {
+            software_target->DrawTriangle(points[i - 2], points[i - 1], points[i], color);
+        }
+    } else {
+        ::DrawTriangleStrip(points.data(), (int) points.size(), color);
+    }
+}
+
+void DrawLineDotted(Vector2 start, Vector2 end, float segment_len, float thick, Color color) {
+    Vector2 points[] = { start, end };
+    DrawPolylineDotted(points, segment_len, thick, color);
+}
+
+void DrawText(const char *text, int x, int y, int font_size, Color color) {
+    if (!software_target) {
+        ::DrawText(text, x, y, font_size, color);
+    }
+}
+
+void BeginMode2D(Camera2D camera) {
+    if (software_target) {
+        software_target->camera = camera;
+    } else {
+        ::BeginMode2D(camera);
+    }
+}
+
+void EndMode2D() {
+    if (software_target) {
+        software_target->camera = Camera2D { {0, 0}, {0, 0}, 0, 1 };
+    } else {
+        ::EndMode2D();
+    }
+}
+
+} // namespace Render
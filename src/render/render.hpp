@@ -0,0 +1,87 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <span>
+
+#include "stroker.hpp"
+
+struct SoftwareRasterizer;
+
+// drawing calls of geometry and scenes go through here
+// they are drawn to the window by raylib, or recorded by a software rasterizer when one is set
+// text and gui are only drawn to the window, the software rasterizer skips them
+// a software target works without a window, so scenes can be drawn headless
+namespace Render {
+
+void SetSoftwareTarget(SoftwareRasterizer *target);
+SoftwareRasterizer *GetSoftwareTarget();
+
+inline bool IsSoftware() {
+    return GetSoftwareTarget() != nullptr;
+}
+
+// size of the software target when one is set, of the window otherwise
+int GetScreenWidth();
+int GetScreenHeight();
+
+// one pixel wide line, like DrawLineV()
+void DrawLine(Vector2 start, Vector2 end, Color color);
+void DrawLineEx(Vector2 start, Vector2 end, float thick, Color color);
+void DrawCircle(Vector2 center, float radius, Color color);
+// like raylib's DrawTriangleStrip(), triangles must go counter-clockwise on the screen
+void DrawTriangleStrip(std::span<const Vector2> points, Color color);
+// like raylib's DrawText(), does nothing with a software target
+void DrawText(const char *text, int x, int y, int font_size, Color color);
+
+// buffer of the strokes, reused by every call
+Stroker &GetStroker();
+
+// thick polyline in one triangle strip, drawn with one call
+template <typename Points>
+void DrawStroke(const Points &points, const StrokeStyle &style, Color color) {
+    Stroker &stroker = GetStroker();
+    stroker.Clear();
+    stroker.Stroke(points, style);
+    stroker.Draw(color);
+}
+
+template <typename Points>
+void DrawPolyline(const Points &points, float thick, Color color, bool closed=false) {
+    StrokeStyle style;
+    style.width = thick;
+    style.closed = closed;
+    DrawStroke(points, style, color);
+}
+
+// dashes and gaps are segment_len long and go on over the vertexes, they all are drawn with one call
+// end of an open polyline is marked when it falls into a gap
+template <typename Points>
+void DrawPolylineDotted(const Points &points, float segment_len, float thick, Color color, bool closed=false) {
+    float dashes[] = { segment_len, segment_len };
+    StrokeStyle style;
+    style.width = thick;
+    style.dashes = dashes;
+    style.closed = closed;
+
+    Stroker &stroker = GetStroker();
+    stroker.Clear();
+    stroker.Stroke(points, style);
+
+    size_t n = std::size(points);
+    if (!closed && n >= 2 && stroker.ends_in_gap) {
+        Vector2 end = points[n - 1];
+        Vector2 step = Vector2Normalize(end - points[n - 2]) * (0.05f * segment_len);
+        Vector2 mark[] = { end - step, end + step };
+        style.dashes = {};
+        stroker.Stroke(mark, style);
+    }
+    stroker.Draw(color);
+}
+
+void DrawLineDotted(Vector2 start, Vector2 end, float segment_len, float thick, Color color);
+
+void BeginMode2D(Camera2D camera);
+void EndMode2D();
+
+} // namespace Render
@@ -0,0 +1,468 @@
+#include "software_rasterizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define RASTERIZER_SSE2
+#endif
+
+#include "parallel/thread_pool.hpp"
+#include "memory/allocation_counter.hpp"
+
+namespace {
+
+// x / 255 rounded to nearest, exact for x in [0, 255 * 255]
+int Div255(int x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// src-over blending of color with coverage already multiplied in alpha
+// alpha of the result is computed as if src.a was 255, so layers stay opaque
+void Blend(Color &dst, Color src, float alpha) {
+    int a = (int) (alpha * 255.f + 0.5f);
+    if (a <= 0) {
+        return;
+    }
+    if (a >= 255) {
+        dst = Color { src.r, src.g, src.b, 255 };
+        return;
+    }
+
+    int inv = 255 - a;
+    dst.r = (unsigned char) Div255(src.r * a + dst.r * inv);
+    dst.g = (unsigned char) Div255(src.g * a + dst.g * inv);
+    dst.b = (unsigned char) Div255(src.b * a + dst.b * inv);
+    dst.a = (unsigned char) Div255(255 * a + dst.a * inv);
+}
+
+// capsule of a primitive prepared for coverage computation
+struct Capsule {
+    float ax, ay;
+    float abx, aby;
+    float inv_len_sqr; // 0 for circles, so the closest point is always a
+    float inv_aby;     // 0 for horizontal segments
+    float radius;
+};
+
+// 1 inside of the capsule, 0 outside and linear ramp of one pixel width across the border
+float Coverage(const Capsule &c, float px, float py) {
+    float dx = px - c.ax;
+    float dy = py - c.ay;
+
+    float h = std::clamp((dx * c.abx + dy * c.aby) * c.inv_len_sqr, 0.f, 1.f);
+    float qx = dx - c.abx * h;
+    float qy = dy - c.aby * h;
+
+    return std::clamp(c.radius + 0.5f - std::sqrt(qx * qx + qy * qy), 0.f, 1.f);
+}
+
+// pixels [x0, x1) of the row at py that may be covered by the capsule
+std::pair<int, int> RowSpan(const Capsule &c, float py) {
+    float outer = c.radius + 0.5f;
+
+    // part of the segment inside of the band [py - outer, py + outer] plus the radius around it
+    float t0 = 0.f;
+    float t1 = 1.f;
+    if (c.inv_aby != 0) {
+        t0 = std::clamp((py - outer - c.ay) * c.inv_aby, 0.f, 1.f);
+        t1 = std::clamp((py + outer - c.ay) * c.inv_aby, 0.f, 1.f);
+    }
+
+    float x0 = c.ax + c.abx * t0;
+    float x1 = c.ax + c.abx * t1;
+
+    return { (int) std::floor(std::min(x0, x1) - outer), (int) std::ceil(std::max(x0, x1) + outer) + 1 };
+}
+
+#ifdef RASTERIZER_SSE2
+// squared distances from 4 pixel centers px..px+3 in a row to the capsule's segment
+__m128 DistanceSqr4(const Capsule &c, float px, float py) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one  = _mm_set1_ps(1.f);
+
+    __m128 dx = _mm_sub_ps(_mm_set_ps(px + 3, px + 2, px + 1, px), _mm_set1_ps(c.ax));
+    __m128 dy = _mm_set1_ps(py - c.ay);
+
+    __m128 abx = _mm_set1_ps(c.abx);
+    __m128 aby = _mm_set1_ps(c.aby);
+
+    __m128 h = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dx, abx), _mm_mul_ps(dy, aby)), _mm_set1_ps(c.inv_len_sqr));
+    h = _mm_min_ps(_mm_max_ps(h, zero), one);
+
+    __m128 qx = _mm_sub_ps(dx, _mm_mul_ps(abx, h));
+    __m128 qy = _mm_sub_ps(dy, _mm_mul_ps(aby, h));
+    return _mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy));
+}
+
+// same as Coverage() for 4 pixels
+__m128 Coverage4(const Capsule &c, __m128 distance_sqr) {
+    __m128 coverage = _mm_sub_ps(_mm_set1_ps(c.radius + 0.5f), _mm_sqrt_ps(distance_sqr));
+    return _mm_min_ps(_mm_max_ps(coverage, _mm_setzero_ps()), _mm_set1_ps(1.f));
+}
+
+// x / 255 rounded to nearest for 8 unsigned 16-bit lanes, same as Div255()
+__m128i Div255x8(__m128i x) {
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// blend of 4 pixels with per pixel alpha in [0, 255], gives exactly the same result as Blend()
+// src holds color of the primitive with alpha 255 in 16-bit lanes: r g b 255 r g b 255
+void Blend4(Color *dst, __m128i src, __m128i alpha) {
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i pixels = _mm_loadu_si128((const __m128i *) dst);
+
+    // spread alpha of every pixel over its 4 channels
+    __m128i alpha16 = _mm_packs_epi32(alpha, alpha);           // a0 a1 a2 a3 a0 a1 a2 a3
+    alpha16 = _mm_unpacklo_epi16(alpha16, alpha16);            // a0 a0 a1 a1 a2 a2 a3 a3
+    __m128i alpha_lo = _mm_unpacklo_epi32(alpha16, alpha16);   // a0 x4, a1 x4
+    __m128i alpha_hi = _mm_unpackhi_epi32(alpha16, alpha16);   // a2 x4, a3 x4
+
+    __m128i max = _mm_set1_epi16(255);
+
+    __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+    __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+    lo = Div255x8(_mm_add_epi16(_mm_mullo_epi16(src, alpha_lo), _mm_mullo_epi16(lo, _mm_sub_epi16(max, alpha_lo))));
+    hi = Div255x8(_mm_add_epi16(_mm_mullo_epi16(src, alpha_hi), _mm_mullo_epi16(hi, _mm_sub_epi16(max, alpha_hi))));
+
+    _mm_storeu_si128((__m128i *) dst, _mm_packus_epi16(lo, hi));
+}
+#endif
+
+// distance from p to segment ab
+float SegmentDistance(Vector2 p, Vector2 a, Vector2 b) {
+    float abx = b.x - a.x;
+    float aby = b.y - a.y;
+    float len_sqr = abx * abx + aby * aby;
+
+    float dx = p.x - a.x;
+    float dy = p.y - a.y;
+    float h = len_sqr > 0 ? std::clamp((dx * abx + dy * aby) / len_sqr, 0.f, 1.f) : 0.f;
+
+    float qx = dx - abx * h;
+    float qy = dy - aby * h;
+    return std::sqrt(qx * qx + qy * qy);
+}
+
+} // namespace
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height) :
+    width(std::max(width, 0)), height(std::max(height, 0)), pixels((size_t) this->width * this->height, BLANK)
+{}
+
+void SoftwareRasterizer::Clear(Color color) {
+    // everything drawn before is covered anyway
+    primitives.clear();
+
+    clear_color = color;
+    need_clear = true;
+}
+
+void SoftwareRasterizer::DrawLine(Vector2 start, Vector2 end, float thick, Color color) {
+    AddPrimitive(Transform(start), Transform(end), thick * camera.zoom / 2, color);
+}
+
+void SoftwareRasterizer::DrawCircle(Vector2 center, float radius, Color color) {
+    Vector2 p = Transform(center);
+    AddPrimitive(p, p, radius * camera.zoom, color);
+}
+
+void SoftwareRasterizer::DrawTriangle(Vector2 a, Vector2 b, Vector2 c, Color color) {
+    if (color.a == 0) {
+        return;
+    }
+
+    ScopedMemoryTag memory_tag(MemoryTag::Render);
+    primitives.push_back(Primitive { Transform(a), Transform(b), 0, color, true, Transform(c) });
+}
+
+Vector2 SoftwareRasterizer::Transform(Vector2 p) const {
+    // same as GetWorldToScreen2D(): translate by -target, rotate, scale and translate by offset
+    float x = p.x - camera.target.x;
+    float y = p.y - camera.target.y;
+
+    if (camera.rotation != 0) {
+        float angle = camera.rotation * DEG2RAD;
+        float cos = std::cos(angle);
+        float sin = std::sin(angle);
+
+        float rx = x * cos - y * sin;
+        float ry = x * sin + y * cos;
+        x = rx;
+        y = ry;
+    }
+
+    return Vector2 { x * camera.zoom + camera.offset.x, y * camera.zoom + camera.offset.y };
+}
+
+void SoftwareRasterizer::AddPrimitive(Vector2 a, Vector2 b, float radius, Color color) {
+    if (color.a == 0 || radius <= 0) {
+        return;
+    }
+
+    ScopedMemoryTag memory_tag(MemoryTag::Render);
+    primitives.push_back(Primitive { a, b, radius, color });
+}
+
+void SoftwareRasterizer::Flush() {
+    ScopedMemoryTag memory_tag(MemoryTag::Render);
+
+    int tiles_x = TilesX();
+    int tiles_y = TilesY();
+
+    bins.resize((size_t) tiles_x * tiles_y);
+    for (auto &bin : bins) {
+        bin.clear();
+    }
+
+    const float half_tile_diagonal = TILE_SIZE * 0.70711f;
+
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        const Primitive &p = primitives[i];
+
+        float extent = p.radius + 1;
+        float min_x = std::min(p.a.x, p.b.x) - extent;
+        float min_y = std::min(p.a.y, p.b.y) - extent;
+        float max_x = std::max(p.a.x, p.b.x) + extent;
+        float max_y = std::max(p.a.y, p.b.y) + extent;
+        if (p.triangle) {
+            min_x = std::min(min_x, p.c.x - extent);
+            min_y = std::min(min_y, p.c.y - extent);
+            max_x = std::max(max_x, p.c.x + extent);
+            max_y = std::max(max_y, p.c.y + extent);
+        }
+
+        if (max_x < 0 || max_y < 0 || min_x >= (float) width || min_y >= (float) height) {
+            continue;
+        }
+
+        int tx0 = std::max((int) min_x, 0) / TILE_SIZE;
+        int ty0 = std::max((int) min_y, 0) / TILE_SIZE;
+        int tx1 = std::min((int) max_x / TILE_SIZE, tiles_x - 1);
+        int ty1 = std::min((int) max_y / TILE_SIZE, tiles_y - 1);
+
+        // triangles of strokes are small, their whole bounding box is binned
+        bool single_tile = (tx0 == tx1 && ty0 == ty1) || p.triangle;
+
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                // long diagonal lines have big bounding boxes but touch few of the tiles in them
+                if (!single_tile) {
+                    Vector2 center = { (tx + 0.5f) * TILE_SIZE, (ty + 0.5f) * TILE_SIZE };
+                    if (SegmentDistance(center, p.a, p.b) > extent + half_tile_diagonal) {
+                        continue;
+                    }
+                }
+
+                bins[(size_t) ty * tiles_x + tx].push_back((uint32_t) i);
+            }
+        }
+    }
+
+    // tiles don't overlap, so they are written without synchronization
+    GetThreadPool().ParallelFor(bins.size(), 1, [this](size_t begin, size_t end) {
+        for (size_t tile_idx = begin; tile_idx < end; ++tile_idx) {
+            RasterizeTile((int) tile_idx);
+        }
+    });
+
+    primitives.clear();
+    need_clear = false;
+}
+
+void SoftwareRasterizer::RasterizeTile(int tile_idx) {
+    int x0 = (tile_idx % TilesX()) * TILE_SIZE;
+    int y0 = (tile_idx / TilesX()) * TILE_SIZE;
+    int x1 = std::min(x0 + TILE_SIZE, width);
+    int y1 = std::min(y0 + TILE_SIZE, height);
+
+    if (need_clear) {
+        for (int y = y0; y < y1; ++y) {
+            std::fill(pixels.begin() + (size_t) y * width + x0, pixels.begin() + (size_t) y * width + x1, clear_color);
+        }
+    }
+
+    for (uint32_t idx : bins[tile_idx]) {
+        const Primitive &p = primitives[idx];
+        if (p.triangle) {
+            RasterizeTriangle(p, x0, y0, x1, y1);
+            continue;
+        }
+
+        float extent = p.radius + 1;
+        int px0 = std::max(x0, (int) std::floor(std::min(p.a.x, p.b.x) - extent));
+        int py0 = std::max(y0, (int) std::floor(std::min(p.a.y, p.b.y) - extent));
+        int px1 = std::min(x1, (int) std::ceil(std::max(p.a.x, p.b.x) + extent));
+        int py1 = std::min(y1, (int) std::ceil(std::max(p.a.y, p.b.y) + extent));
+
+        Capsule capsule;
+        capsule.ax  = p.a.x;
+        capsule.ay  = p.a.y;
+        capsule.abx = p.b.x - p.a.x;
+        capsule.aby = p.b.y - p.a.y;
+
+        float len_sqr = capsule.abx * capsule.abx + capsule.aby * capsule.aby;
+        capsule.inv_len_sqr = len_sqr > 0 ? 1.f / len_sqr : 0.f;
+        capsule.inv_aby = std::abs(capsule.aby) > 1e-6f ? 1.f / capsule.aby : 0.f;
+        capsule.radius = p.radius;
+
+        float alpha = p.color.a / 255.f;
+
+#ifdef RASTERIZER_SSE2
+        __m128i src = _mm_setr_epi16(p.color.r, p.color.g, p.color.b, 255, p.color.r, p.color.g, p.color.b, 255);
+        __m128 outer_radius_sqr = _mm_set1_ps((p.radius + 0.5f) * (p.radius + 0.5f));
+#endif
+
+        for (int y = py0; y < py1; ++y) {
+            Color *row = pixels.data() + (size_t) y * width;
+            float py = (float) y + 0.5f;
+
+            auto [row_x0, row_x1] = RowSpan(capsule, py);
+            row_x0 = std::max(px0, row_x0);
+            row_x1 = std::min(px1, row_x1);
+
+            int x = row_x0;
+#ifdef RASTERIZER_SSE2
+            // tiles start at multiples of 4, so the aligned range never leaves the tile,
+            // pixels outside of the primitive get zero coverage and are left as they are
+            x = row_x0 & ~3;
+            int simd_end = std::min((row_x1 + 3) & ~3, x1 & ~3);
+            for (; x < simd_end; x += 4) {
+                // most of the bounding box is outside of thin lines, sqrt is skipped there
+                __m128 distance_sqr = DistanceSqr4(capsule, (float) x + 0.5f, py);
+                if (_mm_movemask_ps(_mm_cmplt_ps(distance_sqr, outer_radius_sqr)) == 0) {
+                    continue;
+                }
+                __m128 coverage = Coverage4(capsule, distance_sqr);
+
+                // same rounding as in Blend(): coverage * alpha is rounded before it's scaled
+                __m128 scaled = _mm_mul_ps(_mm_mul_ps(coverage, _mm_set1_ps(alpha)), _mm_set1_ps(255.f));
+                Blend4(row + x, src, _mm_cvttps_epi32(_mm_add_ps(scaled, _mm_set1_ps(0.5f))));
+            }
+#endif
+            for (; x < row_x1; ++x) {
+                Blend(row[x], p.color, Coverage(capsule, (float) x + 0.5f, py) * alpha);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterizeTriangle(const Primitive &p, int x0, int y0, int x1, int y1) {
+    Vector2 a = p.a;
+    Vector2 b = p.b;
+    Vector2 c = p.c;
+
+    // edge functions are positive inside when the triangle goes clockwise on the screen
+    float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (area == 0) {
+        return;
+    }
+    if (area < 0) {
+        std::swap(b, c);
+    }
+
+    struct EdgeFunction {
+        float x, y;   // start of the edge
+        float dx, dy; // edge vector
+        bool top_left;
+
+        float operator()(float px, float py) const {
+            return dx * (py - y) - dy * (px - x);
+        }
+        // pixel centers exactly on the edge belong to the triangle only for top and left edges,
+        // so a center on an edge shared by two triangles is covered once
+        bool Covers(float px, float py) const {
+            float e = (*this)(px, py);
+            return e > 0 || (e == 0 && top_left);
+        }
+    };
+    auto Edge = [](Vector2 from, Vector2 to) {
+        float dx = to.x - from.x;
+        float dy = to.y - from.y;
+        // with clockwise order on the screen, top edges go right and left edges go up
+        return EdgeFunction { from.x, from.y, dx, dy, (dy == 0 && dx > 0) || dy < 0 };
+    };
+    EdgeFunction edges[] = { Edge(a, b), Edge(b, c), Edge(c, a) };
+
+    int px0 = std::max(x0, (int) std::floor(std::min({ a.x, b.x, c.x })));
+    int py0 = std::max(y0, (int) std::floor(std::min({ a.y, b.y, c.y })));
+    int px1 = std::min(x1, (int) std::ceil(std::max({ a.x, b.x, c.x })) + 1);
+    int py1 = std::min(y1, (int) std::ceil(std::max({ a.y, b.y, c.y })) + 1);
+
+    float alpha = p.color.a / 255.f;
+    for (int y = py0; y < py1; ++y) {
+        Color *row = pixels.data() + (size_t) y * width;
+        float py = (float) y + 0.5f;
+        for (int x = px0; x < px1; ++x) {
+            float px = (float) x + 0.5f;
+            if (edges[0].Covers(px, py) && edges[1].Covers(px, py) && edges[2].Covers(px, py)) {
+                Blend(row[x], p.color, alpha);
+            }
+        }
+    }
+}
+
+Image SoftwareRasterizer::GetImage() {
+    Image image {};
+    image.data    = pixels.data();
+    image.width   = width;
+    image.height  = height;
+    image.mipmaps = 1;
+    image.format  = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    return image;
+}
+
+bool SoftwareRasterizer::Export(const char *file_name) {
+    return ExportImage(GetImage(), file_name);
+}
+
+ImageDiff CompareImages(const Image &a, const Image &b, int tolerance) {
+    ImageDiff diff;
+    if (a.width != b.width || a.height != b.height) {
+        diff.size_mismatch = true;
+        return diff;
+    }
+
+    // references may be stored in any format, so convert copies of them when needed
+    Image rgba_a = a;
+    Image rgba_b = b;
+    if (a.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        rgba_a = ImageCopy(a);
+        ImageFormat(&rgba_a, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    }
+    if (b.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        rgba_b = ImageCopy(b);
+        ImageFormat(&rgba_b, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    }
+
+    const auto *pixels_a = (const unsigned char *) rgba_a.data;
+    const auto *pixels_b = (const unsigned char *) rgba_b.data;
+
+    size_t npixels = (size_t) a.width * a.height;
+    for (size_t i = 0; i < npixels; ++i) {
+        int pixel_difference = 0;
+        for (int channel = 0; channel < 4; ++channel) {
+            pixel_difference = std::max(pixel_difference, std::abs(pixels_a[i * 4 + channel] - pixels_b[i * 4 + channel]));
+        }
+
+        diff.max_difference = std::max(diff.max_difference, pixel_difference);
+        if (pixel_difference > tolerance) {
+            ++diff.differing_pixels;
+        }
+    }
+
+    if (rgba_a.data != a.data) {
+        UnloadImage(rgba_a);
+    }
+    if (rgba_b.data != b.data) {
+        UnloadImage(rgba_b);
+    }
+
+    return diff;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// CPU rasterizer of anti-aliased lines and circles, used to render scenes without GPU
+// primitives are recorded first, then Flush() bins them into tiles and rasterizes tiles in parallel
+// lines and circles are capsules (segment with radius), so lines get round caps and circle is a segment of zero length
+// triangles are not anti-aliased: pixels are covered when their centers are inside, with the top-left rule like GPU does,
+// so triangles of a strip neither overlap nor leave seams
+// inside of a tile primitives are blended in the order they were drawn, so output does not depend on threads
+struct SoftwareRasterizer {
+    static constexpr int TILE_SIZE = 64;
+
+    int width  = 0;
+    int height = 0;
+    std::vector<Color> pixels; // RGBA8, row by row, same layout as PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+
+    // transform applied to primitives when they are drawn, like BeginMode2D() does
+    Camera2D camera { {0, 0}, {0, 0}, 0, 1 };
+
+    SoftwareRasterizer(int width, int height);
+
+    // clearing is deferred to Flush() as well, so it is done in parallel with the rest
+    void Clear(Color color);
+
+    void DrawLine(Vector2 start, Vector2 end, float thick, Color color);
+    void DrawCircle(Vector2 center, float radius, Color color);
+    void DrawTriangle(Vector2 a, Vector2 b, Vector2 c, Color color);
+
+    // rasterize everything drawn since the last flush into pixels
+    void Flush();
+
+    size_t PendingPrimitives() const {
+        return primitives.size();
+    }
+
+    // image that points into pixels, it must not be unloaded
+    Image GetImage();
+    bool Export(const char *file_name);
+
+private:
+    struct Primitive {
+        Vector2 a;
+        Vector2 b;
+        float radius;
+        Color color;
+        bool triangle = false;
+        Vector2 c {}; // third vertex of a triangle
+    };
+
+    std::vector<Primitive> primitives;
+    std::vector<std::vector<uint32_t>> bins; // primitive indexes per tile, capacity is kept between flushes
+
+    Color clear_color {};
+    bool need_clear = false;
+
+    int TilesX() const {
+        return (width + TILE_SIZE - 1) / TILE_SIZE;
+    }
+    int TilesY() const {
+        return (height + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    Vector2 Transform(Vector2 p) const;
+    void AddPrimitive(Vector2 a, Vector2 b, float radius, Color color);
+    void RasterizeTile(int tile_idx);
+    void RasterizeTriangle(const Primitive &p, int x0, int y0, int x1, int y1);
+};
+
+struct ImageDiff {
+    size_t differing_pixels = 0;
+    int max_difference = 0; // largest difference of a single channel
+    bool size_mismatch = false;
+
+    bool Matches() const {
+        return !size_mismatch && differing_pixels == 0;
+    }
+};
+
+// compare two RGBA8 images, channels that differ by at most tolerance are considered equal
+ImageDiff CompareImages(const Image &a, const Image &b, int tolerance=0);
@@ -0,0 +1,350 @@
+#include "stroker.hpp"
+
+#include <numbers>
+
+#include "render.hpp"
+#include "memory/allocation_counter.hpp"
+
+namespace {
+
+// number of chords for an arc of the angle, so that they are not further than the tolerance from it
+int ArcSteps(float radius, float angle) {
+    if (radius <= Stroker::ROUND_TOLERANCE) {
+        return 1;
+    }
+    float step = 2 * std::acos(1 - Stroker::ROUND_TOLERANCE / radius);
+    return std::max(1, (int) std::ceil(angle / step));
+}
+
+Vector2 Normal(Vector2 d) {
+    return Vector2 { d.y, -d.x };
+}
+
+// inner sides of a join cross at r * tan(angle / 2) from its point along both segments
+float InnerReach(float radius, Vector2 d0, Vector2 d1) {
+    float cos = Vector2DotProduct(d0, d1);
+    float sin = d0.x * d1.y - d0.y * d1.x;
+    if (1 + cos <= 1e-4f) {
+        return INFINITY;
+    }
+    return radius * std::abs(sin) / (1 + cos);
+}
+
+} // namespace
+
+void Stroker::StrokePath(const StrokeStyle &style) {
+    ScopedMemoryTag memory_tag(MemoryTag::Render);
+
+    ends_in_gap = false;
+    bool closed = style.closed;
+    if (closed && path.size() > 1 && Vector2Equals(path.back(), path.front())) {
+        path.pop_back();
+        path_radii.pop_back();
+    }
+    if (path.size() < 3) {
+        closed = false;
+    }
+
+    if (path.empty()) {
+        return;
+    }
+    if (path.size() == 1) {
+        StrokeDot(path[0], Vector2 { 1, 0 }, path_radii[0], style);
+        return;
+    }
+
+    // odd patterns are repeated twice, so that dashes and gaps alternate
+    dash_pattern.assign(style.dashes.begin(), style.dashes.end());
+    if (dash_pattern.size() % 2 == 1) {
+        dash_pattern.insert(dash_pattern.end(), style.dashes.begin(), style.dashes.end());
+    }
+    float pattern_len = 0;
+    bool valid_pattern = true;
+    for (float len : dash_pattern) {
+        pattern_len += len;
+        valid_pattern = valid_pattern && len >= 0;
+    }
+    if (!valid_pattern || !(pattern_len > 0)) {
+        StrokePiece(path, path_radii, style, closed);
+        return;
+    }
+
+    if (closed) {
+        path.push_back(path.front());
+        path_radii.push_back(path_radii.front());
+    }
+
+    size_t dash = 0;
+    float offset = std::fmod(style.dash_offset, pattern_len);
+    if (offset < 0) {
+        offset += pattern_len;
+    }
+    while (offset > 0 && offset >= dash_pattern[dash]) {
+        offset -= dash_pattern[dash];
+        dash = (dash + 1) % dash_pattern.size();
+    }
+    float left = dash_pattern[dash] - offset; // of the current dash or gap
+    bool on = dash % 2 == 0;
+
+    auto AddDashPoint = [this](Vector2 p, float radius) {
+        if (dash_points.empty() || !Vector2Equals(dash_points.back(), p)) {
+            dash_points.push_back(p);
+            dash_radii.push_back(radius);
+        }
+    };
+    auto EndDash = [&](Vector2 direction) {
+        if (dash_points.size() == 1) {
+            StrokeDot(dash_points[0], direction, dash_radii[0], style);
+        } else if (dash_points.size() > 1) {
+            StrokePiece(dash_points, dash_radii, style, false);
+        }
+        dash_points.clear();
+        dash_radii.clear();
+    };
+
+    dash_points.clear();
+    dash_radii.clear();
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        Vector2 a = path[i];
+        Vector2 b = path[i + 1];
+        float ra = path_radii[i];
+        float rb = path_radii[i + 1];
+        float len = Vector2Distance(a, b);
+        Vector2 direction = (b - a) / len;
+
+        if (on) {
+            AddDashPoint(a, ra);
+        }
+        float t = 0;
+        while (left <= len - t) {
+            t += left;
+            Vector2 p = Vector2Lerp(a, b, t / len);
+            float radius = std::lerp(ra, rb, t / len);
+            if (on) {
+                AddDashPoint(p, radius);
+                EndDash(direction);
+            }
+            on = !on;
+            dash = (dash + 1) % dash_pattern.size();
+            left = dash_pattern[dash];
+            if (on) {
+                AddDashPoint(p, radius);
+            }
+        }
+        left -= len - t;
+        if (on) {
+            AddDashPoint(b, rb);
+        }
+    }
+    if (on) {
+        EndDash(Vector2Normalize(path.back() - path[path.size() - 2]));
+    }
+    ends_in_gap = !on;
+}
+
+void Stroker::Draw(Color color) const {
+    if (strip.size() >= 3) {
+        Render::DrawTriangleStrip(strip, color);
+    }
+}
+
+void Stroker::StrokePiece(std::span<const Vector2> points, std::span<const float> radii, const StrokeStyle &style, bool closed) {
+    size_t n = points.size();
+    size_t nsegments = closed ? n : n - 1;
+    assert(n >= 2);
+
+    directions.resize(nsegments);
+    lengths.resize(nsegments);
+    for (size_t i = 0; i < nsegments; ++i) {
+        Vector2 d = points[(i + 1) % n] - points[i];
+        lengths[i] = Vector2Length(d);
+        directions[i] = d / lengths[i];
+    }
+
+    // how far the crossing of inner sides of a join goes along its segments
+    // joins that would not fit into their segments don't use the crossing, so they don't take anything from neighbours
+    inner_reach.assign(n, 0);
+    for (size_t i = closed ? 0 : 1; i < (closed ? n : n - 1); ++i) {
+        size_t prev = (i + nsegments - 1) % nsegments;
+        float reach = InnerReach(radii[i], directions[prev], directions[i]);
+        inner_reach[i] = reach <= std::min(lengths[prev], lengths[i]) ? reach : 0;
+    }
+    auto AddJoinAt = [&](size_t i, bool last_pair_only) {
+        size_t prev = (i + nsegments - 1) % nsegments;
+        size_t next = (i + 1) % n;
+        AddJoin(points[i], radii[i],
+                directions[prev], lengths[prev] - inner_reach[(i + n - 1) % n],
+                directions[i], lengths[i] - inner_reach[next],
+                style, last_pair_only);
+    };
+
+    piece_started = false;
+
+    if (closed) {
+        // starts in the middle of the join at the first point and ends with the whole of it
+        for (size_t i = 0; i <= n; ++i) {
+            AddJoinAt(i % n, i == 0);
+        }
+        return;
+    }
+
+    AddStartCap(points[0], directions[0], radii[0], style.cap);
+    for (size_t i = 1; i + 1 < n; ++i) {
+        AddJoinAt(i, false);
+    }
+    AddEndCap(points[n - 1], directions[n - 2], radii[n - 1], style.cap);
+}
+
+void Stroker::StrokeDot(Vector2 p, Vector2 direction, float radius, const StrokeStyle &style) {
+    // like in SVG, a dash of zero length is drawn by its caps only
+    if (style.cap == LineCap::Butt) {
+        return;
+    }
+    piece_started = false;
+    AddStartCap(p, direction, radius, style.cap);
+    AddEndCap(p, direction, radius, style.cap);
+}
+
+void Stroker::AddJoin(Vector2 p, float radius, Vector2 d0, float room0, Vector2 d1, float room1,
+                      const StrokeStyle &style, bool last_pair_only)
+{
+    Vector2 n0 = Normal(d0);
+    Vector2 n1 = Normal(d1);
+    float cos = Vector2DotProduct(d0, d1);
+    float sin = d0.x * d1.y - d0.y * d1.x;
+
+    if (cos > 0 && std::abs(sin) < 1e-4f) {
+        AddPair(p + n0 * radius, p - n0 * radius);
+        return;
+    }
+
+    // the inner side of the turn is where the next segment goes
+    bool left_inner = Vector2DotProduct(d1, n0) > 0;
+    float side = left_inner ? radius : -radius;
+
+    Vector2 last_inner {}, last_outer {};
+    auto AddInnerOuter = [&](Vector2 inner, Vector2 outer) {
+        last_inner = inner;
+        last_outer = outer;
+        if (last_pair_only) {
+            return;
+        }
+        if (left_inner) {
+            AddPair(inner, outer);
+        } else {
+            AddPair(outer, inner);
+        }
+    };
+
+    // when the crossing of inner sides doesn't fit into the room left on the segments by the neighbour joins,
+    // the segments overlap at the point instead
+    Vector2 miter = (n0 + n1) * (side / (1 + cos));
+    bool inner_crossing = InnerReach(radius, d0, d1) <= std::min(room0, room1);
+    Vector2 inner = inner_crossing ? p + miter : p;
+    Vector2 outer0 = p - n0 * side;
+    Vector2 outer1 = p - n1 * side;
+    // miter is 1 / cos(angle / 2) times longer than the radius
+    bool miter_fits = style.join == LineJoin::Miter && 1 + cos > 1e-4f
+                      && 2 <= style.miter_limit * style.miter_limit * (1 + cos);
+
+    if (miter_fits && inner_crossing) {
+        // both segments end exactly at the bisector of the join
+        AddInnerOuter(inner, p - miter);
+        if (last_pair_only) {
+            last_pair_only = false;
+            AddInnerOuter(last_inner, last_outer);
+        }
+        return;
+    }
+
+    if (!inner_crossing) {
+        AddInnerOuter(p + n0 * side, outer0);
+    }
+    AddInnerOuter(inner, outer0);
+
+    switch (style.join) {
+    case LineJoin::Miter:
+        if (miter_fits) {
+            AddInnerOuter(inner, p - miter);
+        }
+        break;
+    case LineJoin::Round: {
+        float angle = std::atan2(sin, cos);
+        int steps = ArcSteps(radius, std::abs(angle));
+        for (int k = 1; k < steps; ++k) {
+            float a = angle * (float) k / (float) steps;
+            AddInnerOuter(inner, p + Vector2Rotate(n0 * -side, a));
+        }
+        break;
+    }
+    case LineJoin::Bevel:
+        break;
+    }
+
+    AddInnerOuter(inner, outer1);
+    if (!inner_crossing) {
+        AddInnerOuter(p + n1 * side, outer1);
+    }
+
+    if (last_pair_only) {
+        last_pair_only = false;
+        AddInnerOuter(last_inner, last_outer);
+    }
+}
+
+void Stroker::AddStartCap(Vector2 p, Vector2 d, float radius, LineCap cap) {
+    Vector2 n = Normal(d) * radius;
+    switch (cap) {
+    case LineCap::Butt:
+        AddPair(p + n, p - n);
+        break;
+    case LineCap::Square:
+        AddPair(p - d * radius + n, p - d * radius - n);
+        break;
+    case LineCap::Round: {
+        // the strip widens from the tip of the half circle
+        int steps = ArcSteps(radius, std::numbers::pi_v<float> / 2);
+        for (int k = 0; k <= steps; ++k) {
+            float a = std::numbers::pi_v<float> / 2 * (float) k / (float) steps;
+            Vector2 c = p - d * (radius * std::cos(a));
+            AddPair(c + n * std::sin(a), c - n * std::sin(a));
+        }
+        break;
+    }
+    }
+}
+
+void Stroker::AddEndCap(Vector2 p, Vector2 d, float radius, LineCap cap) {
+    Vector2 n = Normal(d) * radius;
+    switch (cap) {
+    case LineCap::Butt:
+        AddPair(p + n, p - n);
+        break;
+    case LineCap::Square:
+        AddPair(p + d * radius + n, p + d * radius - n);
+        break;
+    case LineCap::Round: {
+        int steps = ArcSteps(radius, std::numbers::pi_v<float> / 2);
+        for (int k = steps; k >= 0; --k) {
+            float a = std::numbers::pi_v<float> / 2 * (float) k / (float) steps;
+            Vector2 c = p + d * (radius * std::cos(a));
+            AddPair(c + n * std::sin(a), c - n * std::sin(a));
+        }
+        break;
+    }
+    }
+}
+
+void Stroker::AddPair(Vector2 left, Vector2 right) {
+    // pieces are connected by repeating the last vertex of the strip and the first one of the piece,
+    // triangles between them have no area; left vertexes stay at even indexes, so all triangles go the same way
+    if (!piece_started) {
+        if (!strip.empty()) {
+            strip.push_back(strip.back());
+            strip.push_back(left);
+        }
+        piece_started = true;
+    }
+    strip.push_back(left);
+    strip.push_back(right);
+}
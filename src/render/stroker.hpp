@@ -0,0 +1,104 @@
+#pragma once
+
+#include <raylib.h>
+#include <raymath.h>
+
+#include <vector>
+#include <span>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#include "memory/allocation_counter.hpp"
+
+enum class LineJoin {
+    Miter,
+    Round,
+    Bevel,
+};
+
+enum class LineCap {
+    Butt,   // ends at the end point
+    Square, // goes half of the width past the end point
+    Round,
+};
+
+struct StrokeStyle {
+    float width = 1;
+    // width at every point of the polyline instead of the constant one, it changes linearly along the segments
+    std::span<const float> widths;
+
+    LineJoin join = LineJoin::Miter;
+    LineCap cap = LineCap::Butt;
+    // miters longer than miter_limit * width / 2 are drawn as bevels, like in SVG
+    float miter_limit = 4;
+
+    // lengths of dashes and gaps one after another, the pattern goes on over the joins
+    // every dash gets the caps, no dashes is a solid line
+    std::span<const float> dashes;
+    float dash_offset = 0;
+
+    bool closed = false; // the last point is joined to the first one
+};
+
+// turns polylines into one triangle strip, so a stroke of any number of segments is one draw call
+// segments end at the crossing of their inner sides and the joins fill the outer side of turns,
+// so joints have neither gaps nor overdraw; several strokes and dashes are connected by degenerate triangles
+// triangles go counter-clockwise on the screen, so they are not culled
+struct Stroker {
+    // round joins and caps are polygons not further than this from their arcs
+    static constexpr float ROUND_TOLERANCE = 0.25f;
+
+    std::vector<Vector2> strip; // kept between strokes, drawing every frame doesn't allocate
+    bool ends_in_gap = false;   // of the last stroke with dashes, when it's open
+
+    void Clear() {
+        strip.clear();
+    }
+
+    // appends the stroke to the strip, points are any random access range (e.g. vertexes of a polygon)
+    template <typename Points>
+    void Stroke(const Points &points, const StrokeStyle &style) {
+        assert(style.widths.empty() || style.widths.size() == std::size(points));
+        ScopedMemoryTag memory_tag(MemoryTag::Render);
+
+        // repeated points have no direction, they are dropped
+        path.clear();
+        path_radii.clear();
+        for (size_t i = 0; i < std::size(points); ++i) {
+            Vector2 p = points[i];
+            float radius = std::abs(style.widths.empty() ? style.width : style.widths[i]) / 2;
+            if (!path.empty() && Vector2Equals(path.back(), p)) {
+                path_radii.back() = std::max(path_radii.back(), radius);
+                continue;
+            }
+            path.push_back(p);
+            path_radii.push_back(radius);
+        }
+        StrokePath(style);
+    }
+
+    void Draw(Color color) const;
+
+private:
+    std::vector<Vector2> path; // without repeated points
+    std::vector<float> path_radii;
+    std::vector<float> dash_pattern;
+    std::vector<Vector2> dash_points;
+    std::vector<float> dash_radii;
+    std::vector<Vector2> directions; // of the segments of a piece
+    std::vector<float> lengths;
+    std::vector<float> inner_reach;
+    bool piece_started = false;
+
+    void StrokePath(const StrokeStyle &style);
+    void StrokePiece(std::span<const Vector2> points, std::span<const float> radii, const StrokeStyle &style, bool closed);
+    void StrokeDot(Vector2 p, Vector2 direction, float radius, const StrokeStyle &style);
+    // room is the length of the segment left by the join at its other end
+    void AddJoin(Vector2 p, float radius, Vector2 d0, float room0, Vector2 d1, float room1,
+                 const StrokeStyle &style, bool last_pair_only);
+    void AddStartCap(Vector2 p, Vector2 d, float radius, LineCap cap);
+    void AddEndCap(Vector2 p, Vector2 d, float radius, LineCap cap);
+    // left and right are as seen looking along the stroke on the screen
+    void AddPair(Vector2 left, Vector2 right);
+};
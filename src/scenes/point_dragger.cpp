@@ -4,32 +4,44 @@
 
 #include <cassert>
 
+#include "platform/pointer_input.hpp"
+
 std::optional<size_t> PointDragger::Update() {
+    const PointerInput &input = GetPointerInput();
+
     if (dragging) {
-        if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
-            assert(idx >= 0 && "dragged point is undefined when trying to drag");
-
-            if (Point delta = GetMouseDelta(); delta != Vector2Zeros) {
-                if (camera.has_value()) {
-                    delta *= 1.f / camera.value()->zoom;
-                }
-                *points[idx] += delta;
-                return idx;
-            }
+        assert(idx >= 0 && "dragged point is undefined when trying to drag");
+
+        bool released = !IsMouseButtonDown(MOUSE_BUTTON_RIGHT);
+
+        Point pointer = input.Position();
+        Point delta   = ToWorld(pointer) - ToWorld(last_pointer);
+        last_pointer  = pointer;
+
+        std::optional<size_t> moved;
+        if (delta != Vector2Zeros) {
+            *points[idx] += delta;
+            moved = idx;
+        }
+
+        // prediction only hides latency while moving, it never gets into the geometry
+        prediction = Vector2Zeros;
+        if (predict && !released) {
+            prediction = ToWorld(input.Predict(GetFrameTime())) - ToWorld(pointer);
         }
 
-        if (IsMouseButtonUp(MOUSE_BUTTON_RIGHT)) {
+        if (released) {
             dragging = false;
             idx = -1;
         }
 
-        return std::nullopt;
+        return moved;
     }
 
     if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
         TraceLog(LOG_DEBUG, "PointDragger: MOUSE_BUTTON_RIGHT Pressed");
 
-        Point mouse_pos = GetMousePosition();
+        Point mouse_pos = input.Position();
 
         for (int i = 0; (size_t) i < points.size(); ++i) {
             Point point_pos_on_screen = *points[i];
@@ -39,6 +51,9 @@ std::optional<size_t> PointDragger::Update() {
             if (CheckCollisionPointCircle(mouse_pos, point_pos_on_screen, 10)) {
                 idx = i;
                 dragging = true;
+                // point doesn't jump to the pointer, it only moves as much as the pointer does
+                last_pointer = mouse_pos;
+                prediction   = Vector2Zeros;
 
                 TraceLog(LOG_DEBUG, "PointDragger: Captured point %i", idx);
                 break;
@@ -47,4 +62,11 @@ std::optional<size_t> PointDragger::Update() {
     }
 
     return std::nullopt;
-}
\ No newline at end of file
+}
+
+Point PointDragger::ToWorld(Point screen_pos) const {
+    if (camera.has_value()) {
+        return GetScreenToWorld2D(screen_pos, *camera.value());
+    }
+    return screen_pos;
+}
@@ -11,6 +11,10 @@ struct PointDragger {
     int idx = -1; // index of dragged point
     bool dragging = false;
 
+    // while dragging, the point is drawn where the pointer is expected to be when the frame is shown
+    // the point itself always follows the real pointer, see DrawPosition()
+    bool predict = false;
+
     std::optional<Camera2D*> camera;
 
     void Clear() {
@@ -32,5 +36,21 @@ struct PointDragger {
         }
     }
 
+    // point is moved by how much the pointer moved since the last frame, so it is moved at most once a frame
+    // however many events arrived since the last one, and points that move on their own keep moving
     std::optional<size_t> Update();
+
+    // where the point should be drawn: the dragged point is ahead of itself by the predicted pointer movement
+    Point DrawPosition(const Point &point) const {
+        if (dragging && &point == points[idx]) {
+            return point + prediction;
+        }
+        return point;
+    }
+
+private:
+    Point last_pointer = Vector2Zeros; // screen position of the pointer at the last update
+    Point prediction   = Vector2Zeros; // in world coordinates, only for drawing
+
+    Point ToWorld(Point screen_pos) const;
 };
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "point_selection.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "geometry/transform.hpp"
+#include "memory/frame_arena.hpp"
+#include "render/render.hpp"
+
+std::optional<Matrix> PointSelection::Update() {
+    Point mouse = MouseWorld();
+
+    switch (gesture) {
+    case Gesture::None:
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_LEFT_ALT))) {
+            gesture = IsKeyDown(KEY_LEFT_ALT) ? Gesture::Lasso : Gesture::Box;
+            gesture_start = mouse;
+
+            lasso.clear();
+            lasso.push_back(mouse);
+            candidates.clear();
+
+            BuildGrid();
+            TraceLog(LOG_DEBUG, "PointSelection: started %s over %zu points",
+                     gesture == Gesture::Box ? "box" : "lasso", points.size());
+        } else if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT) && !selected.empty()) {
+            // group is grabbed by any of its points, otherwise the press is left to PointDragger
+            BuildGrid();
+
+            float radius = WorldDistance(GRAB_DISTANCE);
+            bool grabbed = false;
+            grid.QueryRect(mouse - Point { radius, radius }, mouse + Point { radius, radius }, [&](uint32_t idx) {
+                if (!grabbed && Vector2Distance(*points[idx], mouse) <= radius &&
+                    std::binary_search(selected.begin(), selected.end(), idx))
+                {
+                    grabbed = true;
+                }
+            });
+
+            if (grabbed) {
+                gesture_start = mouse;
+                BeginTransform(IsKeyDown(KEY_LEFT_SHIFT)   ? Gesture::Rotate :
+                               IsKeyDown(KEY_LEFT_CONTROL) ? Gesture::Scale  : Gesture::Translate);
+            }
+        }
+        return std::nullopt;
+
+    case Gesture::Box:
+        SelectInRect(gesture_start, mouse, candidates);
+
+        if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+            selected.swap(candidates);
+            candidates.clear();
+            gesture = Gesture::None;
+
+            TraceLog(LOG_DEBUG, "PointSelection: selected %zu points", selected.size());
+        }
+        return std::nullopt;
+
+    case Gesture::Lasso:
+        if (Vector2Distance(lasso.back(), mouse) >= WorldDistance(2)) {
+            lasso.push_back(mouse);
+        }
+
+        // lasso may have thousands of edges, so points are tested only once it is closed
+        if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+            SelectInLasso(selected);
+            lasso.clear();
+            gesture = Gesture::None;
+
+            TraceLog(LOG_DEBUG, "PointSelection: selected %zu points", selected.size());
+        }
+        return std::nullopt;
+
+    case Gesture::Translate:
+    case Gesture::Rotate:
+    case Gesture::Scale: {
+        // points are always computed from where they were, so the gesture doesn't accumulate float errors
+        Matrix next  = GestureMatrix();
+        Matrix delta = MatrixMultiply(MatrixInvert(current), next);
+
+        TransformPoints(next, origin, transformed);
+        for (size_t i = 0; i < selected.size(); ++i) {
+            *points[selected[i]] = transformed[i];
+        }
+        current = next;
+
+        if (!IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
+            gesture = Gesture::None;
+        }
+        return delta;
+    }
+    }
+
+    return std::nullopt;
+}
+
+void PointSelection::Draw(Color color) const {
+    float radius = WorldDistance(4);
+    float thick  = WorldDistance(1);
+
+    const auto &highlighted = gesture == Gesture::Box ? candidates : selected;
+    for (uint32_t idx : highlighted) {
+        Render::DrawCircle(*points[idx], radius, color);
+    }
+
+    if (gesture == Gesture::Box) {
+        Point a = gesture_start;
+        Point b = MouseWorld();
+        std::array<Point, 4> corners = { a, Point { b.x, a.y }, b, Point { a.x, b.y } };
+        Render::DrawPolyline(corners, thick, color, true);
+    }
+
+    if (gesture == Gesture::Lasso) {
+        Render::DrawPolyline(lasso, thick, color);
+        if (lasso.size() > 2) {
+            Render::DrawLineDotted(lasso.back(), lasso.front(), 10 * thick, thick, color);
+        }
+    }
+}
+
+Point PointSelection::MouseWorld() const {
+    Point mouse = GetMousePosition();
+    if (camera.has_value()) {
+        return GetScreenToWorld2D(mouse, *camera.value());
+    }
+    return mouse;
+}
+
+float PointSelection::WorldDistance(float screen_distance) const {
+    if (camera.has_value()) {
+        return screen_distance / camera.value()->zoom;
+    }
+    return screen_distance;
+}
+
+void PointSelection::BuildGrid() {
+    std::pmr::vector<Point> positions(GetFrameArena().Resource());
+    positions.reserve(points.size());
+    for (Point *point : points) {
+        positions.push_back(*point);
+    }
+
+    grid.Build(positions);
+}
+
+void PointSelection::SelectInRect(Point a, Point b, std::vector<uint32_t> &out) const {
+    out.clear();
+    grid.QueryRect(Vector2Min(a, b), Vector2Max(a, b), [&](uint32_t idx) { out.push_back(idx); });
+    std::sort(out.begin(), out.end());
+}
+
+void PointSelection::SelectInLasso(std::vector<uint32_t> &out) const {
+    out.clear();
+    if (lasso.size() < 3) {
+        return;
+    }
+
+    Point min = lasso.front();
+    Point max = min;
+    for (Point p : lasso) {
+        min = Vector2Min(min, p);
+        max = Vector2Max(max, p);
+    }
+
+    // even-odd rule, the lasso is closed by the edge from its last point to the first
+    grid.QueryRect(min, max, [&](uint32_t idx) {
+        Point p = *points[idx];
+
+        bool inside = false;
+        for (size_t i = 0, j = lasso.size() - 1; i < lasso.size(); j = i++) {
+            Point a = lasso[i];
+            Point b = lasso[j];
+            if ((a.y > p.y) != (b.y > p.y) && p.x < a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y)) {
+                inside = !inside;
+            }
+        }
+
+        if (inside) {
+            out.push_back(idx);
+        }
+    });
+
+    std::sort(out.begin(), out.end());
+}
+
+void PointSelection::BeginTransform(Gesture transform) {
+    gesture = transform;
+
+    origin.resize(selected.size());
+    transformed.resize(selected.size());
+    for (size_t i = 0; i < selected.size(); ++i) {
+        origin[i] = *points[selected[i]];
+    }
+
+    // group is rotated and scaled around the center of its bounds
+    Point min = origin.front();
+    Point max = min;
+    for (Point p : origin) {
+        min = Vector2Min(min, p);
+        max = Vector2Max(max, p);
+    }
+    pivot = (min + max) / 2;
+
+    current = MatrixIdentity();
+
+    TraceLog(LOG_DEBUG, "PointSelection: transforming %zu points", selected.size());
+}
+
+Matrix PointSelection::GestureMatrix() const {
+    Point mouse = MouseWorld();
+
+    switch (gesture) {
+    case Gesture::Translate:
+        return MatrixAround(pivot, 0, 1, mouse - gesture_start);
+
+    case Gesture::Rotate: {
+        Point from = gesture_start - pivot;
+        Point to   = mouse - pivot;
+        return MatrixAround(pivot, std::atan2(to.y, to.x) - std::atan2(from.y, from.x), 1);
+    }
+
+    case Gesture::Scale: {
+        float from = Vector2Distance(gesture_start, pivot);
+        if (from < WorldDistance(1)) {
+            return MatrixIdentity();
+        }
+        float scale = std::max(Vector2Distance(mouse, pivot) / from, MIN_SCALE);
+        return MatrixAround(pivot, 0, scale);
+    }
+
+    default:
+        return MatrixIdentity();
+    }
+}
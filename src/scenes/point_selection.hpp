@@ -0,0 +1,91 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include "geometry/geometry.hpp"
+#include "geometry/point_grid.hpp"
+
+// selects groups of points and moves them together, a companion of PointDragger that works on the same points
+// Shift + left mouse button drags a rectangle, Alt + left mouse button draws a lasso,
+// right mouse button on a selected point moves the group, with Shift it rotates it and with Ctrl scales it
+struct PointSelection {
+    enum class Gesture {
+        None,
+        Box,
+        Lasso,
+        Translate,
+        Rotate,
+        Scale,
+    };
+
+    std::vector<Point *> points;
+    std::vector<uint32_t> selected; // indexes into points, sorted
+
+    Gesture gesture = Gesture::None;
+
+    std::optional<Camera2D*> camera;
+
+    static constexpr float GRAB_DISTANCE = 10.f; // in screen pixels, like PointDragger
+    static constexpr float MIN_SCALE = 0.05f;
+
+    void Clear() {
+        points.clear();
+        selected.clear();
+        gesture = Gesture::None;
+    }
+
+    void AddToSelect(Point &point) {
+        points.push_back(&point);
+    }
+    // accepts any range of Point
+    void AddToSelect(RangeOf<Point> auto &points) {
+        using std::ranges::begin;
+        using std::ranges::end;
+
+        for (auto it = begin(points), ite = end(points); it != ite; ++it) {
+            this->points.push_back(&(*it));
+        }
+    }
+
+    // scene must not handle the mouse buttons itself while it is true
+    bool Busy() const {
+        return gesture != Gesture::None;
+    }
+    bool IsTransforming() const {
+        return gesture == Gesture::Translate || gesture == Gesture::Rotate || gesture == Gesture::Scale;
+    }
+
+    // selected points are moved to their place in the current gesture
+    // returned matrix is what was applied to them since the previous frame,
+    // so things derived from the points (e.g. tessellated curves) can be moved along instead of rebuilt
+    std::optional<Matrix> Update();
+
+    // rectangle or lasso being drawn and selected points, in the coordinates of points
+    void Draw(Color color) const;
+
+private:
+    PointGrid grid; // snapshot of positions, built when a gesture starts
+
+    Point gesture_start = Vector2Zeros; // in world coordinates
+    std::vector<Point> lasso;
+    std::vector<uint32_t> candidates;   // selection that is being drawn
+
+    Point pivot = Vector2Zeros;
+    std::vector<Point> origin;          // positions of the selected points when the transform started
+    std::vector<Point> transformed;
+    Matrix current = MatrixIdentity();  // gesture transform applied to origin
+
+    Point MouseWorld() const;
+    float WorldDistance(float screen_distance) const;
+
+    void BuildGrid();
+    void SelectInRect(Point a, Point b, std::vector<uint32_t> &out) const;
+    void SelectInLasso(std::vector<uint32_t> &out) const;
+
+    void BeginTransform(Gesture transform);
+    Matrix GestureMatrix() const;
+};
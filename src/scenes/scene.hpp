@@ -1,8 +1,27 @@
 #pragma once
 
+#include <raylib.h>
+
+#include <vector>
+
+#include "memory/memory_report.hpp"
+
 struct Scene {
     virtual void Draw()           = 0;
     virtual void Update(float dt) = 0;
     virtual bool IsSwitchable() { return true; }
+    // breakdown of the memory the scene holds, shown by the memory overlay
+    virtual std::vector<MemoryUsageEntry> MemoryUsage() const { return {}; }
+    // drop what can be rebuilt (caches, tessellation, textures) while the scene is not shown,
+    // the scene brings it back by itself in the next Update()
+    virtual void ReleaseHeavyState() {}
+    // whether the next frame may differ from the last one without new input events (animation, background work),
+    // main loop sleeps until the next event while the scene is not dirty
+    virtual bool IsDirty() { return true; }
     virtual ~Scene() = default;
 };
+
+// keys that move things while they are held, they don't produce events every frame
+inline bool IsArrowKeyDown() {
+    return IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_UP) || IsKeyDown(KEY_DOWN);
+}
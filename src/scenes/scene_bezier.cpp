@@ -1,53 +1,159 @@
 #include "scene_bezier.hpp"
 
 #include "colors.h"
+#include "geometry/transform.hpp"
+#include "memory/frame_arena.hpp"
+#include "parallel/thread_pool.hpp"
+#include "platform/pointer_input.hpp"
+#include "render/render.hpp"
 
 #include <raygui.h>
 
 void SceneBezier::Draw() {
-    BeginMode2D(camera);
-
-    for (auto &set : bezier_sets) {
+    // finished sets change rarely, so they are drawn from the layer
+    if (layer_camera.offset != camera.offset || layer_camera.target != camera.target ||
+        layer_camera.rotation != camera.rotation || layer_camera.zoom != camera.zoom)
+    {
+        finished_sets_layer.Invalidate();
+        layer_camera = camera;
+    }
 
-        Color color_point = COLOR_POINT_PRIMARY;
-        Color color_curve = COLOR_LINE_PRIMARY;
-        if (&set == &bezier_sets.back() && !need_new_set) {
-            color_point = COLOR_POINT_SECONDARY;
-            color_curve = COLOR_LINE_SECONDARY;
+    if (Render::IsSoftware()) {
+        // software rasterizer has no render textures
+        Render::BeginMode2D(camera);
+        DrawFinishedSets();
+        Render::EndMode2D();
+    } else {
+        if (finished_sets_layer.Begin(GetScreenWidth(), GetScreenHeight(), COLOR_BACKGROUND)) {
+            BeginMode2D(camera);
+            DrawFinishedSets();
+            EndMode2D();
+
+            finished_sets_layer.End();
         }
+        finished_sets_layer.Draw(Vector2Zeros);
+    }
 
-        for (auto &curve : set.curves) {
-            if (show_control_points) {
-                curve.DrawControlPoints(color_point, COLOR_GRAY_FADED);
-            }
-            curve.DrawCurve(color_curve);
-        }
+    Render::BeginMode2D(camera);
+
+    if (show_triangulation) {
+        triangulation.ForEachEdge([](Point a, Point b) {
+            Render::DrawLine(a, b, COLOR_GRAY_FADED);
+        });
+    }
+
+    if (!bezier_sets.empty() && IsActiveSet(bezier_sets.size() - 1)) {
+        DrawSet(bezier_sets.back(), COLOR_POINT_SECONDARY, COLOR_LINE_SECONDARY);
+    }
+
+    if (selected.has_value()) {
+        bezier_sets[selected->set_idx].curves[selected->curve_idx].DrawCurve(COLOR_POINT_SECONDARY);
+    }
+
+    if (hovered.has_value()) {
+        Render::DrawCircle(hovered->point, 5 / camera.zoom, COLOR_POINT_SECONDARY);
     }
-    
 
     if (show_control_points) {
-        for (auto &set : bezier_sets) {
-            
-            Color color_point = &set == &bezier_sets.back() && !need_new_set ? COLOR_POINT_SECONDARY : COLOR_POINT_PRIMARY;
+        selection.Draw(COLOR_SELECTION);
+    }
 
-            for (int i = 1; (size_t) i < set.control_points.size(); ++i) {
-                DrawLineDotted(set.control_points[i - 1], set.control_points[i], 20, 3, COLOR_GRAY_FADED);
-            }
-            for (int i = 0; (size_t) i < set.control_points.size(); ++i) {
-                DrawCircleV(set.control_points[i], 7, color_point);
-            }
+    // the marker is in world coordinates, so it is not culled by the screen like animations in other scenes
+    if (marker.has_value()) {
+        marker->AnimatedPolygon().Draw(COLOR_SELECTION);
+    }
+
+    Render::EndMode2D();
+
+    Render::DrawText("Bezier Curves", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText(tessellator.async ? "Tessellation: async (T)" : "Tessellation: sync (T)",
+             20, 50, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText(dragger.predict ? "Drag prediction: on (P)" : "Drag prediction: off (P)",
+             20, 80, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText(marker.has_value() ? "Marker: on (A)" : "Marker: off (A)",
+             20, 110, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText(TextFormat("Freehand: %s (F) %s", freehand ? "on" : "off", stroke_stats.c_str()),
+             20, 140, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText(TextFormat("Delaunay: %s (G) %s", show_triangulation ? "on" : "off",
+                        show_triangulation ? triangulation_stats.c_str() : ""),
+             20, 170, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+};
+
+void SceneBezier::DrawSet(const BezierSet &set, Color color_point, Color color_curve) const {
+    for (auto &curve : set.curves) {
+        if (show_control_points) {
+            curve.DrawControlPoints(color_point, COLOR_GRAY_FADED);
         }
+        curve.DrawCurve(color_curve);
     }
 
-    EndMode2D();
+    if (show_control_points) {
+        Render::DrawPolylineDotted(set.control_points, 20, 3, COLOR_GRAY_FADED);
+        for (int i = 0; (size_t) i < set.control_points.size(); ++i) {
+            Render::DrawCircle(dragger.DrawPosition(set.control_points[i]), 7, color_point);
+        }
+    }
+}
 
-    DrawText("Bezier Curves", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
-};
+void SceneBezier::DrawFinishedSets() const {
+    for (size_t i = 0; i < bezier_sets.size(); ++i) {
+        if (!IsActiveSet(i)) {
+            DrawSet(bezier_sets[i], COLOR_POINT_PRIMARY, COLOR_LINE_PRIMARY);
+        }
+    }
+}
+
+bool SceneBezier::IsActiveSet(size_t set_idx) const {
+    return set_idx + 1 == bezier_sets.size() && !need_new_set;
+}
 
 void SceneBezier::Update(float dt) {
+    hovered.reset();
+
+    if (heavy_state_released) {
+        UpdateAllCurves();
+        heavy_state_released = false;
+    }
+
+    tessellator.Apply([this](AsyncTessellator::Key key) { return CurveOfKey(key); });
+
+    if (IsKeyDown(KEY_LEFT_CONTROL) && !dragger.dragging && !selection.Busy() && !stroke_active) {
+        if (IsKeyPressed('Y') || (IsKeyPressed('Z') && IsKeyDown(KEY_LEFT_SHIFT))) {
+            Redo();
+        } else if (IsKeyPressed('Z')) {
+            Undo();
+        }
+    }
+
     if (show_control_points) {
 
-        if (auto drag_res = dragger.Update(); drag_res.has_value()) {
+        bool was_transforming = selection.IsTransforming();
+        if (auto delta = selection.Update(); delta.has_value()) {
+            MoveSelectedCurves(delta.value());
+        }
+
+        if (!was_transforming && selection.IsTransforming()) {
+            CollectSelectionCurves();
+        } else if (was_transforming && !selection.IsTransforming()) {
+            for (const auto &[set_idx, curve_idx] : selection_partial_curves) {
+                history.MarkDirty(set_idx);
+            }
+            // curve points of whole curves took every delta of the gesture and drifted with float error,
+            // they are tessellated once from the final control points
+            for (const auto &[set_idx, curve_idx] : selection_whole_curves) {
+                history.MarkDirty(set_idx);
+                tessellator.Submit(CurveKey(set_idx, curve_idx), bezier_sets[set_idx].curves[curve_idx]);
+            }
+            CommitHistory();
+        }
+
+        // selection takes the mouse buttons while it is selecting or moving something
+        std::optional<size_t> drag_res;
+        if (!selection.Busy()) {
+            drag_res = dragger.Update();
+        }
+
+        if (drag_res.has_value()) {
             size_t global_idx = drag_res.value();
 
             int idx = (int) global_idx;
@@ -66,6 +172,15 @@ void SceneBezier::Update(float dt) {
 
             assert(set_idx != -1);
 
+            if (!IsActiveSet(set_idx)) {
+                finished_sets_layer.Invalidate();
+            }
+
+            history.MarkDirty(set_idx, idx);
+            drag_moved = true;
+            marker_trajectory_dirty = true;
+            triangulation_dirty = true;
+
             // we generally want to update two curves because they share some points
             size_t first = idx == 0
                              ? 0
@@ -85,7 +200,9 @@ void SceneBezier::Update(float dt) {
 
                 TraceLog(LOG_DEBUG, "Based on idx=%i got first %i and second %i", idx, first, second);
                 TraceLog(LOG_DEBUG, "Updating curve %i", first);
-                curves[first].SetControlPoints(std::deque<Point>(begin, begin + ELEM_CONTROL_POINTS));
+                curves[first].control_points.assign(begin, begin + ELEM_CONTROL_POINTS);
+                tessellator.Submit(CurveKey(set_idx, first), curves[first]);
+                bvh.Refit(set_idx, first);
             }
 
             if (second != -1 && (size_t) second < curves.size()) {
@@ -95,11 +212,47 @@ void SceneBezier::Update(float dt) {
                 assert((size_t) std::distance(begin, end) >= ELEM_CONTROL_POINTS);
 
                 TraceLog(LOG_DEBUG, "Updating curve %i", second);
-                curves[second].SetControlPoints(std::deque<Point>(begin, begin + ELEM_CONTROL_POINTS));
+                curves[second].control_points.assign(begin, begin + ELEM_CONTROL_POINTS);
+                tessellator.Submit(CurveKey(set_idx, second), curves[second]);
+                bvh.Refit(set_idx, second);
             }
         }
 
+        if (drag_moved && !dragger.dragging) {
+            CommitHistory();
+            drag_moved = false;
+        }
+    }
+
+    // curves are picked with the control points hidden too
+    if (bvh_dirty) {
+        RebuildBVH();
+    }
+
+    if (!dragger.dragging) {
+        Point mouse_pos = GetScreenToWorld2D(GetMousePosition(), camera);
+        hovered = bvh.Closest(mouse_pos, HOVER_DISTANCE / camera.zoom);
+    }
+
+    // middle click selects the curve under the mouse, or nothing next to curves
+    if (IsMouseButtonPressed(MOUSE_BUTTON_MIDDLE) && !stroke_active) {
+        selected = hovered;
+    }
+
+    if (selection.Busy()) {
+        // left button is used by the box or the lasso
+    } else if ((freehand && show_control_points) || stroke_active) {
+        UpdateStroke();
+    } else if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && IsKeyDown(KEY_LEFT_CONTROL) && hovered.has_value()) {
+        // Ctrl + click inserts control points into the curve
+        SplitCurve(hovered->set_idx, hovered->curve_idx, hovered->t);
+        hovered.reset();
+        CommitHistory();
+    } else if (show_control_points) {
+        // plain click always adds a control point, even next to a curve
         if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+            selected.reset();
+
             if (need_new_set) {
                 bezier_sets.emplace_back();
                 need_new_set = false;
@@ -111,13 +264,17 @@ void SceneBezier::Update(float dt) {
 
             control_points.push_back(new_point);
             dragger.AddToDrag(control_points.back());
+            selection.AddToSelect(control_points.back());
 
             if (size_t size = control_points.size(); size == ELEM_CONTROL_POINTS || (size > ELEM_CONTROL_POINTS && (size - 1) % BEZIER_ORDER == 0)) {
-                std::deque<Point> tail(control_points.end() - ELEM_CONTROL_POINTS, control_points.end());
+                std::pmr::deque<Point> tail(control_points.end() - ELEM_CONTROL_POINTS, control_points.end());
                 assert(tail.size() == ELEM_CONTROL_POINTS);
 
                 curves.push_back(BezierCurve(std::move(tail)));
+                bvh_dirty = true;
             }
+
+            CommitHistory();
         }
 
     }
@@ -154,37 +311,595 @@ void SceneBezier::Update(float dt) {
 
     if (IsKeyPressed(KEY_SPACE)) {
         show_control_points = !show_control_points;
+        finished_sets_layer.Invalidate();
     }
 
+    // L makes every set G1, with Shift C1, with Alt the curves keep going through their joints
     if (IsKeyPressed('L') && bezier_sets.size() > 0) {
-        auto &control_points = bezier_sets.back().control_points;
-        for (size_t i = BEZIER_ORDER; i + 1 < control_points.size(); i += BEZIER_ORDER) {
-            control_points[i] = Project(control_points[i], control_points[i - 1], control_points[i + 1]);
-            UpdateAllCurves();
+        SplineSmoothing smoothing;
+        smoothing.continuity  = IsKeyDown(KEY_LEFT_SHIFT) ? SplineContinuity::C1 : SplineContinuity::G1;
+        smoothing.interpolate = IsKeyDown(KEY_LEFT_ALT);
+
+        SmoothAllSets(smoothing);
+    }
+
+    if (IsKeyPressed('P')) {
+        dragger.predict = !dragger.predict;
+    }
+
+    if (IsKeyPressed('F') && !stroke_active) {
+        freehand = !freehand;
+    }
+
+    if (IsKeyPressed('A')) {
+        ToggleMarker();
+    }
+
+    if (IsKeyPressed('G')) {
+        show_triangulation = !show_triangulation;
+        triangulation_dirty = true;
+        if (!show_triangulation) {
+            triangulation.Clear();
         }
     }
 
+    if (IsKeyPressed('T')) {
+        tessellator.SetAsync(!tessellator.async, [this](AsyncTessellator::Key key) { return CurveOfKey(key); });
+    }
+
     if (IsKeyPressed(KEY_DELETE)) {
+        FinishTessellation();
+
         bezier_sets.clear();
         dragger.Clear();
+        selection.Clear();
+
+        bvh.Clear();
+        hovered.reset();
+        selected.reset();
+
+        finished_sets_layer.Invalidate();
+
+        CommitHistory();
     }
 
     if (IsKeyPressed(KEY_ENTER)) {
-        need_new_set = true;
+        // active set becomes finished
+        if (!need_new_set) {
+            finished_sets_layer.Invalidate();
+            need_new_set = true;
+            CommitHistory();
+        }
         // TODO: strip off unused control points
     }
+
+    UpdateMarker(dt);
+
+    if (show_triangulation && triangulation_dirty) {
+        UpdateTriangulation();
+    }
 };
 
+std::vector<MemoryUsageEntry> SceneBezier::MemoryUsage() const {
+    size_t control_points = 0;
+    size_t curve_points   = 0;
+
+    // control points are stored twice: in the set and in every curve
+    for (const auto &set : bezier_sets) {
+        control_points += set.control_points.size() * sizeof(Point);
+        for (const auto &curve : set.curves) {
+            control_points += curve.control_points.size() * sizeof(Point);
+            curve_points   += curve.curve_points.capacity() * sizeof(Point);
+        }
+    }
+
+    // deque blocks and maps, unused slack of blocks and BezierCurve objects themselves
+    size_t sets_total = sets_memory.BytesCurrent();
+    size_t overhead   = sets_total > control_points + curve_points ? sets_total - control_points - curve_points : 0;
+
+    return {
+        { "control points",     control_points },
+        { "curve points",       curve_points },
+        { "container overhead", overhead },
+        { "bvh",                bvh.MemoryUsage() },
+        { "undo history",       history.MemoryUsage() },
+        { "triangulation",      triangulation.MemoryUsage() },
+    };
+}
+
+void SceneBezier::ReleaseHeavyState() {
+    FinishTessellation();
+
+    // control points stay, everything else is derived from them
+    for (auto &set : bezier_sets) {
+        for (auto &curve : set.curves) {
+            curve.curve_points.clear();
+            curve.curve_points.shrink_to_fit();
+        }
+    }
+
+    bvh = BezierBVH {};
+    bvh_dirty = true;
+    hovered.reset();
+
+    finished_sets_layer.Release();
+    triangulation.Clear();
+    triangulation_dirty = true;
+
+    heavy_state_released = true;
+}
+
 void SceneBezier::UpdateAllCurves() {
-    for (auto &[curves, control_points] : bezier_sets) {
-        for (int curve_idx = 0, curve_first_control_point = 0;
-             (size_t) curve_idx < curves.size();
-             curve_first_control_point += BEZIER_ORDER, ++curve_idx)
-        {
-            std::deque<Point> chunk(control_points.begin() + curve_first_control_point,
-                                    control_points.begin() + curve_first_control_point + ELEM_CONTROL_POINTS);
+    FinishTessellation();
+
+    double start = GetTime();
+
+    ParallelForEachCurve([](BezierSet &set, size_t curve_idx) {
+        auto chunk = set.control_points.begin() + curve_idx * BEZIER_ORDER;
+        set.curves[curve_idx].SetControlPoints(chunk, chunk + ELEM_CONTROL_POINTS);
+    });
+
+    bvh.RefitAll();
+
+    TraceLog(LOG_DEBUG, "Updated all curves on %i threads in %f ms", (int) GetThreadPool().NumThreads(), (GetTime() - start) * 1000);
+}
+
+void SceneBezier::ParallelForEachCurve(const std::function<void(BezierSet &set, size_t curve_idx)> &func) {
+    struct CurveRef {
+        BezierSet *set;
+        size_t curve_idx;
+    };
 
-            curves[curve_idx].SetControlPoints(std::move(chunk));
+    // flat list of curves, so the work is split evenly however big the sets are
+    std::pmr::vector<CurveRef> curves(GetFrameArena().Resource());
+    for (auto &set : bezier_sets) {
+        for (size_t curve_idx = 0; curve_idx < set.curves.size(); ++curve_idx) {
+            curves.push_back({ &set, curve_idx });
+        }
+    }
+
+    // every curve writes only into its own buffers, so no synchronization is needed
+    GetThreadPool().ParallelFor(curves.size(), TESSELLATION_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            func(*curves[i].set, curves[i].curve_idx);
         }
+    });
+}
+
+AsyncTessellator::Key SceneBezier::CurveKey(size_t set_idx, size_t curve_idx) {
+    return (AsyncTessellator::Key) set_idx << 32 | (AsyncTessellator::Key) curve_idx;
+}
+
+BezierCurve *SceneBezier::CurveOfKey(AsyncTessellator::Key key) {
+    size_t set_idx   = (size_t) (key >> 32);
+    size_t curve_idx = (size_t) (key & 0xFFFFFFFF);
+
+    if (set_idx >= bezier_sets.size() || curve_idx >= bezier_sets[set_idx].curves.size()) {
+        return nullptr;
     }
-}
\ No newline at end of file
+
+    // layer was probably redrawn with the old curve points since the edit
+    if (!IsActiveSet(set_idx)) {
+        finished_sets_layer.Invalidate();
+    }
+
+    return &bezier_sets[set_idx].curves[curve_idx];
+}
+
+void SceneBezier::FinishTessellation() {
+    tessellator.Finish([this](AsyncTessellator::Key key) { return CurveOfKey(key); });
+}
+
+void SceneBezier::CommitHistory() {
+    history.Commit(bezier_sets,
+                   [](const BezierSet &set) -> const std::pmr::deque<Point> & { return set.control_points; },
+                   need_new_set ? HISTORY_NEED_NEW_SET : 0);
+    marker_trajectory_dirty = true;
+    triangulation_dirty = true;
+
+    TraceLog(LOG_DEBUG, "History: %zu steps, %zu bytes", history.Steps(), history.MemoryUsage());
+}
+
+void SceneBezier::Undo() {
+    // snapshots are not moved by Undo(), so the reference stays valid
+    const auto &from = history.Current();
+    if (history.Undo()) {
+        RestoreHistory(from, history.Current());
+    }
+}
+
+void SceneBezier::Redo() {
+    const auto &from = history.Current();
+    if (history.Redo()) {
+        RestoreHistory(from, history.Current());
+    }
+}
+
+void SceneBezier::RestoreHistory(const UndoHistory::Snapshot &from, const UndoHistory::Snapshot &to) {
+    double start = GetTime();
+
+    FinishTessellation();
+
+    bool structure_changed = from.sequences.size() != to.sequences.size();
+    bezier_sets.resize(to.sequences.size());
+
+    // ranges of curves which control points were changed in place
+    struct CurveRange {
+        size_t set_idx;
+        size_t begin;
+        size_t end;
+    };
+    std::pmr::vector<CurveRange> changed_curves(GetFrameArena().Resource());
+
+    UndoHistory::Diff(from, to,
+        [&](size_t set_idx, const UndoHistory::Sequence &sequence) {
+            auto &[curves, control_points] = bezier_sets[set_idx];
+
+            control_points.clear();
+            sequence.CopyPoints(std::back_inserter(control_points));
+
+            curves.clear();
+            for (size_t first = 0; first + ELEM_CONTROL_POINTS <= control_points.size(); first += BEZIER_ORDER) {
+                std::pmr::deque<Point> points(control_points.begin() + first, control_points.begin() + first + ELEM_CONTROL_POINTS);
+                curves.emplace_back(std::move(points));
+            }
+
+            structure_changed = true;
+        },
+        [&](size_t set_idx, size_t first, std::span<const Point> points) {
+            auto &[curves, control_points] = bezier_sets[set_idx];
+            std::copy(points.begin(), points.end(), control_points.begin() + first);
+
+            // curve i uses control points [i * BEZIER_ORDER, i * BEZIER_ORDER + BEZIER_ORDER]
+            size_t last = first + points.size();
+            size_t begin = first == 0 ? 0 : (first - 1) / BEZIER_ORDER;
+            size_t end   = std::min(curves.size(), (last - 1) / BEZIER_ORDER + 1);
+            if (begin < end) {
+                changed_curves.push_back({ set_idx, begin, end });
+            }
+        });
+
+    // every changed chunk is a task, so bulk edits are undone in parallel
+    GetThreadPool().ParallelFor(changed_curves.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto &[curves, control_points] = bezier_sets[changed_curves[i].set_idx];
+            for (size_t curve_idx = changed_curves[i].begin; curve_idx < changed_curves[i].end; ++curve_idx) {
+                auto chunk = control_points.begin() + curve_idx * BEZIER_ORDER;
+                curves[curve_idx].SetControlPoints(chunk, chunk + ELEM_CONTROL_POINTS);
+            }
+        }
+    });
+
+    need_new_set = (to.flags & HISTORY_NEED_NEW_SET) != 0;
+
+    if (structure_changed) {
+        ResetDragger();
+        bvh_dirty = true;
+    } else {
+        bvh.RefitAll();
+    }
+
+    hovered.reset();
+    selected.reset();
+    finished_sets_layer.Invalidate();
+    marker_trajectory_dirty = true;
+    triangulation_dirty = true;
+
+    TraceLog(LOG_DEBUG, "History: restored step in %f ms", (GetTime() - start) * 1000);
+}
+
+void SceneBezier::RebuildBVH() {
+    std::pmr::vector<BezierCurveRef> curves(GetFrameArena().Resource());
+    for (size_t set_idx = 0; set_idx < bezier_sets.size(); ++set_idx) {
+        auto &set = bezier_sets[set_idx];
+        for (size_t curve_idx = 0; curve_idx < set.curves.size(); ++curve_idx) {
+            curves.push_back({ set_idx, curve_idx, &set.curves[curve_idx] });
+        }
+    }
+
+    bvh.Build(curves);
+    bvh_dirty = false;
+
+    TraceLog(LOG_DEBUG, "Rebuilt bvh: %zu curves, %zu nodes", bvh.Size(), bvh.nodes.size());
+}
+
+void SceneBezier::ResetDragger() {
+    dragger.Clear();
+    selection.Clear();
+    for (auto &set : bezier_sets) {
+        dragger.AddToDrag(set.control_points);
+        selection.AddToSelect(set.control_points);
+    }
+}
+
+void SceneBezier::SmoothAllSets(const SplineSmoothing &smoothing) {
+    double start = GetTime();
+
+    // control points live in deques, the solver wants them contiguous
+    GetThreadPool().ParallelFor(bezier_sets.size(), 1, [&](size_t begin, size_t end) {
+        std::vector<Point> points;
+        for (size_t set_idx = begin; set_idx < end; ++set_idx) {
+            auto &control_points = bezier_sets[set_idx].control_points;
+
+            points.assign(control_points.begin(), control_points.end());
+            SmoothSpline(points, BEZIER_ORDER, smoothing);
+            std::copy(points.begin(), points.end(), control_points.begin());
+        }
+    });
+
+    TraceLog(LOG_DEBUG, "Smoothed %zu sets in %f ms", bezier_sets.size(), (GetTime() - start) * 1000);
+
+    UpdateAllCurves();
+    finished_sets_layer.Invalidate();
+
+    for (size_t set_idx = 0; set_idx < bezier_sets.size(); ++set_idx) {
+        history.MarkDirty(set_idx);
+    }
+    CommitHistory();
+}
+
+void SceneBezier::CollectSelectionCurves() {
+    // pending tessellations of the selected curves would overwrite the moved curve points
+    FinishTessellation();
+
+    // every selected control point counts for the curves it belongs to
+    std::pmr::vector<std::pair<size_t, size_t>> touched(GetFrameArena().Resource());
+
+    size_t set_idx   = 0;
+    size_t set_first = 0; // global index of the first control point of the set
+    for (uint32_t global_idx : selection.selected) {
+        while (global_idx >= set_first + bezier_sets[set_idx].control_points.size()) {
+            set_first += bezier_sets[set_idx].control_points.size();
+            ++set_idx;
+        }
+
+        size_t idx = global_idx - set_first;
+        size_t ncurves = bezier_sets[set_idx].curves.size();
+
+        // same as for a dragged point: end points of curves are shared by two of them
+        size_t first = idx == 0 ? 0 : (idx - 1) / BEZIER_ORDER;
+        if (first < ncurves) {
+            touched.emplace_back(set_idx, first);
+        }
+        if (idx != 0 && idx % BEZIER_ORDER == 0 && first + 1 < ncurves) {
+            touched.emplace_back(set_idx, first + 1);
+        }
+    }
+
+    std::sort(touched.begin(), touched.end());
+
+    selection_whole_curves.clear();
+    selection_partial_curves.clear();
+    for (size_t i = 0; i < touched.size();) {
+        size_t j = i;
+        while (j < touched.size() && touched[j] == touched[i]) {
+            ++j;
+        }
+
+        CurveIdx curve { touched[i].first, touched[i].second };
+        if (j - i == ELEM_CONTROL_POINTS) {
+            selection_whole_curves.push_back(curve);
+        } else {
+            selection_partial_curves.push_back(curve);
+        }
+        i = j;
+    }
+
+    TraceLog(LOG_DEBUG, "Selection: %zu points, %zu whole curves, %zu partial curves",
+             selection.selected.size(), selection_whole_curves.size(), selection_partial_curves.size());
+}
+
+void SceneBezier::MoveSelectedCurves(const Matrix &delta) {
+    // affine transform of control points is the same transform of the curve, so they are not retessellated
+    GetThreadPool().ParallelFor(selection_whole_curves.size(), TESSELLATION_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto &[curves, control_points] = bezier_sets[selection_whole_curves[i].set_idx];
+            size_t curve_idx = selection_whole_curves[i].curve_idx;
+
+            auto &curve = curves[curve_idx];
+            auto chunk  = control_points.begin() + curve_idx * BEZIER_ORDER;
+            std::copy(chunk, chunk + ELEM_CONTROL_POINTS, curve.control_points.begin());
+
+            TransformPoints(delta, curve.curve_points);
+        }
+    });
+
+    for (const auto &[set_idx, curve_idx] : selection_partial_curves) {
+        auto &[curves, control_points] = bezier_sets[set_idx];
+        auto chunk = control_points.begin() + curve_idx * BEZIER_ORDER;
+
+        curves[curve_idx].control_points.assign(chunk, chunk + ELEM_CONTROL_POINTS);
+        tessellator.Submit(CurveKey(set_idx, curve_idx), curves[curve_idx]);
+    }
+
+    bvh.RefitAll();
+    finished_sets_layer.Invalidate();
+    marker_trajectory_dirty = true;
+    triangulation_dirty = true;
+}
+
+void SceneBezier::UpdateStroke() {
+    static_assert(BEZIER_ORDER == 2, "the fitter makes quadratic curves");
+
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        selected.reset();
+
+        // stroke is a set of its own, the active set is finished
+        if (!need_new_set) {
+            finished_sets_layer.Invalidate();
+        }
+        bezier_sets.emplace_back();
+        need_new_set = false;
+
+        stroke_active   = true;
+        stroke_synced   = 0;
+        stroke_fit_time = 0;
+
+        // tolerance is in screen pixels, so zoomed in strokes get finer curves
+        fitter.Begin(GetScreenToWorld2D(GetMousePosition(), camera), FIT_TOLERANCE / camera.zoom);
+        SyncStrokeSet();
+        return;
+    }
+
+    if (!stroke_active) {
+        return;
+    }
+
+    bool released = !IsMouseButtonDown(MOUSE_BUTTON_LEFT);
+
+    // every event since the last frame, not just where the pointer is now, so fast strokes keep their shape
+    double start = GetTime();
+    for (const PointerSample &sample : GetPointerInput().FrameSamples()) {
+        fitter.Add(GetScreenToWorld2D(sample.position, camera));
+    }
+    if (released) {
+        fitter.End();
+    }
+    stroke_fit_time += GetTime() - start;
+
+    SyncStrokeSet();
+
+    if (!released) {
+        return;
+    }
+
+    stroke_active = false;
+    need_new_set  = true;
+    finished_sets_layer.Invalidate();
+
+    size_t nsamples = fitter.NumSamples();
+    size_t npoints  = fitter.control_points.size();
+    stroke_stats = TextFormat("last stroke: %zu samples -> %zu control points (%.1fx), %.2f us per sample",
+                              nsamples, npoints, (double) nsamples / (double) npoints, stroke_fit_time * 1e6 / (double) nsamples);
+    TraceLog(LOG_INFO, "Freehand %s", stroke_stats.c_str());
+
+    CommitHistory();
+}
+
+void SceneBezier::SyncStrokeSet() {
+    size_t set_idx = bezier_sets.size() - 1;
+    auto &[curves, control_points] = bezier_sets[set_idx];
+    const auto &points = fitter.control_points;
+
+    // the fitter only appends points and refits the ones after the stable ones
+    assert(points.size() >= control_points.size());
+
+    size_t first = std::min(stroke_synced, control_points.size());
+    for (size_t i = first; i < points.size(); ++i) {
+        if (i < control_points.size()) {
+            control_points[i] = points[i];
+        } else {
+            control_points.push_back(points[i]);
+            dragger.AddToDrag(control_points.back());
+            selection.AddToSelect(control_points.back());
+        }
+    }
+
+    size_t first_curve = first == 0 ? 0 : (first - 1) / BEZIER_ORDER;
+    size_t ncurves     = points.size() >= ELEM_CONTROL_POINTS ? (points.size() - 1) / BEZIER_ORDER : 0;
+    for (size_t curve_idx = first_curve; curve_idx < ncurves; ++curve_idx) {
+        auto chunk = control_points.begin() + curve_idx * BEZIER_ORDER;
+
+        if (curve_idx < curves.size()) {
+            curves[curve_idx].SetControlPoints(chunk, chunk + ELEM_CONTROL_POINTS);
+            bvh.Refit(set_idx, curve_idx);
+        } else {
+            std::pmr::deque<Point> curve_points(chunk, chunk + ELEM_CONTROL_POINTS);
+            curves.push_back(BezierCurve(std::move(curve_points)));
+            bvh_dirty = true;
+        }
+    }
+
+    stroke_synced = fitter.stable_points;
+    triangulation_dirty = true;
+}
+
+void SceneBezier::ToggleMarker() {
+    if (marker.has_value()) {
+        marker.reset();
+        return;
+    }
+
+    if (selected.has_value()) {
+        marker_set_idx = selected->set_idx;
+    } else if (!bezier_sets.empty()) {
+        marker_set_idx = bezier_sets.size() - 1;
+    } else {
+        return;
+    }
+
+    marker.emplace(marker_shape, SplineTrajectory(bezier_sets[marker_set_idx].curves));
+    marker->moving_speed   = 3;
+    marker->rotation_speed = 3;
+    marker_trajectory_dirty = false;
+}
+
+void SceneBezier::UpdateMarker(float dt) {
+    if (!marker.has_value()) {
+        return;
+    }
+
+    if (marker_trajectory_dirty) {
+        if (marker_set_idx >= bezier_sets.size()) {
+            marker.reset();
+            return;
+        }
+
+        // distance is kept, so the marker goes on from about the same place of the edited set
+        marker->trajectory = SplineTrajectory(bezier_sets[marker_set_idx].curves);
+        marker_trajectory_dirty = false;
+    }
+
+    marker->Update(dt);
+}
+
+void SceneBezier::SplitCurve(size_t set_idx, size_t curve_idx, float t) {
+    // keys of the curves after the split one are about to change
+    FinishTessellation();
+
+    auto &[curves, control_points] = bezier_sets[set_idx];
+    assert(curve_idx < curves.size());
+
+    auto [left, right] = SplitBezier(curves[curve_idx].control_points, t, GetFrameArena().Resource());
+    assert(left.size() == ELEM_CONTROL_POINTS && right.size() == ELEM_CONTROL_POINTS);
+
+    // left and right curves share the point at t
+    std::pmr::vector<Point> replacement(left.begin(), left.end(), GetFrameArena().Resource());
+    replacement.insert(replacement.end(), right.begin() + 1, right.end());
+
+    auto begin = control_points.begin() + curve_idx * BEZIER_ORDER;
+    begin = control_points.erase(begin, begin + ELEM_CONTROL_POINTS);
+    control_points.insert(begin, replacement.begin(), replacement.end());
+
+    // curves are copied out of the arena into the memory of the set
+    curves[curve_idx].SetControlPoints(left.begin(), left.end());
+    curves.emplace(curves.begin() + curve_idx + 1, right);
+
+    TraceLog(LOG_DEBUG, "Split curve %zu of set %zu at t=%f", curve_idx, set_idx, t);
+
+    if (!IsActiveSet(set_idx)) {
+        finished_sets_layer.Invalidate();
+    }
+
+    // inserting in the middle of deques invalidates all the references to points and curves
+    ResetDragger();
+    bvh_dirty = true;
+    selected.reset();
+}
+
+void SceneBezier::UpdateTriangulation() {
+    std::pmr::vector<Point> points(GetFrameArena().Resource());
+    for (const auto &set : bezier_sets) {
+        points.insert(points.end(), set.control_points.begin(), set.control_points.end());
+    }
+
+    // a dragged control point is one removal and one insertion
+    size_t rebuilds = triangulation.rebuilds;
+    double start = GetTime();
+    triangulation.Sync(points);
+    double time = GetTime() - start;
+
+    triangulation_stats = TextFormat("%zu points, %zu triangles, %s in %.3f ms", points.size(), triangulation.NumTriangles(),
+                                     triangulation.rebuilds != rebuilds ? "rebuilt" : "updated", time * 1000);
+    triangulation_dirty = false;
+}
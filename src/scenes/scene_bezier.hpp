@@ -4,41 +4,189 @@
 
 #include <vector>
 #include <deque>
+#include <optional>
+#include <memory_resource>
+#include <functional>
+#include <string>
 
 #include <cassert>
 
 #include "geometry/geometry.hpp"
 #include "geometry/bezier.hpp"
+#include "geometry/bezier_bvh.hpp"
+#include "geometry/curve_fitter.hpp"
+#include "geometry/delaunay.hpp"
+#include "geometry/polygon_animation.hpp"
+#include "geometry/spline_smoothing.hpp"
 #include "scenes/point_dragger.hpp"
+#include "scenes/point_selection.hpp"
 #include "scenes/scene.hpp"
+#include "render/cached_layer.hpp"
+#include "parallel/async_tessellator.hpp"
+#include "history/undo_history.hpp"
+#include "memory/counting_resource.hpp"
 
 struct SceneBezier : Scene {
     struct BezierSet {
-        std::deque<BezierCurve> curves;
-        std::deque<Point> control_points;
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        std::pmr::deque<BezierCurve> curves;
+        std::pmr::deque<Point> control_points;
+
+        BezierSet() = default;
+        explicit BezierSet(const allocator_type &alloc) : curves(alloc), control_points(alloc) {}
+
+        BezierSet(const BezierSet &) = default;
+        BezierSet(BezierSet &&) = default;
+        BezierSet(const BezierSet &other, const allocator_type &alloc) :
+            curves(other.curves, alloc), control_points(other.control_points, alloc)
+        {}
+        BezierSet(BezierSet &&other, const allocator_type &alloc) :
+            curves(std::move(other.curves), alloc), control_points(std::move(other.control_points), alloc)
+        {}
+
+        BezierSet &operator=(const BezierSet &) = default;
+        BezierSet &operator=(BezierSet &&) = default;
     };
 
-    std::deque<BezierSet> bezier_sets;
+    // everything the sets allocate goes through it, so their memory is known exactly
+    CountingResource sets_memory { "bezier sets" };
+    std::pmr::deque<BezierSet> bezier_sets { &sets_memory };
 
     PointDragger dragger;
 
+    // works on the same points as the dragger, with global indexes of control points
+    PointSelection selection;
+    struct CurveIdx {
+        size_t set_idx;
+        size_t curve_idx;
+    };
+    // curves touched by the selection, found when its transform starts
+    std::vector<CurveIdx> selection_whole_curves;   // all control points are selected, curve points move along, retessellated at the end
+    std::vector<CurveIdx> selection_partial_curves; // retessellated
+
+    // used to find curves under the mouse
+    BezierBVH bvh;
+    bool bvh_dirty = true; // set when curves are added or removed, edits only refit the bvh
+
+    std::optional<BezierHit> hovered;
+    std::optional<BezierHit> selected;
+
     Camera2D camera {};
 
+    // every set except the active one is drawn into the layer
+    CachedLayer finished_sets_layer { "finished bezier sets" };
+    Camera2D layer_camera {}; // camera the layer was drawn with
+
     bool show_control_points = true;
     bool need_new_set = true;
+    bool heavy_state_released = false; // curve points and bvh are rebuilt by the next Update()
 
     static constexpr size_t BEZIER_ORDER = 2;
     static constexpr size_t ELEM_CONTROL_POINTS = BEZIER_ORDER + 1;
 
     static_assert(BEZIER_ORDER > 0);
 
+    // how close (in screen pixels) mouse should be to a curve to hover it
+    static constexpr float HOVER_DISTANCE = 10.f;
+
+    // curves per task of the bulk tessellation
+    static constexpr size_t TESSELLATION_GRAIN = 64;
+
+    // dragged curves are retessellated on the background thread
+    AsyncTessellator tessellator { "bezier sets", &sets_memory };
+
+    // control points of every set, one step per finished edit
+    UndoHistory history;
+    bool drag_moved = false; // drag is committed to the history when it ends
+    static constexpr uint32_t HISTORY_NEED_NEW_SET = 1;
+
+    // triangle that runs along a set at constant speed, shows the spline trajectories of PolygonAnimation
+    Polygon marker_shape;
+    std::optional<PolygonAnimation> marker;
+    size_t marker_set_idx = 0;
+    bool marker_trajectory_dirty = false; // set whenever control points change, the trajectory is a copy of them
+
+    // in freehand mode left mouse button draws a stroke, it is fitted into a new set while it is drawn
+    bool freehand = false;
+    bool stroke_active = false;
+    StreamingCurveFitter fitter;
+    size_t stroke_synced = 0;   // control points of the stroke set that the fitter won't change anymore
+    double stroke_fit_time = 0; // seconds spent in the fitter during the stroke
+    std::string stroke_stats;   // of the last stroke
+    // max distance from the pointer path to the curves, in screen pixels
+    static constexpr float FIT_TOLERANCE = 2.f;
+
+    // of the control points of all sets, a dragged point is moved in it instead of triangulating everything again
+    DelaunayTriangulation triangulation;
+    bool show_triangulation = false;
+    bool triangulation_dirty = true; // set whenever control points change, like marker_trajectory_dirty
+    std::string triangulation_stats;
+
     SceneBezier() {
         camera.zoom = 1;
         dragger.camera = &camera;
+        selection.camera = &camera;
+
+        marker_shape.AddPoint({ 12, 0 });
+        marker_shape.AddPoint({ -8, -8 });
+        marker_shape.AddPoint({ -8, 8 });
+
+        CommitHistory();
     }
 
     void Draw() override;
     void Update(float dt) override;
+    std::vector<MemoryUsageEntry> MemoryUsage() const override;
+    void ReleaseHeavyState() override;
+    bool IsDirty() override {
+        // predicted position of a dragged point changes even when no events come
+        return tessellator.IsBusy() || IsArrowKeyDown() || (dragger.predict && dragger.dragging) || marker.has_value();
+    }
+
+    void DrawSet(const BezierSet &set, Color color_point, Color color_curve) const;
+    void DrawFinishedSets() const;
+    // active set is the last one until ENTER is pressed, it is drawn with secondary colors
+    bool IsActiveSet(size_t set_idx) const;
 
+    // copy control points of sets into their curves and retessellate them, in parallel
     void UpdateAllCurves();
+    // func runs for every curve of every set on the thread pool, in grains of TESSELLATION_GRAIN curves
+    void ParallelForEachCurve(const std::function<void(BezierSet &set, size_t curve_idx)> &func);
+
+    static AsyncTessellator::Key CurveKey(size_t set_idx, size_t curve_idx);
+    // curve that is about to get new curve points from the tessellator
+    BezierCurve *CurveOfKey(AsyncTessellator::Key key);
+    // apply every pending tessellation, must be called before curves are added, removed or retessellated
+    void FinishTessellation();
+
+    void CommitHistory();
+    void Undo();
+    void Redo();
+    // bring sets to the state of `to`, only what differs from `from` is copied and retessellated
+    void RestoreHistory(const UndoHistory::Snapshot &from, const UndoHistory::Snapshot &to);
+
+    void RebuildBVH();
+    // selection is reset too, it uses the same points
+    void ResetDragger();
+
+    // every set is smoothed on its own thread, then all curves are retessellated
+    void SmoothAllSets(const SplineSmoothing &smoothing);
+
+    void CollectSelectionCurves();
+    // selected control points are already moved, delta is applied to curves that are selected entirely
+    void MoveSelectedCurves(const Matrix &delta);
+    // feed pointer samples of the frame to the fitter, the stroke becomes a finished set when the button is released
+    void UpdateStroke();
+    // copy what the fitter changed into the last set
+    void SyncStrokeSet();
+
+    // marker is put on the selected set or on the last one, or is taken away
+    void ToggleMarker();
+    // trajectory is rebuilt after edits, marker is removed if its set is gone
+    void UpdateMarker(float dt);
+    // split curve at t into two curves, so the set gets BEZIER_ORDER new control points
+    void SplitCurve(size_t set_idx, size_t curve_idx, float t);
+    // triangulation takes the control points as they are now, only called when they have changed
+    void UpdateTriangulation();
 };
\ No newline at end of file
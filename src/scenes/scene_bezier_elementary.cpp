@@ -1,24 +1,25 @@
 #include "scene_bezier_elementary.hpp"
 
 #include "colors.h"
+#include "render/render.hpp"
 
-std::deque<Point> SceneBezierElementary::GenerateRandomControlPoints(int npoints) {
+std::pmr::deque<Point> SceneBezierElementary::GenerateRandomControlPoints(int npoints) {
     if (npoints <= 0) {
         return {};
     }
 
-    std::deque<Point> res;
+    std::pmr::deque<Point> res;
     int screen_segment_width = (int) input_box_panel.panel.x / npoints;
     for (int i = 0; i < npoints; ++i) {
         res.push_back(GetRandomPoint(screen_segment_width * i, screen_segment_width * (i + 1),
-                                     0,                        GetScreenHeight()));
+                                     0,                        Render::GetScreenHeight()));
     }
     
     return res;
 }
 
 SceneBezierElementary::SceneBezierElementary() :
-    input_box_panel(Rectangle{GetScreenWidth() - 400.f, 40, 360, GetScreenHeight() - 80.f})
+    input_box_panel(Rectangle{Render::GetScreenWidth() - 400.f, 40, 360, Render::GetScreenHeight() - 80.f})
 {
     bezier_curve.control_points = GenerateRandomControlPoints(order + 1);
     bezier_curve.Update();
@@ -32,6 +33,9 @@ SceneBezierElementary::SceneBezierElementary() :
                 return;
             }
 
+            // pending result of the old curve must not overwrite the new one
+            tessellator.Finish([this](AsyncTessellator::Key key) { return CurveOfKey(key); });
+
             bezier_curve.control_points = GenerateRandomControlPoints(order + 1);
             bezier_curve.Update();
 
@@ -46,15 +50,29 @@ void SceneBezierElementary::Draw() {
 
     input_box_panel.Draw();
 
-    DrawText("Elementary Bezier Curve", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText("Elementary Bezier Curve", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText(tessellator.async ? "Tessellation: async (T)" : "Tessellation: sync (T)",
+             20, 50, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
 }
 
 void SceneBezierElementary::Update(float) {
+    auto curve_of = [this](AsyncTessellator::Key key) { return CurveOfKey(key); };
+
+    tessellator.Apply(curve_of);
+
     if (dragger.Update()) {
-        bezier_curve.Update();
+        tessellator.Submit(0, bezier_curve);
+    }
+
+    if (IsKeyPressed('T') && IsSwitchable()) {
+        tessellator.SetAsync(!tessellator.async, curve_of);
     }
 }
 
 bool SceneBezierElementary::IsSwitchable() {
     return !input_box_panel.input_boxes[0].editmode;
+}
+
+BezierCurve *SceneBezierElementary::CurveOfKey(AsyncTessellator::Key key) {
+    return key == 0 ? &bezier_curve : nullptr;
 }
\ No newline at end of file
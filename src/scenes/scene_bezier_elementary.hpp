@@ -8,6 +8,7 @@
 #include "scenes/point_dragger.hpp"
 #include "scenes/scene.hpp"
 #include "gui/gui.hpp"
+#include "parallel/async_tessellator.hpp"
 
 
 struct SceneBezierElementary : Scene {
@@ -16,18 +17,30 @@ struct SceneBezierElementary : Scene {
 
     int order = 3;  // order variable that is modified by input_box
 
-    static const int MAX_ORDER = 10;
+    static const int MAX_ORDER = (int) MAX_STATIC_BEZIER_ORDER;
 
     // panel to cntrol order
     GUI::InputBoxPanel input_box_panel;
 
     PointDragger dragger;
 
+    // curve is retessellated on the background thread while its points are dragged
+    AsyncTessellator tessellator { "elementary bezier" };
+
     SceneBezierElementary();
 
-    std::deque<Point> GenerateRandomControlPoints(int npoints);
+    std::pmr::deque<Point> GenerateRandomControlPoints(int npoints);
 
     void Draw() override;
     void Update(float) override;
     bool IsSwitchable() override;
+    void ReleaseHeavyState() override {
+        input_box_panel.layer.Release();
+    }
+    // cursor of the edited input box blinks
+    bool IsDirty() override {
+        return tessellator.IsBusy() || !IsSwitchable();
+    }
+
+    BezierCurve *CurveOfKey(AsyncTessellator::Key key);
 };
\ No newline at end of file
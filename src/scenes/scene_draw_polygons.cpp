@@ -1,8 +1,16 @@
 #include "scene_draw_polygons.hpp"
 
 #include <cassert>
+#include <iterator>
+#include <tuple>
+#include <optional>
 
 #include "colors.h"
+#include "memory/allocation_counter.hpp"
+#include "memory/frame_arena.hpp"
+#include "parallel/thread_pool.hpp"
+#include "platform/pointer_input.hpp"
+#include "render/render.hpp"
 
 bool SceneDrawPolygons::IsSwitchable() {
     for (auto &input_box : input_box_panel.input_boxes) {
@@ -14,28 +22,60 @@ bool SceneDrawPolygons::IsSwitchable() {
 }
 
 void SceneDrawPolygons::Draw() {
+    if (show_triangulation) {
+        triangulation.ForEachEdge([](Point a, Point b) {
+            Render::DrawLine(a, b, COLOR_GRAY_FADED);
+        });
+    }
+    if (show_hulls) {
+        for (auto &animation : animations) {
+            if (!animation.IsOnScreen()) {
+                continue;
+            }
+            Render::DrawPolylineDotted(animation.AnimatedHull().vertexes, 6, 1, COLOR_SELECTION, true);
+        }
+    }
+
     for (int i = 0; (size_t) i < animations.size(); ++i) {
-        animations[i].animated_polygon.Draw(COLOR_LINE_PRIMARY, COLOR_POINT_PRIMARY);
+        animations[i].Draw(COLOR_LINE_PRIMARY, COLOR_POINT_PRIMARY);
         if (i != 0) {
-            animations[i].animated_polygon.DrawCenter(COLOR_POINT_PRIMARY);
+            animations[i].DrawCenter(COLOR_POINT_PRIMARY);
         }
     }
 
+    selection.Draw(COLOR_SELECTION);
+
     drawn_polygon.Draw(COLOR_LINE_SECONDARY, COLOR_POINT_SECONDARY);
     input_box_panel.Draw();
     toggle_draw_polygon.Draw();
 
     if (paused) {
-        DrawText("paused", 20, 45, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+        Render::DrawText("paused", 20, 45, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    }
+    if (!operation_stats.empty()) {
+        Render::DrawText(operation_stats.c_str(), 20, 70, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    }
+    if (show_triangulation) {
+        Render::DrawText(triangulation_stats.c_str(), 20, 95, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
     }
 
-    DrawText("Draw Polygons!", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText("Draw Polygons!", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
 }
 
 void SceneDrawPolygons::Update(float dt) {
     if (IsKeyPressed(KEY_SPACE)) {
         paused = !paused;
     }
+    if (IsKeyPressed('H')) {
+        show_hulls = !show_hulls;
+    }
+    if (IsKeyPressed('G')) {
+        show_triangulation = !show_triangulation;
+        triangulation_dirty = true;
+        if (!show_triangulation) {
+            triangulation.Clear();
+        }
+    }
 
     if (IsKeyDown(KEY_LEFT_CONTROL)) {
         if (IsKeyPressed('R')) {
@@ -46,6 +86,7 @@ void SceneDrawPolygons::Update(float dt) {
                     animation.Update(0);
                 }
             }
+            triangulation_dirty = true;
 
             input_box_panel.Reset();
         }
@@ -59,51 +100,87 @@ void SceneDrawPolygons::Update(float dt) {
                     animation.Update(0);
                 }
             }
+            triangulation_dirty = true;
         }
     }
 
     if (toggle_draw_polygon.active) {
 
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-            Point mouse_pos = GetMousePosition();
+        Point mouse_pos = GetMousePosition();
 
-            if (!CheckCollisionPointRec(mouse_pos, input_box_panel.panel)) {
-                drawn_polygon.AddPoint(mouse_pos);
+        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && !selection.Busy() && !CheckCollisionPointRec(mouse_pos, input_box_panel.panel)) {
+            if (drawn_polygon.NumPoints() == 0) {
+                drawn_simplifier.Begin(SIMPLIFY_TOLERANCE);
             }
+            drawn_simplifier.Add(mouse_pos);
+            drawn_simplifier.KeepLast();
+            drawing_stroke = true;
+        } else if (drawing_stroke) {
+            // holding the button traces every position of the mouse
+            for (const PointerSample &sample : GetPointerInput().FrameSamples()) {
+                drawn_simplifier.Add(sample.position);
+            }
+            if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT)) {
+                drawn_simplifier.KeepLast();
+                drawing_stroke = false;
+            }
+        }
+
+        if (!drawn_simplifier.points.empty()) {
+            drawn_polygon.vertexes.assign(drawn_simplifier.points.begin(), drawn_simplifier.points.end());
         }
 
     } else {
+        drawing_stroke = false;
 
         if (drawn_polygon.NumPoints() != 0) {
             polygons.push_back(std::move(drawn_polygon));
 
             // we can't use after move without this
             drawn_polygon = Polygon{};
+            drawn_simplifier.Begin(SIMPLIFY_TOLERANCE);
 
-            if (animations.size() == 0) {
-                animations.emplace_back(polygons.back());
-                dragger.AddToDrag(animations.back().animated_polygon.vertexes);
+            AddAnimation(polygons.back());
+            CommitHistory();
 
-                input_box_panel.Add(&animations[0].rotation_speed, "Rotation Speed 1");
-            } else {
-                // move the original polygon to where it started the animation
-                // so resetting the animation puts it in the right place
-                polygons.back().SetCenter(animations.back().animated_polygon.GetPoint(0));
+            assert(drawn_polygon.NumPoints() == 0);
+        }
+    }
 
-                animations.emplace_back(polygons.back(), animations.back().animated_polygon);
-                dragger.AddToDrag(animations.back().animated_polygon.vertexes);
+    if (paused) {
+        // vertexes of polygons that were off the screen may be stale
+        for (auto &animation : animations) {
+            animation.AnimatedPolygon();
+        }
 
-                auto polygon_ordinal = std::to_string(animations.size());
-                input_box_panel.Add(&animations.back().moving_speed, "Moving Speed " + polygon_ordinal);
-                input_box_panel.Add(&animations.back().rotation_speed, "Rotation Speed " + polygon_ordinal);
+        if (selection.Update()) {
+            UpdateSelectedAnimations();
+            triangulation_dirty = true;
+        }
+        if (!selection.Busy()) {
+            if (auto drag_res = dragger.Update(); drag_res.has_value()) {
+                animations[AnimationOfVertex(drag_res.value())].ApplyEdits();
+                triangulation_dirty = true;
             }
-
-            assert(drawn_polygon.NumPoints() == 0);
         }
     }
 
-    if (paused) {
-        dragger.Update();
+    // S simplifies with Douglas-Peucker, Shift + S with Visvalingam-Whyatt
+    if (IsKeyPressed('S') && IsSwitchable() && !toggle_draw_polygon.active && !dragger.dragging && !selection.Busy()) {
+        SimplifyAll(IsKeyDown(KEY_LEFT_SHIFT) ? SimplifyMethod::VisvalingamWhyatt : SimplifyMethod::DouglasPeucker);
+    }
+
+    // U, I, D and X combine the last two polygons
+    if (IsSwitchable() && !toggle_draw_polygon.active && !dragger.dragging && !selection.Busy() && animations.size() >= 2) {
+        if (IsKeyPressed('U')) {
+            CombineLastPolygons(BooleanOperation::Union);
+        } else if (IsKeyPressed('I')) {
+            CombineLastPolygons(BooleanOperation::Intersection);
+        } else if (IsKeyPressed('D')) {
+            CombineLastPolygons(BooleanOperation::Difference);
+        } else if (IsKeyPressed('X')) {
+            CombineLastPolygons(BooleanOperation::Xor);
+        }
     }
 
     if (IsKeyPressed(KEY_DELETE)) {
@@ -111,6 +188,17 @@ void SceneDrawPolygons::Update(float dt) {
         animations.clear();
         input_box_panel.input_boxes.clear();
         dragger.Clear();
+        selection.Clear();
+
+        CommitHistory();
+    }
+
+    if (IsKeyDown(KEY_LEFT_CONTROL) && !dragger.dragging && !selection.Busy()) {
+        if (IsKeyPressed('Y') || (IsKeyPressed('Z') && IsKeyDown(KEY_LEFT_SHIFT))) {
+            Redo();
+        } else if (IsKeyPressed('Z')) {
+            Undo();
+        }
     }
 
     Point shift = Vector2Zeros;
@@ -130,18 +218,275 @@ void SceneDrawPolygons::Update(float dt) {
 
     if (shift != Vector2Zeros) {
         for (auto &animation : animations) {
-            animation.animated_polygon.Shift(shift);
+            animation.Shift(shift);
             if (animation.trajectory.IsPoint()) {
                 animation.trajectory.GetPoint() += shift;
             }
         }
 
         drawn_polygon.Shift(shift);
+        drawn_simplifier.Shift(shift);
+        triangulation_dirty = true;
     }
 
     if (!paused) {
         for (auto &animation : animations) {
             animation.Update(dt);
         }
+        triangulation_dirty = triangulation_dirty || !animations.empty();
+    }
+
+    if (show_triangulation && triangulation_dirty) {
+        UpdateTriangulation();
+    }
+}
+
+std::vector<MemoryUsageEntry> SceneDrawPolygons::MemoryUsage() const {
+    size_t polygons_bytes = 0;
+    for (const auto &polygon : polygons) {
+        polygons_bytes += polygon.vertexes.size() * sizeof(Point);
+    }
+
+    size_t animations_bytes = animations.size() * sizeof(PolygonAnimation);
+    for (const auto &animation : animations) {
+        // shape and the world vertexes
+        animations_bytes += 2 * animation.NumPoints() * sizeof(Point);
+    }
+
+    return {
+        { "polygons",     polygons_bytes },
+        { "animations",   animations_bytes },
+        { "undo history", history.MemoryUsage() },
+        { "triangulation", triangulation.MemoryUsage() },
+    };
+}
+
+void SceneDrawPolygons::AddAnimation(Polygon &polygon, bool place_on_trajectory) {
+    ScopedMemoryTag memory_tag(MemoryTag::Animation);
+
+    if (animations.size() == 0) {
+        animations.emplace_back(polygon);
+        dragger.AddToDrag(animations.back().AnimatedPolygon().vertexes);
+        selection.AddToSelect(animations.back().AnimatedPolygon().vertexes);
+
+        input_box_panel.Add(&animations[0].rotation_speed, "Rotation Speed 1");
+    } else {
+        // move the original polygon to where it started the animation
+        // so resetting the animation puts it in the right place
+        if (place_on_trajectory) {
+            polygon.SetCenter(animations.back().GetPoint(0));
+        }
+
+        animations.emplace_back(polygon, animations.back());
+        dragger.AddToDrag(animations.back().AnimatedPolygon().vertexes);
+        selection.AddToSelect(animations.back().AnimatedPolygon().vertexes);
+
+        auto polygon_ordinal = std::to_string(animations.size());
+        input_box_panel.Add(&animations.back().moving_speed, "Moving Speed " + polygon_ordinal);
+        input_box_panel.Add(&animations.back().rotation_speed, "Rotation Speed " + polygon_ordinal);
+    }
+}
+
+void SceneDrawPolygons::RebuildAnimations() {
+    std::vector<std::pair<float, float>> speeds;
+    for (auto &animation : animations) {
+        speeds.emplace_back(animation.moving_speed, animation.rotation_speed);
+    }
+
+    animations.clear();
+    input_box_panel.input_boxes.clear();
+    dragger.Clear();
+    selection.Clear();
+
+    // polygons in the history are already where their animations start
+    for (auto &polygon : polygons) {
+        AddAnimation(polygon, false);
+    }
+
+    for (size_t i = 0; i < animations.size() && i < speeds.size(); ++i) {
+        std::tie(animations[i].moving_speed, animations[i].rotation_speed) = speeds[i];
+    }
+}
+
+void SceneDrawPolygons::UpdateSelectedAnimations() {
+    // selected indexes are sorted, so animations are walked once
+    size_t animation_idx = 0;
+    size_t first = 0; // global index of the first vertex of the animation
+    std::optional<size_t> last_updated;
+
+    for (uint32_t global_idx : selection.selected) {
+        while (global_idx >= first + animations[animation_idx].NumPoints()) {
+            first += animations[animation_idx].NumPoints();
+            ++animation_idx;
+        }
+
+        if (last_updated == animation_idx) {
+            continue;
+        }
+        last_updated = animation_idx;
+
+        auto &animation = animations[animation_idx];
+        animation.ApplyEdits();
+        if (animation.trajectory.IsPoint()) {
+            animation.trajectory.GetPoint() = animation.GetCenter();
+        }
+    }
+}
+
+size_t SceneDrawPolygons::AnimationOfVertex(size_t global_idx) const {
+    size_t animation_idx = 0;
+    while (global_idx >= animations[animation_idx].NumPoints()) {
+        global_idx -= animations[animation_idx].NumPoints();
+        ++animation_idx;
+    }
+    return animation_idx;
+}
+
+void SceneDrawPolygons::SimplifyAll(SimplifyMethod method) {
+    size_t before = 0;
+    for (const auto &polygon : polygons) {
+        before += polygon.NumPoints();
+    }
+    double step_before = MeasureAnimationStep();
+
+    double start = GetTime();
+    // big polygons are also split into chunks inside, nested ParallelFor is fine
+    GetThreadPool().ParallelFor(polygons.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            SimplifyPolygon(polygons[i], SIMPLIFY_TOLERANCE, method);
+        }
+    });
+    double simplify_time = GetTime() - start;
+
+    size_t after = 0;
+    for (const auto &polygon : polygons) {
+        after += polygon.NumPoints();
+    }
+
+    RebuildAnimations();
+    CommitHistory();
+
+    double step_after = MeasureAnimationStep();
+
+    operation_stats = TextFormat("%s: %zu -> %zu vertexes in %.2f ms, animation step %.3f -> %.3f ms (%.1fx)",
+                                method == SimplifyMethod::DouglasPeucker ? "Douglas-Peucker" : "Visvalingam-Whyatt",
+                                before, after, simplify_time * 1000, step_before * 1000, step_after * 1000,
+                                step_after > 0 ? step_before / step_after : 1.0);
+    TraceLog(LOG_INFO, "Simplified %zu polygons with %s", polygons.size(), operation_stats.c_str());
+}
+
+double SceneDrawPolygons::MeasureAnimationStep() {
+    static constexpr int RUNS = 16;
+
+    // Update(0) doesn't move anything, but vertexes are computed again as every frame
+    double start = GetTime();
+    for (int run = 0; run < RUNS; ++run) {
+        for (auto &animation : animations) {
+            animation.Update(0);
+            animation.AnimatedPolygon();
+        }
+    }
+    return (GetTime() - start) / RUNS;
+}
+
+namespace {
+
+// result rings of PolygonBoolean() go counter-clockwise in math coordinates, holes go the other way
+bool IsHole(const Polygon &ring) {
+    double area2 = 0;
+    for (size_t i = 0, n = ring.NumPoints(); i < n; ++i) {
+        Point a = ring.vertexes[i];
+        Point b = ring.vertexes[(i + 1) % n];
+        area2 += (double) a.x * b.y - (double) b.x * a.y;
+    }
+    return area2 < 0;
+}
+
+} // namespace
+
+void SceneDrawPolygons::CombineLastPolygons(BooleanOperation operation) {
+    static constexpr const char *NAMES[] = { "Union", "Intersection", "Difference", "Xor" };
+
+    size_t n = animations.size();
+    assert(n >= 2 && n == polygons.size());
+
+    // drawn polygons may cross themselves, even-odd rule fills them the way they look
+    Polygon subject = animations[n - 2].AnimatedPolygon();
+    Polygon clip    = animations[n - 1].AnimatedPolygon();
+
+    double start = GetTime();
+    std::vector<Polygon> result = PolygonBoolean({ &subject, 1 }, { &clip, 1 }, operation, FillRule::EvenOdd);
+    double time = GetTime() - start;
+
+    // a hole animated on its own would be a polygon over the area it should cut out
+    size_t nholes = 0;
+    polygons.resize(n - 2);
+    for (auto &ring : result) {
+        if (IsHole(ring)) {
+            ++nholes;
+            continue;
+        }
+        polygons.push_back(std::move(ring));
+    }
+
+    RebuildAnimations();
+    CommitHistory();
+
+    operation_stats = TextFormat("%s: %zu + %zu vertexes -> %zu rings in %.2f ms",
+                                 NAMES[(int) operation], subject.NumPoints(), clip.NumPoints(), result.size() - nholes, time * 1000);
+    if (nholes > 0) {
+        operation_stats += TextFormat(", %zu holes dropped", nholes);
+        TraceLog(LOG_WARNING, "Combined polygons: %zu holes of the result are dropped, polygons of the scene can't have them", nholes);
+    }
+    TraceLog(LOG_INFO, "Combined polygons: %s", operation_stats.c_str());
+}
+
+void SceneDrawPolygons::UpdateTriangulation() {
+    std::pmr::vector<Point> vertexes(GetFrameArena().Resource());
+    for (auto &animation : animations) {
+        const Polygon &polygon = animation.AnimatedPolygon();
+        vertexes.insert(vertexes.end(), polygon.vertexes.begin(), polygon.vertexes.end());
     }
+
+    // a paused scene with a dragged vertex is one removal and one insertion, moving animations are a rebuild
+    size_t rebuilds = triangulation.rebuilds;
+    double start = GetTime();
+    triangulation.Sync(vertexes);
+    double time = GetTime() - start;
+
+    triangulation_stats = TextFormat("Delaunay: %zu points, %zu triangles, %s in %.3f ms",
+                                     vertexes.size(), triangulation.NumTriangles(),
+                                     triangulation.rebuilds != rebuilds ? "rebuilt" : "updated", time * 1000);
+    triangulation_dirty = false;
+}
+
+void SceneDrawPolygons::CommitHistory() {
+    history.Commit(polygons, [](const Polygon &polygon) -> const std::pmr::deque<Point> & { return polygon.vertexes; });
+    triangulation_dirty = true;
+}
+
+void SceneDrawPolygons::Undo() {
+    if (history.Undo()) {
+        RestoreHistory();
+    }
+}
+
+void SceneDrawPolygons::Redo() {
+    if (history.Redo()) {
+        RestoreHistory();
+    }
+}
+
+void SceneDrawPolygons::RestoreHistory() {
+    // polygons are few and small, so they are simply recreated from the snapshot
+    const auto &snapshot = history.Current();
+
+    polygons.resize(snapshot.sequences.size());
+    for (size_t i = 0; i < polygons.size(); ++i) {
+        polygons[i].vertexes.clear();
+        snapshot.sequences[i]->CopyPoints(std::back_inserter(polygons[i].vertexes));
+    }
+
+    RebuildAnimations();
+    triangulation_dirty = true;
 }
\ No newline at end of file
@@ -1,39 +1,102 @@
 #pragma once
 
 #include <deque>
+#include <string>
 
 #include "geometry/geometry.hpp"
+#include "geometry/delaunay.hpp"
 #include "geometry/polygon_animation.hpp"
+#include "geometry/polygon_boolean.hpp"
+#include "geometry/simplify.hpp"
 #include "scenes/point_dragger.hpp"
+#include "scenes/point_selection.hpp"
 #include "scenes/scene.hpp"
 #include "gui/gui.hpp"
+#include "history/undo_history.hpp"
+#include "render/render.hpp"
 
 
 struct SceneDrawPolygons : Scene {
     // these must be deques so refs to the objects are always valid
-    std::deque<Polygon> polygons;
+    std::pmr::deque<Polygon> polygons;
     std::deque<PolygonAnimation> animations;
     
     GUI::InputBoxPanel input_box_panel;
     GUI::Toggle toggle_draw_polygon;
     
     Polygon drawn_polygon;
+    // vertexes traced by dragging the mouse are simplified as they come, clicked ones are kept as they are
+    StreamingSimplifier drawn_simplifier;
+    bool drawing_stroke = false;
+
+    // max distance (in pixels) of a removed vertex from the simplified polygon
+    static constexpr float SIMPLIFY_TOLERANCE = 1.5f;
+    std::string operation_stats; // of the last simplification or boolean operation
 
     bool paused = false;
+    bool show_hulls = false;
+
+    // of the vertexes of all animations, dragged vertexes are moved in it instead of triangulating everything again
+    DelaunayTriangulation triangulation;
+    bool show_triangulation = false;
+    bool triangulation_dirty = true; // set whenever vertexes of animations move or polygons change
+    std::string triangulation_stats;
 
     PointDragger dragger;
+    // vertexes of animated polygons, like the dragger
+    PointSelection selection;
+
+    // original polygons, one step per added polygon or deletion
+    UndoHistory history;
 
     SceneDrawPolygons() :
-        input_box_panel({ GetScreenWidth() - 450.f, 40, 410, GetScreenHeight() - 80.f }),
+        input_box_panel({ Render::GetScreenWidth() - 450.f, 40, 410, Render::GetScreenHeight() - 80.f }),
         toggle_draw_polygon(Rectangle{ 
                 input_box_panel.panel.x + input_box_panel.panel.width - input_box_panel.DEFAULT_BOX_WIDTH - 35,
                 input_box_panel.panel.y + input_box_panel.panel.height - 2 * input_box_panel.DEFAULT_BOX_HEIGHT,
                 input_box_panel.DEFAULT_BOX_WIDTH,
                 input_box_panel.DEFAULT_BOX_HEIGHT },
             "Draw", "Finish")
-    {}
+    {
+        CommitHistory();
+    }
 
     bool IsSwitchable() override;
     void Draw() override;
     void Update(float dt) override;
+    std::vector<MemoryUsageEntry> MemoryUsage() const override;
+    void ReleaseHeavyState() override {
+        input_box_panel.layer.Release();
+        triangulation.Clear();
+        triangulation_dirty = true;
+    }
+    bool IsDirty() override {
+        return (!paused && !animations.empty()) || !IsSwitchable() || IsArrowKeyDown();
+    }
+
+    // animate polygon, it is placed onto the trajectory where the previous animated polygon is now
+    void AddAnimation(Polygon &polygon, bool place_on_trajectory=true);
+    // recreate animations of all the polygons, speeds of the ones that are still there are kept
+    void RebuildAnimations();
+    // animations take the shape of their moved vertexes,
+    // the ones that stand still also move there instead of pulling them back on the next frame
+    void UpdateSelectedAnimations();
+    // dragger and selection use one index for vertexes of all animations
+    size_t AnimationOfVertex(size_t global_idx) const;
+
+    // polygons lose the vertexes that are not visible, animations restart with the simplified shapes
+    void SimplifyAll(SimplifyMethod method);
+    // seconds per frame spent on moving the animations and computing their vertexes
+    double MeasureAnimationStep();
+    // the last two polygons are replaced with the outer rings of the result, as they are on the screen now
+    // (difference is the second to last one without the last one), animations restart
+    // every polygon is animated on its own and can't have holes, so holes of the result are dropped
+    void CombineLastPolygons(BooleanOperation operation);
+    // triangulation takes the vertexes of animations as they are now, only called when they have moved
+    void UpdateTriangulation();
+
+    void CommitHistory();
+    void Undo();
+    void Redo();
+    void RestoreHistory();
 };
\ No newline at end of file
@@ -1,21 +1,26 @@
 #include "scene_ellipses.hpp"
 
 #include "colors.h"
+#include "render/render.hpp"
 
-SceneEllipses::SceneEllipses() : input_box_panel(Rectangle { GetScreenWidth() - 450.f, 40, 410, GetScreenHeight() - 80.f } )
+SceneEllipses::SceneEllipses() : input_box_panel(Rectangle { Render::GetScreenWidth() - 450.f, 40, 410, Render::GetScreenHeight() - 80.f } )
 {
-    ellipses[0] = Polygon::Ellipse( Point { GetScreenWidth() * 7.f / 16.f, GetScreenHeight() / 2.f }, 200.f, 100.f );
-    ellipses[1] = Polygon::Ellipse( ellipses[0].GetPoint(0),                                          100.f, 50.f  );
-    ellipses[2] = Polygon::Ellipse( ellipses[1].GetPoint(0),                                          50.f,  25.f  );
+    Point center = { Render::GetScreenWidth() * 7.f / 16.f, Render::GetScreenHeight() / 2.f };
+
+    ellipses[0] = Polygon::Ellipse( center,                  200.f, 100.f );
+    ellipses[1] = Polygon::Ellipse( ellipses[0].GetPoint(0), 100.f, 50.f  );
+    ellipses[2] = Polygon::Ellipse( ellipses[1].GetPoint(0), 50.f,  25.f  );
 
     animations[0] = PolygonAnimation(ellipses[0]);
     animations[0].rotation_speed = 1;
 
-    animations[1] = PolygonAnimation(ellipses[1], animations[0].animated_polygon);
+    // each ellipse moves along the exact ellipse of the previous one, not along its polygon
+    // trajectory is relative to the center of the previous animation, which is the mean of its vertexes
+    animations[1] = PolygonAnimation(ellipses[1], EllipseTrajectory(center - ellipses[0].GetCenter(), 200.f, 100.f, &animations[0]));
     animations[1].rotation_speed = 2;
     animations[1].moving_speed   = 2;
 
-    animations[2] = PolygonAnimation(ellipses[2], animations[1].animated_polygon);
+    animations[2] = PolygonAnimation(ellipses[2], EllipseTrajectory(ellipses[0].GetPoint(0) - ellipses[1].GetCenter(), 100.f, 50.f, &animations[1]));
     animations[2].rotation_speed = 3;
     animations[2].moving_speed   = 3;
     
@@ -37,17 +42,17 @@ bool SceneEllipses::IsSwitchable() {
 
 void SceneEllipses::Draw() {
     for (auto &animation : animations) {
-        animation.animated_polygon.Draw(COLOR_LINE_PRIMARY);
-        animation.animated_polygon.DrawCenter(COLOR_POINT_PRIMARY);
+        animation.Draw(COLOR_LINE_PRIMARY);
+        animation.DrawCenter(COLOR_POINT_PRIMARY);
     }
 
     input_box_panel.Draw();
 
     if (paused) {
-        DrawText("paused", 20, 45, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+        Render::DrawText("paused", 20, 45, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
     }
 
-    DrawText("Ellipses", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText("Ellipses", 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
 }
 
 void SceneEllipses::Update(float dt) {
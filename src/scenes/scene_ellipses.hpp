@@ -21,4 +21,10 @@ struct SceneEllipses : Scene {
     bool IsSwitchable() override;
     void Draw() override;
     void Update(float dt) override;
+    void ReleaseHeavyState() override {
+        input_box_panel.layer.Release();
+    }
+    bool IsDirty() override {
+        return !paused || !IsSwitchable();
+    }
 };
\ No newline at end of file
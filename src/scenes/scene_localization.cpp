@@ -1,28 +1,65 @@
 #include "scene_localization.hpp"
 
 #include "colors.h"
+#include "memory/allocation_counter.hpp"
+#include "parallel/thread_pool.hpp"
+#include "render/render.hpp"
 
 #include <raylib.h>
 #include <raygui.h>
 
+#include <algorithm>
 #include <cassert>
-#include <string>
 #include <cmath>
 
+namespace {
+
+// smoothed over a few frames, so the numbers can be read
+void AddSpeed(double &average, size_t points, double elapsed) {
+    if (elapsed > 0) {
+        double speed = (double) points / elapsed;
+        average = average == 0 ? speed : average * 0.9 + speed * 0.1;
+    }
+}
+
+// neighbour triangles mostly get different hues
+Color TriangleColor(uint32_t triangle) {
+    return Fade(ColorFromHSV((float) (triangle * 47 % 360), 0.5f, 0.9f), 0.4f);
+}
+
+} // namespace
+
 SceneLocalization::SceneLocalization() {
-    auto w = GetScreenWidth();
-    auto h = GetScreenHeight();
+    // size of the software target when the scene is drawn headless
+    auto w = Render::GetScreenWidth();
+    auto h = Render::GetScreenHeight();
+    Point center = { w / 2.f, h / 2.f };
 
-    triangle.a = GetScreenCenter() + GetRandomPoint(-w / 2, w / 2, -h / 2, h / 2);
-    triangle.b = GetScreenCenter() + GetRandomPoint(-w / 2, w / 2, -h / 2, h / 2);
-    triangle.c = GetScreenCenter() + GetRandomPoint(-w / 2, w / 2, -h / 2, h / 2);
+    triangle.a = center + GetRandomPoint(-w / 2, w / 2, -h / 2, h / 2);
+    triangle.b = center + GetRandomPoint(-w / 2, w / 2, -h / 2, h / 2);
+    triangle.c = center + GetRandomPoint(-w / 2, w / 2, -h / 2, h / 2);
 
     dragger.AddToDrag(triangle.a);
     dragger.AddToDrag(triangle.b);
     dragger.AddToDrag(triangle.c);
 }
 
+SceneLocalization::~SceneLocalization() {
+    // scenes may outlive the window, texture is gone together with the context then
+    if (IsWindowReady() && IsTextureValid(heatmap.texture)) {
+        UnloadTexture(heatmap.texture);
+    }
+}
+
 void SceneLocalization::Draw() {
+    if (heatmap.active) {
+        DrawHeatmap();
+    }
+    if (mesh.active) {
+        DrawMesh();
+        return;
+    }
+
     Color col_side1 = COLOR_LINE_PRIMARY;
     Color col_side2 = COLOR_LINE_PRIMARY;
     Color col_side3 = COLOR_LINE_PRIMARY;
@@ -45,14 +82,10 @@ void SceneLocalization::Draw() {
             float k2 = ((p.x - a.x) * (c.y - a.y) - (c.x - a.x) * (p.y - a.y)) / d;
             float k3 = 1 - k1 - k2;
 
-            std::string text = "k1 = " + std::to_string(k1);
-            DrawText(text.c_str(), 40, 60, 20, k1 > 0 ? GRAY : COLOR_GRAY_FADED);
-
-            text = "k2 = " + std::to_string(k2);
-            DrawText(text.c_str(), 40, 85, 20, k2 > 0 ? GRAY : COLOR_GRAY_FADED);
-            
-            text = "k3 = " + std::to_string(k3);
-            DrawText(text.c_str(), 40, 110, 20, k3 > 0 ? GRAY : COLOR_GRAY_FADED);
+            // TextFormat uses raylib's static buffers, so nothing is allocated per frame
+            Render::DrawText(TextFormat("k1 = %f", k1), 40, 60, 20, k1 > 0 ? GRAY : COLOR_GRAY_FADED);
+            Render::DrawText(TextFormat("k2 = %f", k2), 40, 85, 20, k2 > 0 ? GRAY : COLOR_GRAY_FADED);
+            Render::DrawText(TextFormat("k3 = %f", k3), 40, 110, 20, k3 > 0 ? GRAY : COLOR_GRAY_FADED);
             break;
         }
         case 1: // sides
@@ -73,13 +106,13 @@ void SceneLocalization::Draw() {
 
             Point center = (a + b + c) / 3;
             Point offset = Vector2Normalize(center - a) * 30;
-            DrawText("1", (int) (a.x - offset.x), (int) (a.y - offset.y), GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+            Render::DrawText("1", (int) (a.x - offset.x), (int) (a.y - offset.y), GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
 
             offset = Vector2Normalize(center - b) * 30;
-            DrawText("2", (int) (b.x - offset.x), (int) (b.y - offset.y), GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+            Render::DrawText("2", (int) (b.x - offset.x), (int) (b.y - offset.y), GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
 
             offset = Vector2Normalize(center - c) * 30;
-            DrawText("3", (int) (c.x - offset.x), (int) (c.y - offset.y), GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+            Render::DrawText("3", (int) (c.x - offset.x), (int) (c.y - offset.y), GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
 
             break;
         }
@@ -87,22 +120,22 @@ void SceneLocalization::Draw() {
         {
             Point center = (a + b + c) / 3;
 
-            DrawLineDotted(p, center, 20, 5, COLOR_GRAY_FADED);
-            DrawCircleV(center, 7, COLOR_POINT_PRIMARY);
+            Render::DrawLineDotted(p, center, 20, 5, COLOR_GRAY_FADED);
+            Render::DrawCircle(center, 7, COLOR_POINT_PRIMARY);
 
             if (auto i = Intersect(p, center, a, b)) {
                 col_side1 = COLOR_LINE_SECONDARY;
-                DrawCircleV(i.value(), 7, COLOR_POINT_SECONDARY);
+                Render::DrawCircle(i.value(), 7, COLOR_POINT_SECONDARY);
             }
 
             if (auto i = Intersect(p, center, b, c)) {
                 col_side2 = COLOR_LINE_SECONDARY;
-                DrawCircleV(i.value(), 7, COLOR_POINT_SECONDARY);
+                Render::DrawCircle(i.value(), 7, COLOR_POINT_SECONDARY);
             }
 
             if (auto i = Intersect(p, center, c, a)) {
                 col_side3 = COLOR_LINE_SECONDARY;
-                DrawCircleV(i.value(), 7, COLOR_POINT_SECONDARY);
+                Render::DrawCircle(i.value(), 7, COLOR_POINT_SECONDARY);
             }
 
             break;
@@ -111,23 +144,264 @@ void SceneLocalization::Draw() {
             assert(false && "unreachable");
     }
 
-    DrawLineV(triangle.a, triangle.b, col_side1);
-    DrawLineV(triangle.b, triangle.c, col_side2);
-    DrawLineV(triangle.c, triangle.a, col_side3);
+    Render::DrawLine(triangle.a, triangle.b, col_side1);
+    Render::DrawLine(triangle.b, triangle.c, col_side2);
+    Render::DrawLine(triangle.c, triangle.a, col_side3);
 
-    DrawCircleV(triangle.a, 7, COLOR_POINT_PRIMARY);
-    DrawCircleV(triangle.b, 7, COLOR_POINT_PRIMARY);
-    DrawCircleV(triangle.c, 7, COLOR_POINT_PRIMARY);
+    Render::DrawCircle(triangle.a, 7, COLOR_POINT_PRIMARY);
+    Render::DrawCircle(triangle.b, 7, COLOR_POINT_PRIMARY);
+    Render::DrawCircle(triangle.c, 7, COLOR_POINT_PRIMARY);
 
-    DrawCircleV(GetMousePosition(), 15, is_inside_funcs[mode](mouse_pos, triangle.a, triangle.b, triangle.c) ? GREEN : COLOR_POINT_SECONDARY);
+    Render::DrawCircle(GetMousePosition(), 15, is_inside_funcs[mode](mouse_pos, triangle.a, triangle.b, triangle.c) ? GREEN : COLOR_POINT_SECONDARY);
 
-    DrawText(titles[mode], 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
+    Render::DrawText(titles[mode], 20, 20, GuiGetStyle(DEFAULT, TEXT_SIZE), GRAY);
 }
 
 void SceneLocalization::Update(float) {
-    dragger.Update();
+    if (IsKeyPressed(KEY_M)) {
+        mesh.active = !mesh.active;
+    }
+    if (mesh.active && mesh.triangles.triangles.empty()) {
+        BuildMesh();
+    }
+
+    if (!mesh.active) {
+        dragger.Update();
+    }
 
     if (IsKeyPressed(KEY_SPACE)) {
-        mode = (mode + 1) % is_inside_funcs.size();
+        if (mesh.active) {
+            mesh.method = (mesh.method + 1) % mesh_method_names.size();
+        } else {
+            mode = (mode + 1) % is_inside_funcs.size();
+        }
+    }
+
+    if (mesh.active) {
+        mesh.located = LocateInMesh(GetMousePosition());
+    }
+
+    if (IsKeyPressed(KEY_H)) {
+        if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) {
+            heatmap.step_idx = (heatmap.step_idx + 1) % heatmap_steps.size();
+        } else {
+            heatmap.active = !heatmap.active;
+        }
+    }
+
+    if (heatmap.active) {
+        ClassifyHeatmap();
+    }
+}
+
+std::vector<MemoryUsageEntry> SceneLocalization::MemoryUsage() const {
+    return {
+        { "heatmap", heatmap.pixels.capacity() * sizeof(Color) },
+        { "heatmap texture", (size_t) heatmap.texture.width * heatmap.texture.height * sizeof(Color) },
+        { "mesh", mesh.delaunay.MemoryUsage() + mesh.triangles.MemoryUsage() },
+        { "mesh grid index", mesh.grid.MemoryUsage() },
+        { "mesh heatmap", mesh.samples.capacity() * sizeof(Point) + mesh.results.capacity() * sizeof(uint32_t) },
+    };
+}
+
+void SceneLocalization::ReleaseHeavyState() {
+    if (IsTextureValid(heatmap.texture)) {
+        UnloadTexture(heatmap.texture);
+    }
+    heatmap.texture = {};
+    heatmap.uploaded = false;
+    heatmap.pixels.clear();
+    heatmap.pixels.shrink_to_fit();
+
+    // the mesh is built again when the scene is shown
+    mesh.delaunay = DelaunayTriangulation();
+    mesh.triangles = TriangleMesh();
+    mesh.grid = MeshGridIndex();
+    mesh.located = TriangleMesh::NONE;
+    mesh.samples.clear();
+    mesh.samples.shrink_to_fit();
+    mesh.results.clear();
+    mesh.results.shrink_to_fit();
+}
+
+void SceneLocalization::ClassifyHeatmap() {
+    ScopedMemoryTag memory_tag(MemoryTag::Scene);
+
+    int step = heatmap_steps[heatmap.step_idx];
+    heatmap.width  = (Render::GetScreenWidth() + step - 1) / step;
+    heatmap.height = (Render::GetScreenHeight() + step - 1) / step;
+    heatmap.pixels.resize((size_t) heatmap.width * heatmap.height);
+
+    if (mesh.active) {
+        LocateHeatmapInMesh();
+        return;
+    }
+
+    int tiles_x = (heatmap.width + HEATMAP_TILE_SIZE - 1) / HEATMAP_TILE_SIZE;
+    int tiles_y = (heatmap.height + HEATMAP_TILE_SIZE - 1) / HEATMAP_TILE_SIZE;
+
+    auto is_inside = is_inside_funcs[mode];
+    Point a = triangle.a;
+    Point b = triangle.b;
+    Point c = triangle.c;
+    Color inside  = Fade(COLOR_LINE_SECONDARY, 0.4f);
+    Color outside = BLANK;
+
+    double start = GetTime();
+    GetThreadPool().ParallelFor((size_t) tiles_x * tiles_y, 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; ++tile) {
+            int x0 = (int) (tile % tiles_x) * HEATMAP_TILE_SIZE;
+            int y0 = (int) (tile / tiles_x) * HEATMAP_TILE_SIZE;
+            int x1 = std::min(x0 + HEATMAP_TILE_SIZE, heatmap.width);
+            int y1 = std::min(y0 + HEATMAP_TILE_SIZE, heatmap.height);
+
+            for (int y = y0; y < y1; ++y) {
+                Color *row = heatmap.pixels.data() + (size_t) y * heatmap.width;
+                for (int x = x0; x < x1; ++x) {
+                    // samples are at the centers of the pixels they stand for
+                    Point p { ((float) x + 0.5f) * (float) step, ((float) y + 0.5f) * (float) step };
+                    row[x] = is_inside(p, a, b, c) ? inside : outside;
+                }
+            }
+        }
+    });
+    AddSpeed(heatmap.points_per_second[mode], heatmap.pixels.size(), GetTime() - start);
+    heatmap.uploaded = false;
+}
+
+void SceneLocalization::DrawHeatmap() {
+    // texture is not captured by the software rasterizer, like text and gui
+    if (!Render::IsSoftware() && !heatmap.pixels.empty()) {
+        Texture2D &texture = heatmap.texture;
+        if (texture.width != heatmap.width || texture.height != heatmap.height) {
+            if (IsTextureValid(texture)) {
+                UnloadTexture(texture);
+            }
+            Image image { heatmap.pixels.data(), heatmap.width, heatmap.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+            texture = LoadTextureFromImage(image);
+            heatmap.uploaded = true;
+        }
+        if (!heatmap.uploaded) {
+            UpdateTexture(texture, heatmap.pixels.data());
+            heatmap.uploaded = true;
+        }
+        DrawTextureEx(texture, Vector2Zeros, 0, (float) heatmap_steps[heatmap.step_idx], WHITE);
+    }
+
+    // speeds of the methods of the current mode
+    std::span<const char *const> names = mesh.active ? std::span<const char *const>(mesh_method_names) : method_names;
+    std::span<const double> speeds = mesh.active ? std::span<const double>(mesh.points_per_second) : heatmap.points_per_second;
+    int current = mesh.active ? mesh.method : mode;
+
+    int font_size = GuiGetStyle(DEFAULT, TEXT_SIZE);
+    int y = Render::GetScreenHeight() - 20 - font_size * (int) (names.size() + 1);
+    int step = heatmap_steps[heatmap.step_idx];
+    Render::DrawText(TextFormat("stress: %ix%i points (every %i px), %zu threads", heatmap.width, heatmap.height, step,
+                        GetThreadPool().NumThreads()),
+             20, y, font_size, GRAY);
+    for (size_t i = 0; i < names.size(); ++i) {
+        y += font_size;
+        double speed = speeds[i];
+        Render::DrawText(speed == 0 ? TextFormat("%s: -", names[i])
+                            : TextFormat("%s: %.1f M points/s", names[i], speed / 1e6),
+                 20, y, font_size, (int) i == current ? COLOR_LINE_SECONDARY : GRAY);
+    }
+}
+
+void SceneLocalization::BuildMesh() {
+    ScopedMemoryTag memory_tag(MemoryTag::Scene);
+
+    int w = Render::GetScreenWidth();
+    int h = Render::GetScreenHeight();
+    std::vector<Point> points = { { 0, 0 }, { (float) w, 0 }, { (float) w, (float) h }, { 0, (float) h } };
+    for (int i = 0; i < MESH_POINTS; ++i) {
+        points.push_back(GetRandomPoint(0, w, 0, h));
+    }
+
+    double start = GetTime();
+    mesh.delaunay.Build(points);
+    mesh.delaunay.ExportMesh(mesh.triangles);
+    mesh.grid.Build(mesh.triangles);
+    mesh.walker.current = 0;
+    mesh.brute_force_next = 0;
+    TraceLog(LOG_INFO, "Localization: mesh of %zu triangles built in %.2f ms", mesh.triangles.triangles.size(),
+             (GetTime() - start) * 1000);
+}
+
+uint32_t SceneLocalization::LocateInMesh(Point p) {
+    switch (mesh.method) {
+        case 0: {
+            size_t steps = mesh.walker.steps;
+            uint32_t triangle = mesh.walker.Locate(p);
+            mesh.steps = mesh.walker.steps - steps;
+            return triangle;
+        }
+        case 1:
+            return mesh.grid.Locate(p);
+        default:
+            return LocatePointBruteForce(mesh.triangles, p);
+    }
+}
+
+void SceneLocalization::LocateHeatmapInMesh() {
+    int step = heatmap_steps[heatmap.step_idx];
+    size_t n = heatmap.pixels.size();
+    mesh.samples.resize(n);
+    mesh.results.resize(n, TriangleMesh::NONE);
+    for (int y = 0; y < heatmap.height; ++y) {
+        for (int x = 0; x < heatmap.width; ++x) {
+            mesh.samples[(size_t) y * heatmap.width + x] = { ((float) x + 0.5f) * (float) step, ((float) y + 0.5f) * (float) step };
+        }
+    }
+
+    std::span<const Point> samples = mesh.samples;
+    std::span<uint32_t> results = mesh.results;
+    if (mesh.method == 2) {
+        // the rest of the samples keep the triangles of the previous frames
+        size_t begin = mesh.brute_force_next < n ? mesh.brute_force_next : 0;
+        size_t count = std::min(MESH_BRUTE_FORCE_SAMPLES, n - begin);
+        samples = samples.subspan(begin, count);
+        results = results.subspan(begin, count);
+        mesh.brute_force_next = begin + count;
+    }
+
+    // samples go in rows, so every walk is short
+    double start = GetTime();
+    switch (mesh.method) {
+        case 0:  LocatePointsByWalk(mesh.triangles, samples, results); break;
+        case 1:  LocatePointsByGrid(mesh.grid, samples, results); break;
+        default: LocatePointsBruteForce(mesh.triangles, samples, results); break;
+    }
+    AddSpeed(mesh.points_per_second[mesh.method], samples.size(), GetTime() - start);
+
+    for (size_t i = 0; i < n; ++i) {
+        heatmap.pixels[i] = mesh.results[i] == TriangleMesh::NONE ? BLANK : TriangleColor(mesh.results[i]);
+    }
+    heatmap.uploaded = false;
+}
+
+void SceneLocalization::DrawMesh() {
+    const TriangleMesh &triangles = mesh.triangles;
+    if (mesh.located != TriangleMesh::NONE) {
+        const auto &t = triangles.triangles[mesh.located];
+        // counter-clockwise in math coordinates is clockwise on the screen
+        Point strip[] = { triangles.vertexes[t[0]], triangles.vertexes[t[2]], triangles.vertexes[t[1]] };
+        Render::DrawTriangleStrip(strip, Fade(COLOR_LINE_SECONDARY, 0.5f));
+    }
+    mesh.delaunay.ForEachEdge([](Point a, Point b) {
+        Render::DrawLine(a, b, COLOR_GRAY_FADED);
+    });
+
+    Render::DrawCircle(GetMousePosition(), 7, mesh.located != TriangleMesh::NONE ? GREEN : COLOR_POINT_SECONDARY);
+
+    int font_size = GuiGetStyle(DEFAULT, TEXT_SIZE);
+    Render::DrawText(TextFormat("Localization: Delaunay mesh, %s", mesh_method_names[mesh.method]), 20, 20, font_size, GRAY);
+    if (mesh.located == TriangleMesh::NONE) {
+        Render::DrawText("outside of the mesh", 20, 20 + font_size, font_size, GRAY);
+    } else if (mesh.method == 0) {
+        Render::DrawText(TextFormat("triangle %u of %zu, the walk took %zu steps", mesh.located, triangles.triangles.size(), mesh.steps),
+                         20, 20 + font_size, font_size, GRAY);
+    } else {
+        Render::DrawText(TextFormat("triangle %u of %zu", mesh.located, triangles.triangles.size()), 20, 20 + font_size, font_size, GRAY);
     }
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <array>
+#include <vector>
 
 #include "geometry/geometry.hpp"
+#include "geometry/delaunay.hpp"
+#include "geometry/point_location.hpp"
 #include "scenes/point_dragger.hpp"
 #include "scenes/scene.hpp"
 
@@ -23,8 +26,68 @@ struct SceneLocalization : Scene {
     };
     int mode = 0; // idx of is_inside_func
 
+    // stress mode: every step-th pixel of the screen is classified by the current method every frame
+    // the screen is split into tiles, which are classified in parallel
+    static constexpr int HEATMAP_TILE_SIZE = 64; // in samples
+    static constexpr auto heatmap_steps = std::array{ 1, 2, 4 };
+    static constexpr auto method_names = std::array{ "barycentric", "sides", "intersections" };
+    struct {
+        bool active = false;
+        int step_idx = 0;
+
+        int width  = 0; // in samples
+        int height = 0;
+        std::vector<Color> pixels;
+        Texture2D texture {};
+        bool uploaded = false;
+
+        // the last measured speed of every method, they are comparable after switching between them
+        std::array<double, is_inside_funcs.size()> points_per_second {};
+    } heatmap;
+
+    // mesh mode: the point is located in the Delaunay triangulation of random points instead of one triangle,
+    // by walking from the last located triangle, by a grid index or by testing every triangle
+    // stress mode locates every sample with the current method, brute force locates a part of them every frame
+    static constexpr int MESH_POINTS = 2000;
+    static constexpr size_t MESH_BRUTE_FORCE_SAMPLES = 20000; // per frame
+    static constexpr auto mesh_method_names = std::array{ "walk", "grid index", "brute force" };
+    struct {
+        bool active = false;
+        int method = 0; // idx of mesh_method_names
+
+        DelaunayTriangulation delaunay;
+        TriangleMesh triangles;
+        MeshGridIndex grid;
+        MeshWalker walker { triangles };
+
+        uint32_t located = TriangleMesh::NONE; // triangle under the mouse
+        size_t steps = 0;                      // of the last walk to it
+
+        std::vector<Point> samples;    // of the heatmap, in rows
+        std::vector<uint32_t> results; // triangles of the samples
+        size_t brute_force_next = 0;   // sample the brute force goes on from
+
+        std::array<double, mesh_method_names.size()> points_per_second {};
+    } mesh;
+
     SceneLocalization();
+    ~SceneLocalization();
 
     void Draw() override;
     void Update(float dt) override;
+    std::vector<MemoryUsageEntry> MemoryUsage() const override;
+    void ReleaseHeavyState() override;
+    // nothing moves unless it is dragged, stress mode works every frame
+    bool IsDirty() override {
+        return heatmap.active;
+    }
+
+    void ClassifyHeatmap();
+    void DrawHeatmap();
+
+    // random points over the screen and its corners, so the mesh covers all of it
+    void BuildMesh();
+    uint32_t LocateInMesh(Point p);
+    void LocateHeatmapInMesh();
+    void DrawMesh();
 };
\ No newline at end of file
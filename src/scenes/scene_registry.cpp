@@ -0,0 +1,149 @@
+#include "scene_registry.hpp"
+
+#include <raylib.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include "memory/allocation_counter.hpp"
+
+SceneRegistry::Entry::Entry(int key, const char *name, Factory factory, bool show_cursor, bool disposable) :
+    key(key), name(name), factory(std::move(factory)), show_cursor(show_cursor), disposable(disposable),
+    frame_recorder(name)
+{}
+
+void SceneRegistry::Register(int key, const char *name, Factory factory, bool show_cursor, bool disposable) {
+    assert(!Find(key) && "SceneRegistry: key is already taken");
+    // current entry is referenced by pointer, so entries must not move after the first activation
+    assert(!current && "SceneRegistry: scenes must be registered before activation");
+
+    entries.emplace_back(key, name, std::move(factory), show_cursor, disposable);
+}
+
+bool SceneRegistry::Activate(int key) {
+    Entry *entry = Find(key);
+    if (!entry) {
+        return false;
+    }
+
+    if (!entry->scene) {
+        Construct(*entry);
+    }
+
+    if (entry->show_cursor) {
+        ShowCursor();
+    } else {
+        HideCursor();
+    }
+
+    entry->heavy_state_released = false;
+    current = entry;
+    return true;
+}
+
+void SceneRegistry::Deactivate() {
+    ShowCursor();
+    current = nullptr;
+}
+
+void SceneRegistry::Maintain(double idle_time) {
+    ++frame;
+    if (current) {
+        current->last_active_frame = frame;
+    }
+
+    EnforceMemoryBudget();
+
+    // the first frame is shown before anything is preloaded, and nothing is preloaded when memory is short
+    if (preload && frame > 1 && idle_time >= PRELOAD_MIN_IDLE && GetHeapBytesCurrent() < LowWatermark()) {
+        PreloadNext();
+    }
+}
+
+size_t SceneRegistry::LowWatermark() const {
+    return (size_t) ((double) memory_budget * LOW_WATERMARK);
+}
+
+SceneRegistry::Entry *SceneRegistry::Find(int key) {
+    for (auto &entry : entries) {
+        if (entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void SceneRegistry::Construct(Entry &entry) {
+    ScopedMemoryTag memory_tag(MemoryTag::Scene);
+
+    size_t heap_before = GetHeapBytesCurrent();
+    double start = GetTime();
+
+    entry.scene = entry.factory();
+
+    entry.construction_time  = GetTime() - start;
+    size_t heap_after = GetHeapBytesCurrent();
+    entry.construction_bytes = heap_after > heap_before ? heap_after - heap_before : 0;
+    ++entry.constructions;
+
+    TraceLog(LOG_INFO, "SceneRegistry: constructed '%s' in %f ms, %zu bytes", entry.name,
+             entry.construction_time * 1000, entry.construction_bytes);
+}
+
+void SceneRegistry::PreloadNext() {
+    if (entries.empty()) {
+        return;
+    }
+
+    // the one after the current scene is the most likely to be opened next, nothing else is guessed
+    size_t next = current ? (size_t) (current - entries.data()) + 1 : 0;
+    Entry &entry = entries[next % entries.size()];
+
+    if (!entry.scene && !entry.disposed) {
+        Construct(entry);
+    }
+}
+
+void SceneRegistry::EnforceMemoryBudget() {
+    if (GetHeapBytesCurrent() <= memory_budget) {
+        return;
+    }
+
+    // least recently shown scenes go first
+    std::vector<Entry *> inactive;
+    for (auto &entry : entries) {
+        if (&entry != current && entry.scene) {
+            inactive.push_back(&entry);
+        }
+    }
+    std::sort(inactive.begin(), inactive.end(), [](const Entry *a, const Entry *b) {
+        return a->last_active_frame < b->last_active_frame;
+    });
+
+    // once over the budget, memory is freed down to the low watermark
+    size_t target = LowWatermark();
+
+    for (Entry *entry : inactive) {
+        if (GetHeapBytesCurrent() <= target) {
+            return;
+        }
+        if (!entry->heavy_state_released) {
+            entry->scene->ReleaseHeavyState();
+            entry->heavy_state_released = true;
+
+            TraceLog(LOG_INFO, "SceneRegistry: released heavy state of '%s'", entry->name);
+        }
+    }
+
+    for (Entry *entry : inactive) {
+        if (GetHeapBytesCurrent() <= target) {
+            return;
+        }
+        if (entry->disposable) {
+            entry->scene.reset();
+            entry->disposed = true;
+
+            TraceLog(LOG_INFO, "SceneRegistry: destroyed '%s'", entry->name);
+        }
+    }
+}
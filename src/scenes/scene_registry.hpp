@@ -0,0 +1,88 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+#include "scenes/scene.hpp"
+#include "profiling/frame_recorder.hpp"
+
+// scenes by the keys that switch to them
+// a scene is constructed when it is activated for the first time, the one after the current scene is preloaded
+// when a frame has time to spare before its swap
+// inactive scenes release their heavy state, and disposable ones are destroyed, when the heap grows over the budget,
+// until the heap is back under the low watermark
+struct SceneRegistry {
+    using Factory = std::function<std::unique_ptr<Scene>()>;
+
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 512 << 20;
+    // share of the budget memory is freed down to, and preloading stops at,
+    // so scenes are not released and preloaded again every other frame
+    static constexpr double LOW_WATERMARK = 0.75;
+    // frame must have this much time left before its deadline to preload a scene
+    static constexpr double PRELOAD_MIN_IDLE = 0.004;
+
+    struct Entry {
+        int key;
+        const char *name;
+        Factory factory;
+        bool show_cursor = true;
+        bool disposable  = false; // scene has no state worth keeping, it may be destroyed and constructed again
+
+        std::unique_ptr<Scene> scene;
+        FrameRecorder frame_recorder;
+
+        size_t constructions      = 0;
+        double construction_time  = 0; // seconds, of the last construction
+        size_t construction_bytes = 0; // heap growth during the last construction
+        bool heavy_state_released = false;
+        bool disposed             = false; // destroyed to fit the budget, it is not preloaded again
+        size_t last_active_frame  = 0;
+
+        Entry(int key, const char *name, Factory factory, bool show_cursor, bool disposable);
+    };
+
+    size_t memory_budget = DEFAULT_MEMORY_BUDGET;
+    bool preload = true;
+
+    void Register(int key, const char *name, Factory factory, bool show_cursor=true, bool disposable=false);
+
+    template <typename SceneType>
+    void Register(int key, const char *name, bool show_cursor=true, bool disposable=false) {
+        Register(key, name, [] { return std::make_unique<SceneType>(); }, show_cursor, disposable);
+    }
+
+    // make the scene with the key current, false if there is no such scene
+    bool Activate(int key);
+    // no scene is current
+    void Deactivate();
+
+    Entry *Current() {
+        return current;
+    }
+    const Entry *Current() const {
+        return current;
+    }
+    Scene *CurrentScene() {
+        return current ? current->scene.get() : nullptr;
+    }
+
+    // called once a frame before the swap, idle_time is how long the frame can still take before its deadline
+    void Maintain(double idle_time);
+
+    const std::vector<Entry> &Entries() const {
+        return entries;
+    }
+
+private:
+    std::vector<Entry> entries;
+    Entry *current = nullptr;
+    size_t frame = 0;
+
+    Entry *Find(int key);
+    void Construct(Entry &entry);
+    size_t LowWatermark() const;
+    void PreloadNext();
+    void EnforceMemoryBudget();
+};